@@ -18,7 +18,10 @@ enum class display_type
 
 //==========================================
 // set here your display type
+// (can be overridden by a build flag)
+#ifndef DISPLAY_TYPE
 #define DISPLAY_TYPE display_type::undefined
+#endif
 //==========================================
 
 // generates compile time error if display type not set
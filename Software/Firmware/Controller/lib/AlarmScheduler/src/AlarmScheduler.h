@@ -0,0 +1,457 @@
+// AlarmScheduler.h
+
+// daily and weekday alarms, the table is kept in NVS, the next time
+// of every alarm is kept in a min-heap, the main loop compares the
+// current second with the root only, an alarm that went off is
+// scheduled again, the local times go through the rules of the
+// Timezone, an alarm in the hour skipped by DST goes off that much
+// later, an alarm in the hour repeated goes off once
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <TimeLib.h>
+#include <Timezone.h> // https://github.com/JChristensen/Timezone
+
+#define ALARM_NAMESPACE "Alarms"
+#define ALARM_KEY "table"
+#define ALARM_VERSION 1
+
+// one alarm per digit of the slot input
+#define ALARM_COUNT 10
+#define ALARM_NONE 0xFF
+// the snooze is kept in the heap with this slot
+#define ALARM_SNOOZE 0xFE
+#define ALARM_SNOOZE_TIME 300 // s
+// alarms missed by more than this, when the time was set forward,
+// are scheduled again without going off
+#define ALARM_MISSED_TIME 60 // s
+// no alarm scheduled
+#define ALARM_NEVER ((time_t)INT32_MAX)
+
+// days of an alarm, bit 0 is Sunday like weekday() - 1, 0 is off
+#define ALARM_DAYS_OFF 0x00
+#define ALARM_DAYS_DAILY 0x7F
+#define ALARM_DAYS_WORKDAYS 0x3E
+
+// 3 bytes per alarm
+typedef struct
+{
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t days;
+} ALARM;
+
+typedef struct
+{
+  uint8_t version;
+  uint8_t count;
+  ALARM alarms[ALARM_COUNT];
+} ALARM_TABLE;
+
+typedef struct
+{
+  time_t utc;
+  uint8_t slot;
+} ALARM_DEADLINE;
+
+class AlarmScheduler
+{
+public:
+  AlarmScheduler()
+      : _timeZone(nullptr),
+        _dstRule{},
+        _stdRule{},
+        _dstOffset(0),
+        _stdOffset(0),
+        _heapCount(0),
+        _next(0),
+        _rebuild(true),
+        _fired(0),
+        _lastFired(0)
+  {
+    memset(_alarms, 0, sizeof(_alarms));
+  }
+
+  // the alarms as saved, all off if there is nothing valid
+  bool begin()
+  {
+    ALARM_TABLE table;
+
+    if (!_preferences.begin(ALARM_NAMESPACE, false))
+    {
+      return (false);
+    }
+    if ((_preferences.getBytes(ALARM_KEY, &table, sizeof(table)) == sizeof(table)) &&
+        (table.version == ALARM_VERSION) && (table.count == ALARM_COUNT))
+    {
+      memcpy(_alarms, table.alarms, sizeof(_alarms));
+    }
+    reschedule();
+    return (true);
+  }
+
+  // call it every time the rules of the time zone are set,
+  // the alarms are only scheduled again if the rules changed
+  void setTimeZone(Timezone *timeZone, const TimeChangeRule &dstRule, const TimeChangeRule &stdRule)
+  {
+    if ((timeZone == _timeZone) && isSameRule(dstRule, _dstRule) && isSameRule(stdRule, _stdRule))
+    {
+      return;
+    }
+    _timeZone = timeZone;
+    _dstRule = dstRule;
+    _stdRule = stdRule;
+    _dstOffset = dstRule.offset * SECS_PER_MIN;
+    _stdOffset = stdRule.offset * SECS_PER_MIN;
+    reschedule();
+  }
+
+  // the heap is built again from the time of the next process(),
+  // when the alarms, the time zone or the time were changed,
+  // a pending snooze stays, it is kept in UTC
+  void reschedule()
+  {
+    _rebuild = true;
+    _next = 0;
+  }
+
+  // the UTC second the next alarm goes off, the loop only calls
+  // process() when it is reached
+  time_t getNextDeadline()
+  {
+    return (_next);
+  }
+
+  // returns the slot of the alarm that went off, ALARM_SNOOZE or ALARM_NONE,
+  // alarms going off at the same time are shown as one
+  uint8_t process(time_t utc)
+  {
+    uint8_t fired = ALARM_NONE;
+
+    if (_rebuild)
+    {
+      // an alarm in this second still goes off
+      build(utc - 1);
+    }
+    while (_heapCount && (_heap[0].utc <= utc))
+    {
+      ALARM_DEADLINE deadline = _heap[0];
+      if (utc - deadline.utc <= ALARM_MISSED_TIME)
+      {
+        fired = deadline.slot;
+      }
+      if (deadline.slot == ALARM_SNOOZE)
+      {
+        pop();
+      }
+      else
+      {
+        // the same alarm on its next day
+        _heap[0].utc = getNextTime(_alarms[deadline.slot], utc);
+        siftDown(0);
+      }
+    }
+    if (fired != ALARM_NONE)
+    {
+      _fired++;
+      _lastFired = utc;
+    }
+    updateNext();
+    return (fired);
+  }
+
+  // the alarm goes off again after the snooze time
+  void snooze(time_t utc)
+  {
+    removeSnooze();
+    push(utc + ALARM_SNOOZE_TIME, ALARM_SNOOZE);
+    if (!_rebuild)
+    {
+      updateNext();
+    }
+  }
+
+  // hour and minute in local time, days as the ALARM_DAYS bits,
+  // the table is written to NVS
+  bool setAlarm(uint8_t slot, uint8_t hour, uint8_t minute, uint8_t days)
+  {
+    if ((slot >= ALARM_COUNT) || (hour > 23) || (minute > 59))
+    {
+      return (false);
+    }
+    _alarms[slot].hour = hour;
+    _alarms[slot].minute = minute;
+    _alarms[slot].days = days & ALARM_DAYS_DAILY;
+    save();
+    reschedule();
+    return (true);
+  }
+
+  // alarms and snoozes that went off since power on
+  uint32_t getFired()
+  {
+    return (_fired);
+  }
+
+  const ALARM *getAlarm(uint8_t slot)
+  {
+    return ((slot < ALARM_COUNT) ? &_alarms[slot] : nullptr);
+  }
+
+  void dump(Print &out)
+  {
+    static const char *dayNames[] = {"Su", "Mo", "Tu", "We", "Th", "Fr", "Sa"};
+
+    out.printf("alarms, %u went off\r\n", _fired);
+    for (uint8_t i = 0; i < ALARM_COUNT; i++)
+    {
+      if (_alarms[i].days != ALARM_DAYS_OFF)
+      {
+        out.printf("%u: %02u:%02u", i, _alarms[i].hour, _alarms[i].minute);
+        for (uint8_t day = 0; day < 7; day++)
+        {
+          if (_alarms[i].days & (1 << day))
+          {
+            out.printf(" %s", dayNames[day]);
+          }
+        }
+        out.printf("\r\n");
+      }
+    }
+    if (_lastFired)
+    {
+      printTime(out, "last", _lastFired);
+    }
+    if (_rebuild)
+    {
+      out.printf("scheduled on the next second\r\n");
+      return;
+    }
+    // in heap order, the root first
+    for (uint8_t i = 0; i < _heapCount; i++)
+    {
+      char name[12];
+      if (_heap[i].slot == ALARM_SNOOZE)
+      {
+        strcpy(name, "snooze");
+      }
+      else
+      {
+        sprintf(name, "next %u", _heap[i].slot);
+      }
+      printTime(out, name, _heap[i].utc);
+    }
+  }
+
+private:
+  Preferences _preferences;
+  ALARM _alarms[ALARM_COUNT];
+  Timezone *_timeZone;
+  TimeChangeRule _dstRule;
+  TimeChangeRule _stdRule;
+  time_t _dstOffset;
+  time_t _stdOffset;
+  // one deadline per alarm that is on, and the snooze
+  ALARM_DEADLINE _heap[ALARM_COUNT + 1];
+  uint8_t _heapCount;
+  time_t _next;
+  bool _rebuild;
+  uint32_t _fired;
+  time_t _lastFired;
+
+  void save()
+  {
+    ALARM_TABLE table;
+    table.version = ALARM_VERSION;
+    table.count = ALARM_COUNT;
+    memcpy(table.alarms, _alarms, sizeof(_alarms));
+    _preferences.putBytes(ALARM_KEY, &table, sizeof(table));
+  }
+
+  // the alarms go off after utc, the snooze when it was due
+  void build(time_t utc)
+  {
+    time_t snoozeTime = ALARM_NEVER;
+    for (uint8_t i = 0; i < _heapCount; i++)
+    {
+      if (_heap[i].slot == ALARM_SNOOZE)
+      {
+        snoozeTime = _heap[i].utc;
+      }
+    }
+    _rebuild = false;
+    _heapCount = 0;
+    for (uint8_t i = 0; i < ALARM_COUNT; i++)
+    {
+      if (_alarms[i].days != ALARM_DAYS_OFF)
+      {
+        push(getNextTime(_alarms[i], utc), i);
+      }
+    }
+    if (snoozeTime != ALARM_NEVER)
+    {
+      push(snoozeTime, ALARM_SNOOZE);
+    }
+    updateNext();
+  }
+
+  // the abbreviation doesn't change the times
+  static bool isSameRule(const TimeChangeRule &a, const TimeChangeRule &b)
+  {
+    return ((a.week == b.week) && (a.dow == b.dow) && (a.month == b.month) &&
+            (a.hour == b.hour) && (a.offset == b.offset));
+  }
+
+  void updateNext()
+  {
+    _next = _heapCount ? _heap[0].utc : ALARM_NEVER;
+  }
+
+  // the first time after utc the alarm goes off, in UTC
+  time_t getNextTime(const ALARM &alarm, time_t utc)
+  {
+    time_t local = toLocal(utc);
+    time_t day = local - (local % SECS_PER_DAY);
+
+    // today and the 7 days after it
+    for (uint8_t i = 0; i < 8; i++, day += SECS_PER_DAY)
+    {
+      if (alarm.days & (1 << (weekday(day) - 1)))
+      {
+        time_t next = toUTC(day + alarm.hour * SECS_PER_HOUR + alarm.minute * SECS_PER_MIN);
+        if (next > utc)
+        {
+          return (next);
+        }
+      }
+    }
+    return (ALARM_NEVER);
+  }
+
+  time_t toLocal(time_t utc)
+  {
+    return (_timeZone ? _timeZone->toLocal(utc) : utc);
+  }
+
+  // a local time maps to one UTC time, to two in the hour repeated
+  // when DST ends, the first one is taken, to none in the hour skipped
+  // when DST starts, the time moves forward by the change then
+  time_t toUTC(time_t local)
+  {
+    time_t dst = local - _dstOffset;
+    time_t std = local - _stdOffset;
+    bool dstValid = (toLocal(dst) == local);
+    bool stdValid = (toLocal(std) == local);
+
+    if (dstValid && stdValid)
+    {
+      return (min(dst, std));
+    }
+    if (dstValid)
+    {
+      return (dst);
+    }
+    if (stdValid)
+    {
+      return (std);
+    }
+    return (max(dst, std));
+  }
+
+  void push(time_t utc, uint8_t slot)
+  {
+    if (_heapCount < ALARM_COUNT + 1)
+    {
+      _heap[_heapCount].utc = utc;
+      _heap[_heapCount].slot = slot;
+      siftUp(_heapCount);
+      _heapCount++;
+    }
+  }
+
+  void pop()
+  {
+    removeAt(0);
+  }
+
+  void removeAt(uint8_t index)
+  {
+    _heapCount--;
+    if (index < _heapCount)
+    {
+      _heap[index] = _heap[_heapCount];
+      siftDown(index);
+      siftUp(index);
+    }
+  }
+
+  void removeSnooze()
+  {
+    for (uint8_t i = 0; i < _heapCount; i++)
+    {
+      if (_heap[i].slot == ALARM_SNOOZE)
+      {
+        removeAt(i);
+        return;
+      }
+    }
+  }
+
+  void siftUp(uint8_t index)
+  {
+    while (index > 0)
+    {
+      uint8_t parent = (index - 1) / 2;
+      if (_heap[parent].utc <= _heap[index].utc)
+      {
+        break;
+      }
+      swap(index, parent);
+      index = parent;
+    }
+  }
+
+  void siftDown(uint8_t index)
+  {
+    while (true)
+    {
+      uint8_t smallest = index;
+      uint8_t left = 2 * index + 1;
+      uint8_t right = left + 1;
+      if ((left < _heapCount) && (_heap[left].utc < _heap[smallest].utc))
+      {
+        smallest = left;
+      }
+      if ((right < _heapCount) && (_heap[right].utc < _heap[smallest].utc))
+      {
+        smallest = right;
+      }
+      if (smallest == index)
+      {
+        break;
+      }
+      swap(index, smallest);
+      index = smallest;
+    }
+  }
+
+  void swap(uint8_t a, uint8_t b)
+  {
+    ALARM_DEADLINE temp = _heap[a];
+    _heap[a] = _heap[b];
+    _heap[b] = temp;
+  }
+
+  void printTime(Print &out, const char *name, time_t utc)
+  {
+    TimeElements tm;
+    breakTime(toLocal(utc), tm);
+    out.printf("%s: %04d-%02u-%02u %02u:%02u:%02u local, %lld utc\r\n", name, tmYearToCalendar(tm.Year),
+               tm.Month, tm.Day, tm.Hour, tm.Minute, tm.Second, (long long)utc);
+  }
+};
@@ -9,20 +9,37 @@
 
 #include <Arduino.h>
 #include <NixieCalc.h>
+#include <ProgrammerCalc.h>
+#include <CalcHistory.h>
+#include <MemoryBank.h>
 #include <KeyboardHandler.h>
 #include <KeyboardDecoder.h>
+#include <DisplayDriver.h>
+#include <NumberFormatter.h>
+
+// display buffer: sign, all digits, decimal points and terminator,
+// the error display lights all decimal points
+#define CALC_DISPLAY_SIZE (DisplayHALSelector<DISPLAY_TYPE>::HAL::digitCount + \
+                           DisplayHALSelector<DISPLAY_TYPE>::HAL::decimalPointCount + 2)
 
 class Calculator
 {
 public:
-  Calculator(Settings *settings)
-      : _settings(settings)
+  // the history storage survives resets if it is in RTC memory
+  Calculator(Settings *settings, CALC_HISTORY_DATA *historyData)
+      : _settings(settings),
+        _history(historyData)
   {
-    _display = "0";
-    _error.clear();
+    setDisplay("0");
     _calcEngine.setAngleMode(angle_mode::deg);
+    _calcEngine.setHistory(&_history);
     _inputPending = false;
     _hasPlusSign = false;
+    _historyAge = -1;
+    _memoryOperation = operation::none;
+    _programmerMode = false;
+    _programmerInput = 0;
+    _programmerWindow = 0;
   }
 
   virtual ~Calculator()
@@ -31,34 +48,110 @@ public:
 
   void begin(uint8_t digitCount, uint8_t decimalPointCount, bool hasPlusSign)
   {
-    setParameters();
     _digitCount = digitCount;
     _decimalPointCount = decimalPointCount;
     _hasPlusSign = hasPlusSign;
-    for (int i = 0; i < _decimalPointCount; i++)
+    _history.begin();
+    if (_memoryBank.begin())
+    {
+      CALCNUMBER registers[MEMORY_REGISTERS];
+      if (_memoryBank.load(registers))
+      {
+        _calcEngine.setMemory(registers);
+      }
+    }
+    setParameters();
+  }
+
+  // periodic work outside of the keystroke path
+  void process()
+  {
+    if (_memoryBank.isDue())
     {
-      _error += '.';
+      flushMemory();
     }
   }
 
+  // writes changed memory registers to flash now
+  void flushMemory()
+  {
+    CALCNUMBER registers[MEMORY_REGISTERS];
+    _calcEngine.getMemory(registers);
+    _memoryBank.flush(registers);
+  }
+
+  // entry mode from the settings, a change starts with a cleared calculator
   void setParameters()
   {
+    int entryMode = entry_mode::algebraic;
+    _settings->getSetting(setting_id::entrymode, &entryMode);
+    calc_mode calcMode = (entryMode == entry_mode::algebraic) ? calc_mode::algebraic : calc_mode::rpn;
+    uint8_t stackLevels = (entryMode == entry_mode::rpn8) ? RPN_MAX_LEVELS : RPN_DEFAULT_LEVELS;
+    if ((calcMode != _calcEngine.getCalcMode()) || (stackLevels != _calcEngine.getStackLevels()))
+    {
+      _calcEngine.setCalcMode(calcMode, stackLevels);
+      if (!_programmerMode)
+      {
+        _inputPending = false;
+        showResult();
+      }
+    }
   }
 
-  String getDisplay()
+  const char *getDisplay()
   {
     return (_display);
   }
 
+  uint8_t getDisplayLength()
+  {
+    return (_displayLength);
+  }
+
+  // the calculation tape as CSV
+  void dumpHistory(Print &out)
+  {
+    _history.dump(out);
+  }
+
   void onKeyboardEvent(uint8_t keyCode, key_state keyState, bool functionKeyPressed)
   {
     operation op;
     uint8_t digit;
     key_function_type function;
 
-    if (keyState == key_state::pressed)
+    if ((keyState == key_state::pressed) && _programmerMode)
+    {
+      KeyboardDecoder::decodeProgrammer(keyCode, functionKeyPressed, &function, &op, &digit);
+      onProgrammerKey(function, op, digit);
+    }
+    else if (keyState == key_state::pressed)
     {
-      KeyboardDecoder::decode(keyCode, functionKeyPressed, &function, &op, &digit);
+      KeyboardDecoder::decode(keyCode, functionKeyPressed, &function, &op, &digit, _calcEngine.getCalcMode() == calc_mode::rpn);
+
+      if ((function != key_function_type::unknown) && (function != key_function_type::historyback) &&
+          (function != key_function_type::historyforward) && (_historyAge >= 0))
+      {
+        // a recalled result is an input, new digits replace it
+        _historyAge = -1;
+        if ((function == key_function_type::numeric) || (function == key_function_type::numericx2) ||
+            (function == key_function_type::dp))
+        {
+          _inputPending = false;
+        }
+      }
+
+      if ((_memoryOperation != operation::none) && (function != key_function_type::unknown))
+      {
+        // the digit after F and a memory key is the register
+        operation memoryOperation = _memoryOperation;
+        _memoryOperation = operation::none;
+        if ((function == key_function_type::numeric) || (function == key_function_type::numericx2))
+        {
+          memoryInput(memoryOperation, digit);
+          return;
+        }
+      }
 
       switch (function)
       {
@@ -71,6 +164,10 @@ public:
         numericInput(digit);
         break;
 
+      case key_function_type::memoryselect:
+        _memoryOperation = op;
+        break;
+
       case key_function_type::dp:
         decimalPointInput();
         break;
@@ -79,60 +176,40 @@ public:
         operationInput(op);
         break;
 
-      default:
+      case key_function_type::historyback:
+        recallHistory(1);
         break;
-      }
-    }
-  }
 
-  // special floating number format routine
-  String doubleToString(double number)
-  {
-    String s;
-    char buffer[100];
+      case key_function_type::historyforward:
+        recallHistory(-1);
+        break;
 
-    // stupid thing, but avoids displaying negative zero
-    if (number == 0)
-    {
-      number = 0;
-    }
-    // format with maximum number of decimals
-    sprintf(buffer, "%-.*f", _digitCount, number);
-    s = buffer;
-    // get number of digits before the decimal point
-    int index = s.indexOf('.');
-    if (number < 0)
-    {
-      index--;
-    }
-    // get number of decimals to display
-    int decimals = _digitCount - index;
-    // format again with the correct mumber of decimals
-    sprintf(buffer, "%-.*f", decimals, number);
-    s = buffer;
-    index = s.indexOf('.');
+      case key_function_type::programmer:
+        setProgrammerMode(true);
+        break;
 
-    if (index != -1)
-    {
-      // remove trailing zeroes after decimal point
-      while (s[s.length() - 1] == '0')
-      {
-        s.remove(s.length() - 1);
-      }
-      // remove decimal point if no decimals left
-      if (s[s.length() - 1] == '.')
-      {
-        s.remove(s.length() - 1);
+      default:
+        break;
       }
     }
-    return (s);
   }
 
 private:
-  String _display;
-  String _error;
+  char _display[CALC_DISPLAY_SIZE];
+  uint8_t _displayLength;
   NixieCalc _calcEngine;
   Settings *_settings;
+  CalcHistory _history;
+  // age of the recalled entry, -1 if none is shown
+  int _historyAge;
+  MemoryBank _memoryBank;
+  // memory operation waiting for its register digit
+  operation _memoryOperation;
+  // programmer mode has its own engine, the calculator keeps its state
+  ProgrammerCalc _programmerEngine;
+  bool _programmerMode;
+  uint64_t _programmerInput;
+  uint8_t _programmerWindow;
   uint8_t _digitCount;
   uint8_t _decimalPointCount;
   bool _inputPending;
@@ -145,18 +222,19 @@ private:
     {
       if (!_inputPending)
       {
-        _display.clear();
+        setDisplay("");
         _inputPending = true;
       }
-      if (_display.equals("0"))
+      if (strcmp(_display, "0") == 0)
       {
-        _display = (char)(digit + 48);
+        _displayLength = 0;
+        appendDisplay((char)(digit + 48));
       }
       else
       {
         if (getUsedDigits() < _digitCount)
         {
-          _display += (char)(digit + 48);
+          appendDisplay((char)(digit + 48));
         }
       }
     }
@@ -170,14 +248,14 @@ private:
 
       if (_inputPending)
       {
-        if (_display.indexOf('.') == -1)
+        if (strchr(_display, '.') == nullptr)
         {
-          _display += '.';
+          appendDisplay('.');
         }
       }
       else
       {
-        _display = "0.";
+        setDisplay("0.");
       }
       _inputPending = true;
     }
@@ -192,38 +270,47 @@ private:
       {
       case operation::memclear:
         _calcEngine.onOperation(op);
+        _memoryBank.onChange();
         break;
 
       case operation::memstore:
       case operation::memsubtraction:
       case operation::memaddition:
-        _calcEngine.onNumericInput(_display.toDouble());
+        // in RPN a shown result is already X, entering it again would push it
+        if (_inputPending || (_calcEngine.getCalcMode() == calc_mode::algebraic))
+        {
+          _calcEngine.onNumericInput(_display);
+        }
         _calcEngine.onOperation(op);
+        _memoryBank.onChange();
+        if (_calcEngine.getOperationReturnCode() != operation_return_code::success)
+        {
+          // M+ or M- beyond the range
+          setError();
+        }
         break;
 
       default:
         if (_inputPending)
         {
-          _calcEngine.onNumericInput(_display.toDouble());
+          _calcEngine.onNumericInput(_display);
         }
         _calcEngine.onOperation(op);
         if (_calcEngine.getOperationReturnCode() == operation_return_code::success)
         {
-          _display = doubleToString(_calcEngine.getDisplayValue());
-          if (_hasPlusSign)
+          if (_hasPlusSign && (op == operation::switchsign) && (_calcEngine.getDisplayNumber() > 0))
           {
-            if (op == operation::switchsign)
-            {
-              if (_calcEngine.getDisplayValue() > 0)
-              {
-                _display = "+" + _display;
-              }
-            }
+            _display[0] = '+';
+            _displayLength = NumberFormatter::format(_calcEngine.getDisplayNumber(), _digitCount, _display + 1, sizeof(_display) - 1) + 1;
+          }
+          else
+          {
+            showResult();
           }
         }
         else
         {
-          _display = _error;
+          setError();
         }
       }
     }
@@ -233,23 +320,216 @@ private:
       if (op == operation::allclear)
       {
         _calcEngine.onOperation(op);
-        _display = doubleToString(_calcEngine.getDisplayValue());
+        showResult();
+      }
+    }
+    _inputPending = false;
+  }
+
+  // memory operation on register 0 to 9
+  void memoryInput(operation op, uint8_t memoryRegister)
+  {
+    if (_calcEngine.getOperationReturnCode() == operation_return_code::success)
+    {
+      if ((op != operation::memclear) && (op != operation::memread) &&
+          (_inputPending || (_calcEngine.getCalcMode() == calc_mode::algebraic)))
+      {
+        _calcEngine.onNumericInput(_display);
+      }
+      _calcEngine.onMemoryOperation(op, memoryRegister);
+      if (op == operation::memread)
+      {
+        showResult();
+      }
+      else
+      {
+        _memoryBank.onChange();
+      }
+      _inputPending = false;
+    }
+  }
+
+  // shows the result of an older (step 1) or newer (step -1) calculation
+  // as input for the next operation, stepping past the latest one
+  // returns to the current display value
+  void recallHistory(int step)
+  {
+    if (_calcEngine.getOperationReturnCode() == operation_return_code::success)
+    {
+      int age = _history.findCalculation(_historyAge, step);
+      if (age >= 0)
+      {
+        _historyAge = age;
+        _displayLength = NumberFormatter::format(CalcHistory::unpack(_history.getEntry(age)->result), _digitCount, _display, sizeof(_display));
+        _inputPending = true;
+      }
+      else if (step < 0)
+      {
+        _historyAge = -1;
+        _inputPending = false;
+        showResult();
+      }
+    }
+  }
+
+  // switching keeps the state of both engines,
+  // a number being typed goes to its engine first
+  void setProgrammerMode(bool programmerMode)
+  {
+    if (_inputPending)
+    {
+      if (_programmerMode)
+      {
+        _programmerEngine.onNumericInput(_programmerInput);
+      }
+      else
+      {
+        _calcEngine.onNumericInput(_display);
       }
     }
+    _programmerMode = programmerMode;
     _inputPending = false;
+    _historyAge = -1;
+    _memoryOperation = operation::none;
+    if (_programmerMode)
+    {
+      showProgrammerResult();
+    }
+    else if (_calcEngine.getOperationReturnCode() == operation_return_code::success)
+    {
+      showResult();
+    }
+    else
+    {
+      setError();
+    }
+  }
+
+  void onProgrammerKey(key_function_type function, operation op, uint8_t digit)
+  {
+    switch (function)
+    {
+    case key_function_type::numeric:
+    case key_function_type::numericx2:
+      if (_programmerEngine.getOperationReturnCode() == operation_return_code::success)
+      {
+        if (!_inputPending)
+        {
+          _programmerInput = 0;
+          _inputPending = true;
+        }
+        // digits that don't fit or are not valid in the base are ignored
+        ProgrammerCalc::appendDigit(&_programmerInput, digit, _programmerEngine.getBase());
+        if (function == key_function_type::numericx2)
+        {
+          ProgrammerCalc::appendDigit(&_programmerInput, digit, _programmerEngine.getBase());
+        }
+        _programmerWindow = 0;
+        showProgrammer(_programmerInput);
+      }
+      break;
+
+    case key_function_type::operation:
+      if (_inputPending)
+      {
+        _programmerEngine.onNumericInput(_programmerInput);
+        _inputPending = false;
+      }
+      _programmerEngine.onOperation(op);
+      _programmerWindow = 0;
+      showProgrammerResult();
+      break;
+
+    case key_function_type::numberbase:
+      _programmerEngine.setBase((number_base)digit);
+      _programmerWindow = 0;
+      showProgrammer(_inputPending ? _programmerInput : _programmerEngine.getDisplayValue());
+      break;
+
+    case key_function_type::window:
+    {
+      uint64_t value = _inputPending ? _programmerInput : _programmerEngine.getDisplayValue();
+      if (_programmerEngine.getOperationReturnCode() == operation_return_code::success)
+      {
+        _programmerWindow++;
+        if (_programmerWindow >= ProgrammerCalc::getWindowCount(value, _programmerEngine.getBase(), _digitCount))
+        {
+          _programmerWindow = 0;
+        }
+        showProgrammer(value);
+      }
+      break;
+    }
+
+    case key_function_type::programmer:
+      setProgrammerMode(false);
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  void showProgrammerResult()
+  {
+    if (_programmerEngine.getOperationReturnCode() == operation_return_code::success)
+    {
+      showProgrammer(_programmerEngine.getDisplayValue());
+    }
+    else
+    {
+      setError();
+    }
+  }
+
+  void showProgrammer(uint64_t value)
+  {
+    _displayLength = ProgrammerCalc::format(value, _programmerEngine.getBase(), _digitCount, _programmerWindow, _display, sizeof(_display));
   }
 
   uint8_t getUsedDigits()
   {
-    uint8_t result = _display.length();
-    if (_display.indexOf('-') != (-1))
+    uint8_t result = _displayLength;
+    if (strchr(_display, '-') != nullptr)
     {
       result--;
     }
-    if (_display.indexOf('.') != (-1))
+    if (strchr(_display, '.') != nullptr)
     {
       result--;
     }
     return result;
   }
+
+  void setDisplay(const char *s)
+  {
+    _displayLength = strlen(s);
+    memcpy(_display, s, _displayLength + 1);
+  }
+
+  void appendDisplay(char c)
+  {
+    if (_displayLength < sizeof(_display) - 1)
+    {
+      _display[_displayLength++] = c;
+      _display[_displayLength] = 0;
+    }
+  }
+
+  void showResult()
+  {
+    _displayLength = NumberFormatter::format(_calcEngine.getDisplayNumber(), _digitCount, _display, sizeof(_display));
+    if (_displayLength == 0)
+    {
+      setError();
+    }
+  }
+
+  // lights all decimal points
+  void setError()
+  {
+    memset(_display, '.', _decimalPointCount);
+    _displayLength = _decimalPointCount;
+    _display[_displayLength] = 0;
+  }
 };
@@ -8,32 +8,40 @@
 #pragma once
 
 #include <Arduino.h>
-#include <SoftwareSerial.h>
 #include <Timezone.h>  // https://github.com/JChristensen/Timezone
+#include <TimeZoneCache.h>
 #include <DS3232RTC.h> // https://github.com/JChristensen/DS3232RTC
 #include <DisplayHandler.h>
 #include <Settings.h>
 #include <KeyboardHandler.h>
 #include <KeyboardDecoder.h>
+#include <Events.h>
+#include <TimeDiscipline.h>
+#include <Stopwatch.h>
+#include <CountdownTimer.h>
+#include <AlarmScheduler.h>
 
 #define MAX_TIMER_INPUT 8
+// slot, hour, minute and the days of an alarm
+#define MAX_ALARM_INPUT 6
+
+// the clock renders once per second on the falling edge of the RTC's
+// 1 Hz square wave, without it, it polls the system time
+#define CLOCK_UPDATE_INTERVAL 20
+#define CLOCK_INPUT_BLINK_INTERVAL 250
+#define CLOCK_STOPWATCH_UPDATE_INTERVAL 10
+// a lap taken while running is shown this long
+#define CLOCK_LAP_SHOW_TIME 3000
+// ms without an edge until the square wave counts as missing
+#define CLOCK_SQW_TIMEOUT 1500
+// seconds counted from the square wave before the RTC is read again
+#define CLOCK_RTC_RESYNC 3600
+// a step waits in the loop for the last us before the GPS second,
+// if the loop comes too late it waits for the next one
+#define CLOCK_STEP_SPIN 3000 // us
+#define CLOCK_STEP_LATE 5000 // us
 #define MAX_TIMER_INTERVAL (99 * 86400) + (23 * 3600) + (59 * 60) + 59
 
-enum class stopwatch_mode : uint8_t
-{
-  zero,
-  stopped,
-  running
-};
-
-enum class timer_mode : uint8_t
-{
-  zero,
-  set,
-  stopped,
-  running
-};
-
 enum class year_type : uint8_t
 {
   none,
@@ -45,7 +53,8 @@ enum class input_mode : uint8_t
 {
   none,
   time,
-  timer
+  timer,
+  alarm
 };
 
 class Clock
@@ -56,11 +65,25 @@ public:
         _displayHandler(displayHandler)
   {
     _timeZone = new Timezone(_dstRule, _stdRule);
-    _stopwatchMode = stopwatch_mode::zero;
-    _timerMode = timer_mode::zero;
+    _zoneCache.setTimeZone(_timeZone, _dstRule, _stdRule);
     _inputMode = input_mode::none;
-    _setMillis = 0;
-    _timerMode = timer_mode::zero;
+    _shownLap = 0;
+    _showSplit = false;
+    _lapMillis = 0;
+    _shownAlarm = ALARM_NONE;
+    _secondPending = false;
+    _utc = 0;
+    _handledSeconds = 0;
+    _secondsSinceSync = 0;
+    _squareWaveMillis = 0;
+    _squareWaveActive = false;
+    _resync = true;
+    _renderPending = true;
+    _showInput = true;
+    _blinkMillis = 0;
+    _stepPending = false;
+    _stepUTC = 0;
+    _stepMicros = 0;
   }
 
   virtual ~Clock()
@@ -68,12 +91,65 @@ public:
     delete (_timeZone);
   }
 
-  void begin()
+  // pinSQW gets the INT/SQW output of the RTC
+  void begin(uint8_t pinSQW)
   {
     setSettings();
     _rtc.begin();
     // sync time with RTC
     setSyncProvider(_rtc.get);
+    // the output is open drain, low in the first half of a second
+    _rtc.squareWave(DS3232RTC::SQWAVE_1_HZ);
+    pinMode(pinSQW, INPUT_PULLUP);
+    attachInterrupt(pinSQW, onSquareWave, FALLING);
+    // the aging offset trimmed by GPS is kept by the RTC
+    _discipline.setAging((int8_t)_rtc.readRTC(DS3232_AGING_REGISTER));
+    _countdown.begin();
+    _alarms.begin();
+  }
+
+  // called from the main loop when the timer is over, in every device mode
+  void attachTimer(void *obj, CountdownTimer::notifyCallBack callBack)
+  {
+    _countdown.attach(obj, callBack);
+  }
+
+  // counts the seconds in every device mode, one compare per second
+  // until the next alarm is due, returns true if an alarm goes off
+  bool processAlarms()
+  {
+    if (updateTime())
+    {
+      // for the next process() in clock mode
+      _secondPending = true;
+    }
+    if (_utc < _alarms.getNextDeadline())
+    {
+      return (false);
+    }
+    return (_alarms.process(_utc) != ALARM_NONE);
+  }
+
+  // the alarm that went off goes off again in a few minutes
+  void snoozeAlarm()
+  {
+    _alarms.snooze(_utc);
+  }
+
+  void dumpAlarms(Print &out)
+  {
+    _alarms.dump(out);
+  }
+
+  // returns true if the timer just ran out
+  bool processTimer()
+  {
+    if (_countdown.process())
+    {
+      _renderPending = true;
+      return (true);
+    }
+    return (false);
   }
 
   void setSettings()
@@ -83,24 +159,92 @@ public:
     _settings->getSetting(setting_id::leadingzero, (int *)&_leadingZero);
     _settings->getSetting(setting_id::dateformat, (int *)&_dateFormat);
     setTimeZone();
+    _renderPending = true;
   }
 
+  // the display was changed by someone else, render on the next process()
+  void refresh()
+  {
+    _renderPending = true;
+  }
+
+  // renders a frame when a second starts or a sub-second state is due,
+  // returns true if the display buffer has a new frame to show
   bool process()
   {
-    static TimeElements tm;
+    bool newSecond = updateTime();
 
-    getCurrentTime(&tm);
+    if (_secondPending)
+    {
+      newSecond = true;
+      _secondPending = false;
+    }
+    // a running animation owns the display until it is done,
+    // it shows its frames itself, the clock takes over right after
+    if (_displayHandler->animate())
+    {
+      _renderPending = true;
+      return (false);
+    }
+    if (!newSecond && !_renderPending && !isSubSecondMode())
+    {
+      return (false);
+    }
+    if (_renderPending && !newSecond)
+    {
+      // settings or the time zone may have changed
+      breakTime(_zoneCache.toLocal(_utc), _localTime);
+    }
+    _renderPending = false;
     switch (_inputMode)
     {
     case input_mode::none:
-      displayTime(tm);
+      if (_shownAlarm != ALARM_NONE)
+      {
+        showAlarm(_shownAlarm);
+      }
+      else
+      {
+        displayTime(_localTime);
+      }
       break;
 
     default:
-      showInput(tm);
+      showInput();
       break;
     }
-    return (true);
+    // an animation started by this frame has shown itself already
+    return (!_displayHandler->isAnimating());
+  }
+
+  // ms until the clock needs to update the display again,
+  // the square wave wakes the loop for every second
+  uint32_t getTimeout()
+  {
+    if (_displayHandler->isAnimating())
+    {
+      return (_displayHandler->getAnimationTimeout());
+    }
+    if (_inputMode != input_mode::none)
+    {
+      unsigned long elapsed = millis() - _blinkMillis;
+      return ((elapsed < CLOCK_INPUT_BLINK_INTERVAL) ? CLOCK_INPUT_BLINK_INTERVAL - elapsed : 0);
+    }
+    if ((_clockMode == clock_mode::stopwatch) && (_stopwatch.getMode() == stopwatch_mode::running))
+    {
+      return (CLOCK_STOPWATCH_UPDATE_INTERVAL);
+    }
+    if ((_clockMode == clock_mode::timer) && (_countdown.getMode() == timer_mode::running))
+    {
+      // the shown second of the remaining time ends,
+      // the expiry wakes the loop by itself
+      return (((_countdown.getRemaining() % 1000000) / 1000) + 1);
+    }
+    if (_squareWaveActive)
+    {
+      return (EVENT_MAX_TIMEOUT);
+    }
+    return (CLOCK_UPDATE_INTERVAL);
   }
 
   void setTemperature(float temperature)
@@ -110,6 +254,96 @@ public:
   void setRTCTime(time_t utc)
   {
     _rtc.set(utc);
+    _utc = utc;
+    _resync = true;
+  }
+
+  // GPS time was utc at micros of the ESP32 timer, the offset of the RTC
+  // is measured at the last edge of the square wave, the RTC is slewed
+  // by its aging offset, or set at a GPS second if the offset is large,
+  // without the square wave it is set at every sync
+  void syncTime(time_t utc, int64_t micros)
+  {
+    time_t second;
+    int64_t edgeMicros;
+
+    if (getSecondStart(&second, &edgeMicros))
+    {
+      int64_t offset = (int64_t)(second - utc) * 1000000LL + (micros - edgeMicros);
+      switch (_discipline.addSample((int64_t)utc * 1000000LL, offset, micros))
+      {
+      case discipline_action::slew:
+        _rtc.writeRTC(DS3232_AGING_REGISTER, (uint8_t)_discipline.getAging());
+        break;
+
+      case discipline_action::step:
+        _rtc.writeRTC(DS3232_AGING_REGISTER, (uint8_t)_discipline.getAging());
+        scheduleStep(utc, micros);
+        break;
+
+      default:
+        break;
+      }
+    }
+    else
+    {
+      scheduleStep(utc, micros);
+    }
+  }
+
+  // sets the RTC when the GPS second of a pending step starts,
+  // call it from the main loop in every device mode
+  void processTimeSync()
+  {
+    if (_stepPending)
+    {
+      int64_t remaining = _stepMicros - esp_timer_get_time();
+      if (remaining < -CLOCK_STEP_LATE)
+      {
+        _stepUTC++;
+        _stepMicros += 1000000LL;
+      }
+      else if (remaining <= CLOCK_STEP_SPIN)
+      {
+        if (remaining > 0)
+        {
+          delayMicroseconds((uint32_t)remaining);
+        }
+        // writing the seconds restarts the countdown chain of the RTC
+        setRTCTime(_stepUTC);
+        setTime(_stepUTC);
+        _stepPending = false;
+      }
+    }
+  }
+
+  // ms until processTimeSync() has to run
+  uint32_t getTimeSyncTimeout()
+  {
+    if (!_stepPending)
+    {
+      return (EVENT_MAX_TIMEOUT);
+    }
+    int64_t remaining = _stepMicros - esp_timer_get_time() - (CLOCK_STEP_SPIN - 1000);
+    return ((remaining > 0) ? (uint32_t)min(remaining / 1000, (int64_t)EVENT_MAX_TIMEOUT) : 0);
+  }
+
+  // the state of the GPS time sync, for the simulator
+  TimeDiscipline *getTimeDiscipline()
+  {
+    return (&_discipline);
+  }
+
+  // for the simulator
+  AlarmScheduler *getAlarmScheduler()
+  {
+    return (&_alarms);
+  }
+
+  void dumpTimeSync(Print &out)
+  {
+    _discipline.dump(out);
+    out.printf("square wave: %s\r\n", isSquareWaveActive() ? "active" : "missing, the rtc is set at every sync");
   }
 
   float getBoardTemperature()
@@ -117,7 +351,8 @@ public:
     return ((float)(_rtc.temperature() / 4));
   }
 
-  void onKeyboardEvent(uint8_t keyCode, key_state keyState, bool functionKeyPressed)
+  // keyMicros is the ESP32 timer when the key was pressed
+  void onKeyboardEvent(uint8_t keyCode, key_state keyState, bool functionKeyPressed, int64_t keyMicros)
   {
 
     operation op;
@@ -126,6 +361,8 @@ public:
 
     if (keyState == key_state::pressed)
     {
+      _displayHandler->stopAnimation();
+      _renderPending = true;
       KeyboardDecoder::decode(keyCode, functionKeyPressed, &function, &op, &digit);
 
       switch (function)
@@ -140,7 +377,7 @@ public:
         break;
 
       case key_function_type::operation:
-        operationInput(op);
+        operationInput(op, keyMicros);
         break;
 
       default:
@@ -154,6 +391,7 @@ private:
   TimeChangeRule _dstRule{"DST", Last, Sun, Mar, 2, 120};
   TimeChangeRule _stdRule{"STD ", Last, Sun, Oct, 3, 60};
   Timezone *_timeZone;
+  TimeZoneCache _zoneCache;
   Settings *_settings;
   DisplayHandler *_displayHandler;
   String _display;
@@ -161,25 +399,141 @@ private:
   hour_mode::hour_mode _hourMode;
   leading_zero::leading_zero _leadingZero;
   date_format::date_format _dateFormat;
-  stopwatch_mode _stopwatchMode;
-  timer_mode _timerMode;
   input_mode _inputMode;
   float _temperature;
-  // timer variables
-  uint64_t _setMillis;
-  uint64_t _startMillis;
-  uint64_t _elapsedMillis;
+  Stopwatch _stopwatch;
+  CountdownTimer _countdown;
+  // the lap shown instead of the stopwatch, 0 for none
+  uint16_t _shownLap;
+  bool _showSplit;
+  unsigned long _lapMillis;
+  AlarmScheduler _alarms;
+  // the alarm shown instead of the time, ALARM_NONE for none
+  uint8_t _shownAlarm;
+  // a second counted by processAlarms() outside of process()
+  bool _secondPending;
+  // the current second and its local time, computed once per second
+  time_t _utc;
+  TimeElements _localTime;
+  // falling edges of the square wave, counted in the interrupt,
+  // with the ESP32 timer at the last one
+  inline static volatile uint32_t _squareWaveSeconds = 0;
+  inline static volatile int64_t _squareWaveMicros = 0;
+  uint32_t _handledSeconds;
+  uint32_t _secondsSinceSync;
+  unsigned long _squareWaveMillis;
+  bool _squareWaveActive;
+  // read the RTC on the next edge, after setting it or without edges
+  bool _resync;
+  bool _renderPending;
+  // blinking of the input
+  bool _showInput;
+  unsigned long _blinkMillis;
+  // GPS time sync
+  TimeDiscipline _discipline;
+  bool _stepPending;
+  time_t _stepUTC;
+  int64_t _stepMicros;
+
+  static void IRAM_ATTR onSquareWave()
+  {
+    _squareWaveMicros = esp_timer_get_time();
+    _squareWaveSeconds = _squareWaveSeconds + 1;
+    Events::signalFromISR(EVENT_RTC);
+  }
+
+  // true when a new second started, the RTC is read once after an edge
+  // following a resync, then the edges are counted, without edges the
+  // system time is polled, it is synced from the RTC by TimeLib
+  bool updateTime()
+  {
+    uint32_t seconds = _squareWaveSeconds;
+
+    if (seconds != _handledSeconds)
+    {
+      uint32_t edges = seconds - _handledSeconds;
+      _handledSeconds = seconds;
+      _squareWaveMillis = millis();
+      _squareWaveActive = true;
+      _secondsSinceSync += edges;
+      if (_resync || (_secondsSinceSync >= CLOCK_RTC_RESYNC))
+      {
+        _utc = _rtc.get();
+        _resync = false;
+        _secondsSinceSync = 0;
+      }
+      else
+      {
+        _utc += edges;
+      }
+      // the system time follows the seconds of the RTC
+      setTime(_utc);
+    }
+    else
+    {
+      if (_squareWaveActive && (millis() - _squareWaveMillis > CLOCK_SQW_TIMEOUT))
+      {
+        // edges are missing, count again from the RTC when they are back
+        _squareWaveActive = false;
+        _resync = true;
+      }
+      if (_squareWaveActive || (now() == _utc))
+      {
+        return (false);
+      }
+      _utc = now();
+    }
+    breakTime(_zoneCache.toLocal(_utc), _localTime);
+    return (true);
+  }
+
+  bool isSquareWaveActive()
+  {
+    return (esp_timer_get_time() - _squareWaveMicros < CLOCK_SQW_TIMEOUT * 1000LL);
+  }
+
+  // the RTC second the last edge started and the ESP32 timer at the edge,
+  // read again if an edge comes in between
+  bool getSecondStart(time_t *utc, int64_t *micros)
+  {
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      if (!isSquareWaveActive())
+      {
+        return (false);
+      }
+      uint32_t seconds = _squareWaveSeconds;
+      *micros = _squareWaveMicros;
+      *utc = _rtc.get();
+      if (seconds == _squareWaveSeconds)
+      {
+        return (true);
+      }
+    }
+    return (false);
+  }
+
+  // the RTC is set when the next GPS second starts,
+  // utc was the GPS time at micros
+  void scheduleStep(time_t utc, int64_t micros)
+  {
+    int64_t now = esp_timer_get_time();
+    _stepUTC = utc + 1;
+    _stepMicros = micros + 1000000LL;
+    while (_stepMicros - now < CLOCK_STEP_SPIN)
+    {
+      _stepUTC++;
+      _stepMicros += 1000000LL;
+    }
+    _stepPending = true;
+  }
 
-  // current time
-  void getCurrentTime(TimeElements *tm)
+  // input blinks, stopwatch and timer change within the second
+  bool isSubSecondMode()
   {
-    time_t utc, local;
-    utc = now();
-    // convert to local time
-    local = _timeZone->toLocal(utc);
-    // to time elements
-    breakTime(local, *tm);
-    _rtc.temperature();
+    return ((_inputMode != input_mode::none) ||
+            ((_clockMode == clock_mode::stopwatch) && (_stopwatch.getMode() == stopwatch_mode::running)) ||
+            ((_clockMode == clock_mode::timer) && (_countdown.getMode() == timer_mode::running)));
   }
 
   // set time zone rules from settings
@@ -210,6 +564,8 @@ private:
     _stdRule.week = value;
 
     _timeZone->setRules(_dstRule, _stdRule);
+    _zoneCache.setTimeZone(_timeZone, _dstRule, _stdRule);
+    _alarms.setTimeZone(_timeZone, _dstRule, _stdRule);
   }
 
   void setRTCTime()
@@ -236,9 +592,75 @@ private:
       utc = _timeZone->toUTC(local);
       _rtc.set(utc);
       setTime(utc);
+      _utc = utc;
+      _resync = true;
+      _discipline.reset();
+      _alarms.reschedule();
     }
   }
 
+  // slot, hour, minute and the day code, 0 for off, 1 to 7 for Monday
+  // to Sunday, 8 for every day, 9 for Monday to Friday
+  void setAlarm()
+  {
+    static const uint8_t days[] = {ALARM_DAYS_OFF, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x01,
+                                   ALARM_DAYS_DAILY, ALARM_DAYS_WORKDAYS};
+
+    while (_display.length() < MAX_ALARM_INPUT)
+    {
+      _display = "0" + _display;
+    }
+    uint8_t slot = _display.substring(0, 1).toInt();
+    uint8_t hour = _display.substring(1, 3).toInt();
+    uint8_t minute = _display.substring(3, 5).toInt();
+    uint8_t code = _display.substring(5, 6).toInt();
+    if (_alarms.setAlarm(slot, hour, minute, days[code]))
+    {
+      _shownAlarm = slot;
+    }
+  }
+
+  // the day code of the days of an alarm
+  uint8_t getDayCode(uint8_t days)
+  {
+    switch (days)
+    {
+    case ALARM_DAYS_OFF:
+      return (0);
+
+    case ALARM_DAYS_DAILY:
+      return (8);
+
+    case ALARM_DAYS_WORKDAYS:
+      return (9);
+
+    case 0x01:
+      // Sunday
+      return (7);
+
+    default:
+      // a single day from Monday
+      for (uint8_t day = 1; day < 7; day++)
+      {
+        if (days == (1 << day))
+        {
+          return (day);
+        }
+      }
+      return (0);
+    }
+  }
+
+  // like the input, slot, time and day code
+  void showAlarm(uint8_t slot)
+  {
+    const ALARM *alarm = _alarms.getAlarm(slot);
+    char buffer[16];
+
+    sprintf(buffer, "%u  %02u %02u  %u", slot, alarm->hour, alarm->minute, getDayCode(alarm->days));
+    _displayHandler->show(buffer);
+  }
+
   void showTime(TimeElements tm, uint8_t position, bool showSeconds, bool space)
   {
     int hour;
@@ -623,60 +1045,49 @@ private:
     {
       if (!isDate)
       {
+        // the date follows when the time has scrolled out
         scrollOutTime(tm);
-        _displayHandler->clearDisplay();
         isDate = true;
       }
-      showDate(tm, 2, year_type::full, true);
+      else
+      {
+        showDate(tm, 2, year_type::full, true);
+      }
     }
     else
     {
       if (isDate)
       {
         scrollOutDate(tm);
-        _displayHandler->clearDisplay();
         isDate = false;
       }
-      showTime(tm, 3, true, true);
+      else
+      {
+        showTime(tm, 3, true, true);
+      }
     }
   }
 
   // scroll over every digits for poisoning prevention
+  // runs from process() like the scroll animations
   void antiPoisoning(bool mode)
   {
-    _displayHandler->clearDisplay();
-    for (int i = 0; i < 10; i++)
-    {
-      for (int j = 0; j < _displayHandler->getDigitCount(); j++)
-      {
-        _displayHandler->setDigit(j, i);
-        _displayHandler->show();
-      }
-      delay(75);
-    }
+    _displayHandler->cycleDigits();
   }
 
+  // the scroll animations run from process(), they don't block
   void scrollOutTime(TimeElements tm)
   {
-
-    for (int i = 2; i > (-8); i--)
-    {
-      _displayHandler->clearDisplay();
-      showTime(tm, i, true, true);
-      _displayHandler->show();
-      delay(75);
-    }
+    _displayHandler->clear();
+    showTime(tm, 3, true, true);
+    _displayHandler->scrollOut();
   }
 
   void scrollOutDate(TimeElements tm)
   {
-    for (int i = 1; i > (-10); i--)
-    {
-      _displayHandler->clearDisplay();
-      showDate(tm, i, year_type::full, true);
-      _displayHandler->show();
-      delay(75);
-    }
+    _displayHandler->clear();
+    showDate(tm, 2, year_type::full, true);
+    _displayHandler->scrollOut();
   }
 
   void showTimeAndDate(TimeElements tm)
@@ -688,37 +1099,13 @@ private:
   void showTimer()
   {
     uint8_t position = 1;
-    uint64_t remainingMillis;
-
-    switch (_timerMode)
-    {
-    case timer_mode::set:
-      remainingMillis = _setMillis;
-      _elapsedMillis = 0;
-      break;
-
-    case timer_mode::zero:
-      remainingMillis = 0;
-      break;
-
-    case timer_mode::running:
-      remainingMillis = (_setMillis - _elapsedMillis) - ((esp_timer_get_time() / 1000ULL) - _startMillis);
-      break;
+    // whole seconds left, the countdown is over when 0 is shown
+    uint64_t remaining = (_countdown.getRemaining() + 999999) / 1000000;
 
-    case timer_mode::stopped:
-      remainingMillis = _setMillis - _elapsedMillis;
-      break;
-    }
-
-    if (remainingMillis > _setMillis)
-    {
-      _timerMode = timer_mode::zero;
-      remainingMillis = 0;
-    }
-    unsigned long ts = (remainingMillis / 1000) % 60;
-    unsigned long tm = (remainingMillis / 60000) % 60;
-    unsigned long th = (remainingMillis / 3600000) % 24;
-    unsigned long td = (remainingMillis / 86400000) % 100;
+    unsigned long ts = remaining % 60;
+    unsigned long tm = (remaining / 60) % 60;
+    unsigned long th = (remaining / 3600) % 24;
+    unsigned long td = (remaining / 86400) % 100;
 
     _displayHandler->setDigit(position + 0, td / 10);
     _displayHandler->setDigit(position + 1, td % 10);
@@ -730,51 +1117,44 @@ private:
     _displayHandler->setDigit(position + 10, ts % 10);
   }
 
+  // the elapsed time, or a lap with its number on the last two tubes,
+  // the decimal point of the last tube is on for the split time
   void showStopWatch()
   {
-    static uint64_t startMillis = 0;
-    static uint64_t elsapsedMillis = 0;
-    static bool running = false;
     int position = 1;
+    const STOPWATCH_LAP *lap = nullptr;
+    int64_t elapsed;
 
-    switch (_stopwatchMode)
+    if ((_shownLap != 0) && (_stopwatch.getMode() == stopwatch_mode::running) &&
+        (millis() - _lapMillis >= CLOCK_LAP_SHOW_TIME))
     {
-    case stopwatch_mode::zero:
-      elsapsedMillis = 0;
-      startMillis = 0;
-      running = false;
-      break;
-
-    case stopwatch_mode::running:
-      if (running)
-      {
-        elsapsedMillis = (esp_timer_get_time() / 1000ULL) - startMillis;
-      }
-      else
-      {
-        running = true;
-        if (startMillis == 0)
-        {
-          startMillis = (esp_timer_get_time() / 1000ULL);
-          elsapsedMillis = 0;
-        }
-      }
-      break;
-
-    case stopwatch_mode::stopped:
-      if (running)
-      {
-        running = false;
-        elsapsedMillis = (esp_timer_get_time() / 1000ULL) - startMillis;
-      }
-      break;
+      _shownLap = 0;
+    }
+    if (_shownLap != 0)
+    {
+      lap = _stopwatch.getLap(_shownLap);
+    }
+    if (lap)
+    {
+      elapsed = _showSplit ? lap->split : lap->lap;
+      _displayHandler->setDigit(position + 11, (lap->number / 10) % 10);
+      _displayHandler->setDigit(position + 12, lap->number % 10);
+      _displayHandler->setDecimalPoint(position + 12, _showSplit ? decimal_point_state::on : decimal_point_state::off);
+    }
+    else
+    {
+      elapsed = _stopwatch.getElapsed();
+      _displayHandler->setDigit(position + 11, DIGIT_OFF);
+      _displayHandler->setDigit(position + 12, DIGIT_OFF);
+      _displayHandler->setDecimalPoint(position + 12, decimal_point_state::off);
     }
 
     // show elapsed
-    unsigned long tc = elsapsedMillis % 1000;
-    unsigned long ts = (elsapsedMillis / 1000) % 60;
-    unsigned long tm = (elsapsedMillis / 60000) % 60;
-    unsigned long th = (elsapsedMillis / 3600000) % 24;
+    uint64_t elapsedMillis = elapsed / 1000;
+    unsigned long tc = elapsedMillis % 1000;
+    unsigned long ts = (elapsedMillis / 1000) % 60;
+    unsigned long tm = (elapsedMillis / 60000) % 60;
+    unsigned long th = (elapsedMillis / 3600000) % 24;
 
     _displayHandler->setDigit(position, th / 10);
     _displayHandler->setDigit(position + 1, th % 10);
@@ -834,17 +1214,14 @@ private:
     _displayHandler->setDigit(13, seconds01);
   }
 
-  void showInput(TimeElements tm)
+  void showInput()
   {
-    static unsigned long lastMillis = millis();
-    static bool show = true;
-
-    if (millis() - lastMillis > 250)
+    if (millis() - _blinkMillis >= CLOCK_INPUT_BLINK_INTERVAL)
     {
-      show = !show;
-      lastMillis = millis();
+      _showInput = !_showInput;
+      _blinkMillis = millis();
     }
-    if (show)
+    if (_showInput)
     {
       _displayHandler->show(_display);
     }
@@ -888,7 +1265,22 @@ private:
       }
       break;
 
+    case input_mode::alarm:
+      if (_display.equals("0"))
+      {
+        _display = char((digit + 48));
+      }
+      else
+      {
+        if (_display.length() < MAX_ALARM_INPUT)
+        {
+          _display += char((digit + 48));
+        }
+      }
+      break;
+
     case input_mode::none:
+      _shownAlarm = ALARM_NONE;
       switch ((clock_mode::clock_mode)digit)
       {
 
@@ -910,7 +1302,7 @@ private:
     }
   }
 
-  void operationInput(operation op)
+  void operationInput(operation op, int64_t keyMicros)
   {
     switch (op)
     {
@@ -918,6 +1310,8 @@ private:
       switch (_clockMode)
       {
       case clock_mode::stopwatch:
+        // back from the laps to the stopwatch
+        _shownLap = 0;
         break;
 
       case clock_mode::timer:
@@ -937,7 +1331,13 @@ private:
         break;
 
       default:
-        if (_inputMode == input_mode::none)
+        if (_shownAlarm != ALARM_NONE)
+        {
+          // back from the alarms to the time
+          _shownAlarm = ALARM_NONE;
+          _displayHandler->clearDisplay();
+        }
+        else if (_inputMode == input_mode::none)
         {
           _inputMode = input_mode::time;
           _display = "0";
@@ -956,12 +1356,12 @@ private:
       switch (_clockMode)
       {
       case clock_mode::stopwatch:
-        _stopwatchMode = stopwatch_mode::zero;
+        _stopwatch.reset();
+        _shownLap = 0;
         break;
 
       case clock_mode::timer:
-        _timerMode = timer_mode::set;
-        _elapsedMillis = 0;
+        _countdown.reload();
         break;
 
       default:
@@ -977,14 +1377,15 @@ private:
       switch (_clockMode)
       {
       case clock_mode::stopwatch:
-        if (_stopwatchMode == stopwatch_mode::running)
+        if (_stopwatch.getMode() == stopwatch_mode::running)
         {
-          _stopwatchMode = stopwatch_mode::stopped;
+          _stopwatch.stop(keyMicros);
         }
         else
         {
-          _stopwatchMode = stopwatch_mode::running;
+          _stopwatch.start(keyMicros);
         }
+        _shownLap = 0;
         break;
 
       case clock_mode::timer:
@@ -996,17 +1397,18 @@ private:
         }
         else
         {
-          switch (_timerMode)
+          switch (_countdown.getMode())
           {
           case timer_mode::running:
-            _timerMode = timer_mode::stopped;
-            _elapsedMillis += (esp_timer_get_time() / 1000ULL) - _startMillis;
+            _countdown.stop(keyMicros);
             break;
 
           case timer_mode::set:
           case timer_mode::stopped:
-            _timerMode = timer_mode::running;
-            _startMillis = esp_timer_get_time() / 1000ULL;
+            _countdown.start(keyMicros);
+            break;
+
+          default:
             break;
           }
         }
@@ -1020,14 +1422,115 @@ private:
           _displayHandler->clearDigits();
           setRTCTime();
           break;
+
+        case input_mode::alarm:
+          _inputMode = input_mode::none;
+          _displayHandler->clearDigits();
+          setAlarm();
+          break;
         }
         break;
       }
+      break;
+
+    case operation::memstore:
+      // an alarm is typed in like the time, in the modes showing the time
+      if ((_inputMode == input_mode::none) && isTimeMode())
+      {
+        _shownAlarm = ALARM_NONE;
+        _inputMode = input_mode::alarm;
+        _display = "0";
+        _displayHandler->show(_display);
+      }
+      break;
+
+    case operation::memread:
+      // steps through the alarms, then back to the time
+      if ((_inputMode == input_mode::none) && isTimeMode())
+      {
+        _shownAlarm = (_shownAlarm == ALARM_NONE) ? 0 : _shownAlarm + 1;
+        if (_shownAlarm >= ALARM_COUNT)
+        {
+          _shownAlarm = ALARM_NONE;
+        }
+        _displayHandler->clearDisplay();
+      }
+      break;
+
+    case operation::memclear:
+      // turns the alarm shown off
+      if (_shownAlarm != ALARM_NONE)
+      {
+        const ALARM *alarm = _alarms.getAlarm(_shownAlarm);
+        _alarms.setAlarm(_shownAlarm, alarm->hour, alarm->minute, ALARM_DAYS_OFF);
+      }
+      break;
+
+    case operation::addition:
+      if (_clockMode == clock_mode::stopwatch)
+      {
+        if (_stopwatch.getMode() == stopwatch_mode::running)
+        {
+          // shows the lap for a while, the stopwatch goes on
+          _shownLap = _stopwatch.lap(keyMicros);
+          _lapMillis = millis();
+        }
+        else
+        {
+          browseLaps(1);
+        }
+      }
+      break;
+
+    case operation::subtraction:
+      if ((_clockMode == clock_mode::stopwatch) && (_stopwatch.getMode() != stopwatch_mode::running))
+      {
+        browseLaps(-1);
+      }
+      break;
+
+    case operation::multiplication:
+      if (_clockMode == clock_mode::stopwatch)
+      {
+        // lap or split time
+        _showSplit = !_showSplit;
+      }
+      break;
+
     default:
       break;
     }
   }
 
+  bool isTimeMode()
+  {
+    return ((_clockMode != clock_mode::timer) && (_clockMode != clock_mode::stopwatch));
+  }
+
+  // steps through the laps kept, starts at the oldest or the newest one
+  void browseLaps(int8_t direction)
+  {
+    uint16_t first = _stopwatch.getFirstLap();
+    uint16_t last = _stopwatch.getLastLap();
+
+    if (first == 0)
+    {
+      return;
+    }
+    if ((_shownLap < first) || (_shownLap > last))
+    {
+      _shownLap = (direction > 0) ? first : last;
+    }
+    else if ((direction > 0) && (_shownLap < last))
+    {
+      _shownLap++;
+    }
+    else if ((direction < 0) && (_shownLap > first))
+    {
+      _shownLap--;
+    }
+  }
+
   void setTimer()
   {
     u_int64_t interval = 0;
@@ -1049,11 +1552,7 @@ private:
       interval += temp;
       if (interval <= MAX_TIMER_INTERVAL)
       {
-        interval *= 1000;
-        interval += 999;
-        _setMillis = interval;
-        _elapsedMillis = 0;
-        _timerMode = timer_mode::set;
+        _countdown.set(interval * 1000000ULL);
       }
     }
   }
@@ -13,7 +13,8 @@
 #include <HardwareInfo.h>
 #include <Errors.h>
 #include <Wire.h>
-#include <SoftwareSerial.h>
+#include <HardwareSerial.h>
+#include <Events.h>
 #include <KeyboardHandler.h>
 #include <Settings.h>
 #include <DisplayHandler.h>
@@ -23,6 +24,7 @@
 #include <GPS.h>
 #include <Temperature.h>
 #include <MenuHandler.h>
+#include <KeyLatency.h>
 
 // pin definitions
 #define PIN_HVENABLE 4
@@ -39,6 +41,26 @@
 #define PIN_TEMPERATURE 25
 #define PIN_BUTTON1 34
 #define PIN_NETACT 12
+// INT/SQW of the DS3232 on IO26 of the extension header,
+// without the wire the clock polls the system time
+#define PIN_RTCSQW 26
+
+// hardware UARTs, UART0 is the console
+#define KEYBOARD_UART 2
+#define KEYBOARD_SPEED 9600
+
+// serial console commands
+#define CONSOLE_CMD_LATENCY 'l'
+#define CONSOLE_CMD_RESET 'r'
+#define CONSOLE_CMD_HISTORY 'h'
+#define CONSOLE_CMD_TIMESYNC 't'
+#define CONSOLE_CMD_ALARMS 'a'
+
+// the LEDs flash when the timer is over or an alarm goes off,
+// until a key is pressed, an alarm not snoozed by then is over
+#define TIMER_FLASH_TIME 30000  // ms
+#define ALARM_FLASH_TIME 120000 // ms
+#define FLASH_INTERVAL 250      // ms
 
 // ENUMS
 enum class device_mode : uint8_t
@@ -48,18 +70,28 @@ enum class device_mode : uint8_t
   menu
 };
 
+enum class flash_mode : uint8_t
+{
+  none,
+  timer, // red LEDs
+  alarm  // backlight LEDs and the menu sign
+};
+
 // initial device mode
 device_mode deviceMode = device_mode::calculator;
 device_mode prevDeviceMode = device_mode::calculator;
 
+// calculation tape, RTC memory keeps it over deep sleep and soft resets
+RTC_NOINIT_ATTR CALC_HISTORY_DATA calcHistoryData;
+
 class Controller
 {
 public:
   Controller()
-      : _keyboardCom(PIN_KINT),
-        _displayHandler(DISPLAY_TYPE, PIN_DATA, PIN_STORE, PIN_SHIFT, PIN_BLANK, PIN_LEDCTL),
+      : _keyboardCom(KEYBOARD_UART),
+        _displayHandler(PIN_DATA, PIN_STORE, PIN_SHIFT, PIN_BLANK, PIN_LEDCTL),
         _clock(&_settings, &_displayHandler),
-        _calculator(&_settings),
+        _calculator(&_settings, &calcHistoryData),
         _pir(&_settings),
         _gps(&_settings),
         _temperature(PIN_TEMPERATURE, &_settings),
@@ -68,6 +100,9 @@ public:
     _highVoltageOn = true;
     _backLight = false;
     _autoOff = false;
+    _flashMode = flash_mode::none;
+    _flashOn = false;
+    _flashMillis = 0;
   }
 
   virtual ~Controller()
@@ -77,6 +112,8 @@ public:
   int begin()
   {
     int result = ERR_SUCCESS;
+    // events wake up the main loop
+    Events::begin();
     // set high voltage off
     pinMode(PIN_HVENABLE, OUTPUT);
     pinMode(PIN_HVLED, OUTPUT);
@@ -105,7 +142,8 @@ public:
       _calculator.begin(_displayHandler.getDigitCount(), _displayHandler.getDecimalPointCount(), _displayHandler.hasPlusSign());
 
       // init clock
-      _clock.begin();
+      _clock.begin(PIN_RTCSQW);
+      _clock.attachTimer(this, onTimerExpiredCallback);
 
       // init menu handler
       _menuHandler.begin(_displayHandler.getDigitCount());
@@ -131,7 +169,14 @@ public:
       Wire.begin();
 
       // init keyboard stuff
-      _keyboardCom.begin(9600);
+      _keyboardCom.begin(KEYBOARD_SPEED, SERIAL_8N1, PIN_KINT, -1);
+      // wake the main loop when a key arrives
+      _keyboardCom.onReceive([this]()
+                             { _keyLatency.markArrival();
+                               _keyboard.markArrival();
+                               Events::signal(EVENT_KEYBOARD); });
+      Serial.onReceive([]()
+                       { Events::signal(EVENT_CONSOLE); });
       _keyboard.begin(_keyboardCom);
       _keyboard.attach(this, onKeyboardEventCallback);
 
@@ -177,7 +222,7 @@ public:
       switch (deviceMode)
       {
       case device_mode::calculator:
-        _displayHandler.show(_calculator.getDisplay());
+        _displayHandler.show(_calculator.getDisplay(), _calculator.getDisplayLength());
         break;
 
       case device_mode::clock:
@@ -195,17 +240,52 @@ public:
     return (result);
   }
 
+  // sleeps until an event arrives or the current mode needs an update
+  void waitForEvents()
+  {
+    uint32_t timeout;
+
+    switch (deviceMode)
+    {
+    case device_mode::clock:
+      timeout = _clock.getTimeout();
+      break;
+
+    default:
+      // keyboard driven, the tick handles the periodic checks
+      timeout = EVENT_MAX_TIMEOUT;
+      break;
+    }
+    // a GPS step sets the RTC at the start of a second in every mode
+    timeout = min(timeout, _clock.getTimeSyncTimeout());
+    Events::wait(min(timeout, getFlashTimeout()));
+  }
+
   void process()
   {
+    // the frame of the last key may be out by now
+    _keyLatency.process(_displayHandler.getCommittedSequence(), _displayHandler.getCommitMicros());
+    processConsole();
 
     // process keyboard input
     _keyboard.process();
     checkAutoOff();
 
+    // saves changed memory registers when due
+    _calculator.process();
+
     if (_gpsMode == gps_mode::on)
     {
       _gps.process();
     }
+    _clock.processTimeSync();
+    // the timer runs out and alarms go off in every mode
+    _clock.processTimer();
+    if (_clock.processAlarms())
+    {
+      startFlash(flash_mode::alarm);
+    }
+    processFlash();
 
     if (_pirMode == pir_mode::on)
     {
@@ -233,9 +313,12 @@ public:
     switch (deviceMode)
     {
     case device_mode::clock:
-      _clock.process();
-      // the clock writes directly into the display buffer
-      _displayHandler.show();
+      // the clock writes directly into the display buffer,
+      // only when a second starts or a sub-second state changes
+      if (_clock.process())
+      {
+        _displayHandler.show();
+      }
       break;
 
     default:
@@ -287,11 +370,13 @@ public:
     _keyboard.setFastAutoRepeatDelay(0);
     _keyboard.setFastAutoRepeatInterval(0);
     _keyboard.setHoldTime(2000);
+    _displayHandler.stopAnimation();
     _displayHandler.clearDisplay();
     switch (deviceMode)
     {
     case device_mode::calculator:
       deviceMode = device_mode::clock;
+      _clock.refresh();
       break;
 
     case device_mode::clock:
@@ -303,6 +388,7 @@ public:
       deviceMode = prevDeviceMode;
       _clock.setSettings();
       _temperature.setSettings();
+      _calculator.setParameters();
       break;
     }
   }
@@ -317,19 +403,43 @@ public:
       _keyboard.setFastAutoRepeatInterval(25);
       _keyboard.setHoldTime(1000);
       _keyboard.setFastAutoRepeatDelay(15);
+      _displayHandler.stopAnimation();
       prevDeviceMode = deviceMode;
       deviceMode = device_mode::menu;
     }
   }
 
-  static void onKeyboardEventCallback(void *obj, uint8_t keyCode, key_state keyState, bool functionKeyPressed, special_keyboard_event specialEvent)
+  // the state of the GPS time sync, for the simulator
+  TimeDiscipline *getTimeDiscipline()
+  {
+    return (_clock.getTimeDiscipline());
+  }
+
+  // for the simulator
+  AlarmScheduler *getAlarmScheduler()
+  {
+    return (_clock.getAlarmScheduler());
+  }
+
+  // for the simulator
+  DisplayHandler *getDisplayHandler()
+  {
+    return (&_displayHandler);
+  }
+
+  static void onKeyboardEventCallback(void *obj, uint8_t keyCode, key_state keyState, bool functionKeyPressed, special_keyboard_event specialEvent, int64_t arrival)
+  {
+    ((Controller *)obj)->onKeyboardEvent(keyCode, keyState, functionKeyPressed, specialEvent, arrival);
+  }
+
+  static void onGPSTimeSyncEventCallback(void *obj, GPS_TIME *gpsTime)
   {
-    ((Controller *)obj)->onKeyboardEvent(keyCode, keyState, functionKeyPressed, specialEvent);
+    ((Controller *)obj)->onGPSTimeSyncEvent(gpsTime);
   }
 
-  static void onGPSTimeSyncEventCallback(void *obj, time_t utc)
+  static void onTimerExpiredCallback(void *obj)
   {
-    ((Controller *)obj)->onGPSTimeSyncEvent(utc);
+    ((Controller *)obj)->startFlash(flash_mode::timer);
   }
 
 private:
@@ -338,7 +448,7 @@ private:
   Settings _settings;
   DisplayHandler _displayHandler;
   KeyboardHandler _keyboard;
-  SoftwareSerial _keyboardCom;
+  HardwareSerial _keyboardCom;
   Clock _clock;
   Calculator _calculator;
   PIR _pir;
@@ -354,6 +464,55 @@ private:
   auto_off_mode::auto_off_mode _autoOffMode;
   int _autoOffDelay;
   bool _autoOff;
+  KeyLatency _keyLatency;
+  flash_mode _flashMode;
+  bool _flashOn;
+  unsigned long _flashMillis;
+
+  // commands from the serial console
+  void processConsole()
+  {
+    while (Serial.available())
+    {
+      switch (Serial.read())
+      {
+      case CONSOLE_CMD_LATENCY:
+        _keyLatency.dump(Serial);
+        Serial.printf("display: %u frames committed, %u skipped\r\n",
+                      _displayHandler.getFramesCommitted(), _displayHandler.getFramesSkipped());
+        Serial.printf("animation: %lu us max frame latency\r\n", _displayHandler.getMaxAnimationLatency());
+        Serial.printf("loop: %u wakeups in the last second\r\n", Events::getWakeupsPerSecond());
+        break;
+
+      case CONSOLE_CMD_RESET:
+        _keyLatency.reset();
+        _displayHandler.resetFrameCounters();
+        _displayHandler.resetAnimationLatency();
+        break;
+
+      case CONSOLE_CMD_HISTORY:
+        _calculator.dumpHistory(Serial);
+        break;
+
+      case CONSOLE_CMD_TIMESYNC:
+        _clock.dumpTimeSync(Serial);
+        break;
+
+      case CONSOLE_CMD_ALARMS:
+        _clock.dumpAlarms(Serial);
+        break;
+
+      default:
+        break;
+      }
+    }
+  }
+
+  // key presses and auto repeats are measured until their frame is out
+  bool isMeasuredKey(key_state keyState)
+  {
+    return ((keyState == key_state::pressed) || (keyState == key_state::autorepeat));
+  }
 
   void showVersion()
   {
@@ -363,7 +522,8 @@ private:
     _displayHandler.show(buffer);
   }
 
-  void onKeyboardEvent(uint8_t keyCode, key_state keyState, bool functionKeyPressed, special_keyboard_event specialEvent)
+  // arrival is the ESP32 timer when the key message was received
+  void onKeyboardEvent(uint8_t keyCode, key_state keyState, bool functionKeyPressed, special_keyboard_event specialEvent, int64_t arrival)
   {
     // Serial.print("Keycode: ");
     // Serial.print(keyCode);
@@ -374,6 +534,25 @@ private:
     // Serial.print("  Function key pressed: ");
     // Serial.println(functionKeyPressed);
 
+    if ((_flashMode != flash_mode::none) && (keyState == key_state::pressed))
+    {
+      // the key only stops the flashing, AC ends an alarm,
+      // every other key snoozes it
+      if (_flashMode == flash_mode::alarm)
+      {
+        operation op;
+        uint8_t digit;
+        key_function_type function;
+        KeyboardDecoder::decode(keyCode, functionKeyPressed, &function, &op, &digit);
+        if ((function != key_function_type::operation) || (op != operation::allclear))
+        {
+          _clock.snoozeAlarm();
+        }
+      }
+      stopFlash();
+      return;
+    }
+
     if (!_autoOff)
     {
       switch (specialEvent)
@@ -396,14 +575,26 @@ private:
       {
       case device_mode::calculator:
         // calculator is keyboard driven, send key event and update display
-        _calculator.onKeyboardEvent(keyCode, keyState, functionKeyPressed);
-        _displayHandler.show(_calculator.getDisplay());
+        if (isMeasuredKey(keyState))
+        {
+          _keyLatency.beginKey();
+          _calculator.onKeyboardEvent(keyCode, keyState, functionKeyPressed);
+          _keyLatency.markCalculated();
+          _displayHandler.show(_calculator.getDisplay(), _calculator.getDisplayLength());
+          _keyLatency.markDisplayed(_displayHandler.getPublishedSequence());
+        }
+        else
+        {
+          _calculator.onKeyboardEvent(keyCode, keyState, functionKeyPressed);
+          _displayHandler.show(_calculator.getDisplay(), _calculator.getDisplayLength());
+        }
         break;
 
       case device_mode::clock:
         // the clock also needs some keyboard events for setting
-        // the time and changing the clock mode
-        _clock.onKeyboardEvent(keyCode, keyState, functionKeyPressed);
+        // the time and changing the clock mode, the key was pressed
+        // while its message was sent
+        _clock.onKeyboardEvent(keyCode, keyState, functionKeyPressed, arrival - KEYBOARD_LINK_TIME);
         break;
 
       case device_mode::menu:
@@ -439,9 +630,95 @@ private:
     }
   }
 
-  void onGPSTimeSyncEvent(time_t utc)
+  void onGPSTimeSyncEvent(GPS_TIME *gpsTime)
+  {
+    _clock.syncTime(gpsTime->utc, gpsTime->micros);
+  }
+
+  void startFlash(flash_mode mode)
+  {
+    if (_flashMode != flash_mode::none)
+    {
+      stopFlash();
+    }
+    _flashMode = mode;
+    _flashOn = false;
+    _flashMillis = millis();
+    processFlash();
+  }
+
+  void stopFlash()
+  {
+    if ((_flashMode == flash_mode::alarm) && _displayHandler.hasMenuSign())
+    {
+      _displayHandler.setMenuSign(menu_sign_state::off);
+      _displayHandler.show();
+    }
+    _flashMode = flash_mode::none;
+    if (_backLight && _highVoltageOn)
+    {
+      setBackLight();
+    }
+    else
+    {
+      _displayHandler.clearLEDs();
+    }
+  }
+
+  void processFlash()
   {
-    _clock.setRTCTime(utc);
+    if (_flashMode == flash_mode::none)
+    {
+      return;
+    }
+    unsigned long elapsed = millis() - _flashMillis;
+    if (elapsed >= ((_flashMode == flash_mode::alarm) ? ALARM_FLASH_TIME : TIMER_FLASH_TIME))
+    {
+      stopFlash();
+      return;
+    }
+    bool on = ((elapsed / FLASH_INTERVAL) % 2) == 0;
+    if (on == _flashOn)
+    {
+      return;
+    }
+    _flashOn = on;
+    switch (_flashMode)
+    {
+    case flash_mode::timer:
+      _displayHandler.setAllLED(on ? 255 : 0, 0, 0);
+      _displayHandler.updateLEDs();
+      break;
+
+    case flash_mode::alarm:
+      if (on)
+      {
+        setBackLight();
+      }
+      else
+      {
+        _displayHandler.clearLEDs();
+      }
+      if (_displayHandler.hasMenuSign())
+      {
+        _displayHandler.setMenuSign(on ? menu_sign_state::on : menu_sign_state::off);
+        _displayHandler.show();
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  // ms until the flashing LEDs change
+  uint32_t getFlashTimeout()
+  {
+    if (_flashMode == flash_mode::none)
+    {
+      return (EVENT_MAX_TIMEOUT);
+    }
+    return (FLASH_INTERVAL - ((millis() - _flashMillis) % FLASH_INTERVAL));
   }
 
   void checkAutoOff()
@@ -458,8 +735,12 @@ private:
           break;
 
         case auto_off_mode::clock:
-          deviceMode = device_mode::clock;
-          _displayHandler.clear();
+          if (deviceMode != device_mode::clock)
+          {
+            deviceMode = device_mode::clock;
+            _displayHandler.clear();
+            _clock.refresh();
+          }
           break;
         }
       }
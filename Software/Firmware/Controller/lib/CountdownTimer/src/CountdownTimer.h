@@ -0,0 +1,187 @@
+// CountdownTimer.h
+
+// countdown on the ESP32 timer, a one shot esp_timer expires at the
+// end and wakes the main loop, process() calls the expiry callback
+// from there, start and stop take the time the key was pressed
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+#include <Events.h>
+
+enum class timer_mode : uint8_t
+{
+  zero,
+  set,
+  stopped,
+  running
+};
+
+class CountdownTimer
+{
+public:
+  using notifyCallBack = void (*)(void *obj);
+
+  CountdownTimer()
+      : _timer(nullptr),
+        _mode(timer_mode::zero),
+        _duration(0),
+        _remaining(0),
+        _deadline(0),
+        _expired(false),
+        _obj(nullptr),
+        _notify(nullptr)
+  {
+  }
+
+  void begin()
+  {
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = onExpiry;
+    timerArgs.arg = this;
+    timerArgs.name = "countdown";
+    esp_timer_create(&timerArgs, &_timer);
+  }
+
+  // called from the main loop when the countdown is over
+  void attach(void *obj, notifyCallBack callBack)
+  {
+    _obj = obj;
+    _notify = callBack;
+  }
+
+  // us, the countdown waits for start()
+  void set(int64_t duration)
+  {
+    _duration = duration;
+    reload();
+  }
+
+  // back to the duration set
+  void reload()
+  {
+    cancel();
+    _remaining = _duration;
+    _mode = timer_mode::set;
+  }
+
+  // micros is the ESP32 timer when the key was pressed
+  void start(int64_t micros)
+  {
+    if ((_mode != timer_mode::set) && (_mode != timer_mode::stopped))
+    {
+      return;
+    }
+    _deadline = micros + _remaining;
+    _mode = timer_mode::running;
+    int64_t timeout = _deadline - esp_timer_get_time();
+    if (timeout > 0)
+    {
+      esp_timer_start_once(_timer, timeout);
+    }
+    else
+    {
+      onExpiry(this);
+    }
+  }
+
+  void stop(int64_t micros)
+  {
+    if (_mode != timer_mode::running)
+    {
+      return;
+    }
+    int64_t remaining = _deadline - micros;
+    if (remaining > 0)
+    {
+      // the key was first, even if the loop got to it after the expiry
+      cancel();
+      _remaining = remaining;
+      _mode = timer_mode::stopped;
+    }
+  }
+
+  timer_mode getMode()
+  {
+    return (_mode);
+  }
+
+  int64_t getDuration()
+  {
+    return (_duration);
+  }
+
+  // us at the ESP32 timer micros
+  int64_t getRemaining(int64_t micros)
+  {
+    switch (_mode)
+    {
+    case timer_mode::running:
+      return ((_deadline > micros) ? _deadline - micros : 0);
+
+    case timer_mode::zero:
+      return (0);
+
+    default:
+      return (_remaining);
+    }
+  }
+
+  int64_t getRemaining()
+  {
+    return (getRemaining(esp_timer_get_time()));
+  }
+
+  // returns true if the countdown is over, the callback was called
+  bool process()
+  {
+    if (!_expired.exchange(false))
+    {
+      return (false);
+    }
+    if (_mode != timer_mode::running)
+    {
+      return (false);
+    }
+    _mode = timer_mode::zero;
+    _remaining = 0;
+    if (_notify)
+    {
+      _notify(_obj);
+    }
+    return (true);
+  }
+
+private:
+  esp_timer_handle_t _timer;
+  timer_mode _mode;
+  int64_t _duration;
+  int64_t _remaining;
+  // the ESP32 timer at the end of a running countdown
+  int64_t _deadline;
+  // set by the esp_timer task
+  std::atomic<bool> _expired;
+  void *_obj;
+  notifyCallBack _notify;
+
+  void cancel()
+  {
+    if (esp_timer_is_active(_timer))
+    {
+      esp_timer_stop(_timer);
+    }
+    _expired = false;
+  }
+
+  static void onExpiry(void *arg)
+  {
+    CountdownTimer *countdown = (CountdownTimer *)arg;
+    countdown->_expired = true;
+    Events::signal(EVENT_TIMER);
+  }
+};
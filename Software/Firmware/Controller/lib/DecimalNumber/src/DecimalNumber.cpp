@@ -0,0 +1,535 @@
+// DecimalNumber.cpp
+
+// provides a decimal floating point number type
+// 18 significant digits (14 display digits plus 4 guard digits)
+// stored as a scaled 64-bit integer, the basic arithmetic
+// operations don't need any floating point math
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include "DecimalNumber.h"
+
+// 10^0 to 10^19
+static const uint64_t POWERS_OF_TEN[] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL};
+
+#define HALF_LIMB 1000000000ULL
+
+// constructors
+DecimalNumber::DecimalNumber() : _coefficient(0), _exponent(0), _negative(false), _roundedUp(false)
+{
+}
+
+DecimalNumber::DecimalNumber(int value)
+{
+  setInteger(value);
+}
+
+DecimalNumber::DecimalNumber(long value)
+{
+  setInteger(value);
+}
+
+DecimalNumber::DecimalNumber(long long value)
+{
+  setInteger(value);
+}
+
+// converts from double, rounded to DECIMAL_DOUBLE_DIGITS significant digits
+// infinite values and NaN are saturated to the largest number
+DecimalNumber::DecimalNumber(double value)
+{
+  if (isfinite(value))
+  {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*e", DECIMAL_DOUBLE_DIGITS - 1, value);
+    *this = fromString(buffer);
+  }
+  else
+  {
+    _coefficient = DECIMAL_MAX_COEFFICIENT;
+    _exponent = DECIMAL_MAX_EXPONENT;
+    _negative = (value < 0);
+    _roundedUp = false;
+  }
+}
+
+// parses a decimal number, digits beyond the precision are rounded
+DecimalNumber DecimalNumber::fromString(const char *s)
+{
+  bool negative = false;
+  bool decimalPoint = false;
+  uint64_t coefficient = 0;
+  uint8_t digits = 0;
+  uint8_t roundDigit = 0;
+  int exponent = 0;
+
+  while (*s == ' ')
+  {
+    s++;
+  }
+  if ((*s == '-') || (*s == '+'))
+  {
+    negative = (*s == '-');
+    s++;
+  }
+  for (; *s; s++)
+  {
+    if ((*s >= '0') && (*s <= '9'))
+    {
+      uint8_t digit = *s - '0';
+      if ((digits == 0) && (digit == 0))
+      {
+        // leading zero
+        if (decimalPoint)
+        {
+          exponent--;
+        }
+      }
+      else if (digits < DECIMAL_PRECISION)
+      {
+        coefficient = coefficient * 10 + digit;
+        digits++;
+        if (decimalPoint)
+        {
+          exponent--;
+        }
+      }
+      else
+      {
+        // beyond precision, keep only the first dropped digit for rounding
+        if (digits == DECIMAL_PRECISION)
+        {
+          roundDigit = digit;
+          digits++;
+        }
+        if (!decimalPoint)
+        {
+          exponent++;
+        }
+      }
+    }
+    else if ((*s == '.') && !decimalPoint)
+    {
+      decimalPoint = true;
+    }
+    else
+    {
+      break;
+    }
+  }
+  if ((*s == 'e') || (*s == 'E'))
+  {
+    s++;
+    bool negativeExponent = false;
+    int value = 0;
+    if ((*s == '-') || (*s == '+'))
+    {
+      negativeExponent = (*s == '-');
+      s++;
+    }
+    while ((*s >= '0') && (*s <= '9'))
+    {
+      if (value < 10000)
+      {
+        value = value * 10 + (*s - '0');
+      }
+      s++;
+    }
+    exponent += negativeExponent ? -value : value;
+  }
+  return (compose(negative, coefficient, roundDigit * (DECIMAL_LIMB / 10), exponent - DECIMAL_PRECISION));
+}
+
+// converts to the nearest double
+double DecimalNumber::toDouble() const
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%s%llue%d", _negative ? "-" : "", (unsigned long long)_coefficient, _exponent);
+  return (strtod(buffer, nullptr));
+}
+
+bool DecimalNumber::isZero() const
+{
+  return (_coefficient == 0);
+}
+
+bool DecimalNumber::isNegative() const
+{
+  return (_negative);
+}
+
+bool DecimalNumber::isRoundedUp() const
+{
+  return (_roundedUp);
+}
+
+// returns true if there are no significant decimals
+bool DecimalNumber::isInteger() const
+{
+  if ((_coefficient == 0) || (_exponent >= 0))
+  {
+    return (true);
+  }
+  if (-_exponent >= DECIMAL_PRECISION)
+  {
+    return (false);
+  }
+  return ((_coefficient % POWERS_OF_TEN[-_exponent]) == 0);
+}
+
+DecimalNumber DecimalNumber::absolute() const
+{
+  DecimalNumber result = *this;
+  result._negative = false;
+  return (result);
+}
+
+uint64_t DecimalNumber::getCoefficient() const
+{
+  return (_coefficient);
+}
+
+int16_t DecimalNumber::getExponent() const
+{
+  return (_exponent);
+}
+
+DecimalNumber DecimalNumber::operator-() const
+{
+  DecimalNumber result = *this;
+  if (!result.isZero())
+  {
+    result._negative = !_negative;
+  }
+  return (result);
+}
+
+DecimalNumber DecimalNumber::operator+(const DecimalNumber &other) const
+{
+  return (addition(*this, other, false));
+}
+
+DecimalNumber DecimalNumber::operator-(const DecimalNumber &other) const
+{
+  return (addition(*this, other, true));
+}
+
+// multiplies the coefficients in 10^9 limbs, the 36 digit
+// product is rounded back to 18 digits
+DecimalNumber DecimalNumber::operator*(const DecimalNumber &other) const
+{
+  if (isZero() || other.isZero())
+  {
+    return (DecimalNumber());
+  }
+  uint64_t leftHigh = _coefficient / HALF_LIMB;
+  uint64_t leftLow = _coefficient % HALF_LIMB;
+  uint64_t rightHigh = other._coefficient / HALF_LIMB;
+  uint64_t rightLow = other._coefficient % HALF_LIMB;
+
+  uint64_t low = leftLow * rightLow;
+  uint64_t middle = leftHigh * rightLow + leftLow * rightHigh;
+  uint64_t high = leftHigh * rightHigh;
+
+  middle += low / HALF_LIMB;
+  low %= HALF_LIMB;
+  high += middle / HALF_LIMB;
+  low += (middle % HALF_LIMB) * HALF_LIMB;
+
+  return (compose(_negative != other._negative, high, low, _exponent + other._exponent));
+}
+
+// long division, one decimal digit per step
+DecimalNumber DecimalNumber::operator/(const DecimalNumber &other) const
+{
+  if (isZero() || other.isZero())
+  {
+    return (DecimalNumber());
+  }
+  uint64_t divisor = other._coefficient;
+  uint64_t quotient = _coefficient / divisor;
+  uint64_t remainder = _coefficient % divisor;
+  int exponent = _exponent - other._exponent;
+
+  while (quotient < DECIMAL_MIN_COEFFICIENT)
+  {
+    remainder *= 10;
+    quotient = quotient * 10 + remainder / divisor;
+    remainder %= divisor;
+    exponent--;
+  }
+  // one more digit for rounding
+  remainder *= 10;
+  uint64_t roundDigit = remainder / divisor;
+
+  return (compose(_negative != other._negative, quotient, roundDigit * (DECIMAL_LIMB / 10), exponent - DECIMAL_PRECISION));
+}
+
+DecimalNumber &DecimalNumber::operator+=(const DecimalNumber &other)
+{
+  *this = *this + other;
+  return (*this);
+}
+
+DecimalNumber &DecimalNumber::operator-=(const DecimalNumber &other)
+{
+  *this = *this - other;
+  return (*this);
+}
+
+DecimalNumber &DecimalNumber::operator*=(const DecimalNumber &other)
+{
+  *this = *this * other;
+  return (*this);
+}
+
+DecimalNumber &DecimalNumber::operator/=(const DecimalNumber &other)
+{
+  *this = *this / other;
+  return (*this);
+}
+
+bool DecimalNumber::operator==(const DecimalNumber &other) const
+{
+  return (compare(*this, other) == 0);
+}
+
+bool DecimalNumber::operator!=(const DecimalNumber &other) const
+{
+  return (compare(*this, other) != 0);
+}
+
+bool DecimalNumber::operator<(const DecimalNumber &other) const
+{
+  return (compare(*this, other) < 0);
+}
+
+bool DecimalNumber::operator>(const DecimalNumber &other) const
+{
+  return (compare(*this, other) > 0);
+}
+
+bool DecimalNumber::operator<=(const DecimalNumber &other) const
+{
+  return (compare(*this, other) <= 0);
+}
+
+bool DecimalNumber::operator>=(const DecimalNumber &other) const
+{
+  return (compare(*this, other) >= 0);
+}
+
+void DecimalNumber::setInteger(long long value)
+{
+  // avoid overflow when negating the smallest value
+  uint64_t magnitude = (value < 0) ? (uint64_t)(-(value + 1)) + 1 : (uint64_t)value;
+  *this = compose(value < 0, magnitude / DECIMAL_LIMB, magnitude % DECIMAL_LIMB, 0);
+}
+
+// builds a number from the exact value (hi * 10^18 + lo) * 10^exponent,
+// hi may have up to 19 digits, lo must be below 10^18.
+// the value is rounded half up to 18 significant digits, it is
+// marked when the magnitude went up, a display rounding the 18 digits
+// once more then knows on which side of a tie the exact value was
+DecimalNumber DecimalNumber::compose(bool negative, uint64_t hi, uint64_t lo, int exponent)
+{
+  DecimalNumber result;
+  uint64_t coefficient;
+  uint8_t roundDigit = 0;
+
+  if ((hi == 0) && (lo == 0))
+  {
+    return (result);
+  }
+  if (hi != 0)
+  {
+    uint8_t digits = countDigits(hi);
+    if (digits > DECIMAL_PRECISION)
+    {
+      roundDigit = hi % 10;
+      coefficient = hi / 10;
+      exponent += DECIMAL_PRECISION + 1;
+    }
+    else
+    {
+      coefficient = hi * POWERS_OF_TEN[DECIMAL_PRECISION - digits] + lo / POWERS_OF_TEN[digits];
+      roundDigit = (lo % POWERS_OF_TEN[digits]) / POWERS_OF_TEN[digits - 1];
+      exponent += digits;
+    }
+  }
+  else
+  {
+    uint8_t digits = countDigits(lo);
+    coefficient = lo * POWERS_OF_TEN[DECIMAL_PRECISION - digits];
+    exponent -= DECIMAL_PRECISION - digits;
+  }
+
+  if (roundDigit >= 5)
+  {
+    result._roundedUp = true;
+    coefficient++;
+    if (coefficient > DECIMAL_MAX_COEFFICIENT)
+    {
+      coefficient /= 10;
+      exponent++;
+    }
+  }
+
+  if (exponent < DECIMAL_MIN_EXPONENT)
+  {
+    // underflow, flush to zero
+    return (DecimalNumber());
+  }
+  if (exponent > DECIMAL_MAX_EXPONENT)
+  {
+    // overflow, saturate
+    coefficient = DECIMAL_MAX_COEFFICIENT;
+    exponent = DECIMAL_MAX_EXPONENT;
+    result._roundedUp = false;
+  }
+  result._coefficient = coefficient;
+  result._exponent = exponent;
+  result._negative = negative;
+  return (result);
+}
+
+// adds or subtracts two numbers, the smaller one is aligned
+// to the larger one in a 36 digit (hi, lo) pair
+DecimalNumber DecimalNumber::addition(const DecimalNumber &left, const DecimalNumber &right, bool subtract)
+{
+  bool rightNegative = (right._negative != subtract);
+
+  // the other operand as it is, exact
+  if (right.isZero())
+  {
+    DecimalNumber result = left;
+    result._roundedUp = false;
+    return (result);
+  }
+  if (left.isZero())
+  {
+    DecimalNumber result = right;
+    result._negative = rightNegative;
+    result._roundedUp = false;
+    return (result);
+  }
+
+  const DecimalNumber *large = &left;
+  const DecimalNumber *small = &right;
+  bool largeNegative = left._negative;
+  bool smallNegative = rightNegative;
+  if (compareMagnitude(left, right) < 0)
+  {
+    large = &right;
+    small = &left;
+    largeNegative = rightNegative;
+    smallNegative = left._negative;
+  }
+
+  int shift = large->_exponent - small->_exponent;
+  uint64_t smallHi = 0;
+  uint64_t smallLo = 0;
+  bool sticky = false;
+  if (shift <= DECIMAL_PRECISION)
+  {
+    smallHi = small->_coefficient / POWERS_OF_TEN[shift];
+    smallLo = (small->_coefficient % POWERS_OF_TEN[shift]) * POWERS_OF_TEN[DECIMAL_PRECISION - shift];
+  }
+  else if (shift < 2 * DECIMAL_PRECISION)
+  {
+    smallLo = small->_coefficient / POWERS_OF_TEN[shift - DECIMAL_PRECISION];
+    sticky = (small->_coefficient % POWERS_OF_TEN[shift - DECIMAL_PRECISION]) != 0;
+  }
+  else
+  {
+    sticky = true;
+  }
+
+  uint64_t hi = large->_coefficient;
+  uint64_t lo = 0;
+  if (largeNegative == smallNegative)
+  {
+    hi += smallHi;
+    lo = smallLo;
+  }
+  else
+  {
+    hi -= smallHi;
+    if (smallLo != 0)
+    {
+      hi--;
+      lo = DECIMAL_LIMB - smallLo;
+    }
+    if (sticky)
+    {
+      // digits below lo are lost, the exact difference is a bit smaller
+      if (lo == 0)
+      {
+        hi--;
+        lo = DECIMAL_LIMB;
+      }
+      lo--;
+    }
+  }
+  return (compose(largeNegative, hi, lo, large->_exponent - DECIMAL_PRECISION));
+}
+
+// returns -1, 0 or 1
+int DecimalNumber::compare(const DecimalNumber &left, const DecimalNumber &right)
+{
+  if (left._negative != right._negative)
+  {
+    return (left._negative ? -1 : 1);
+  }
+  int result = compareMagnitude(left, right);
+  return (left._negative ? -result : result);
+}
+
+// compares absolute values, returns -1, 0 or 1
+int DecimalNumber::compareMagnitude(const DecimalNumber &left, const DecimalNumber &right)
+{
+  if (left.isZero() || right.isZero())
+  {
+    return ((left.isZero() ? 0 : 1) - (right.isZero() ? 0 : 1));
+  }
+  if (left._exponent != right._exponent)
+  {
+    return ((left._exponent < right._exponent) ? -1 : 1);
+  }
+  if (left._coefficient != right._coefficient)
+  {
+    return ((left._coefficient < right._coefficient) ? -1 : 1);
+  }
+  return (0);
+}
+
+uint8_t DecimalNumber::countDigits(uint64_t value)
+{
+  uint8_t digits = 1;
+  while ((digits < 20) && (value >= POWERS_OF_TEN[digits]))
+  {
+    digits++;
+  }
+  return (digits);
+}
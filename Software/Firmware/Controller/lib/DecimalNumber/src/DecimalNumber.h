@@ -0,0 +1,87 @@
+// DecimalNumber.h
+
+// provides a decimal floating point number type
+// 18 significant digits (14 display digits plus 4 guard digits)
+// stored as a scaled 64-bit integer, the basic arithmetic
+// operations don't need any floating point math
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+
+// precision and range
+#define DECIMAL_PRECISION 18
+#define DECIMAL_MIN_COEFFICIENT 100000000000000000ULL
+#define DECIMAL_MAX_COEFFICIENT 999999999999999999ULL
+#define DECIMAL_LIMB 1000000000000000000ULL
+#define DECIMAL_MIN_EXPONENT (-999)
+#define DECIMAL_MAX_EXPONENT 999
+
+// significant digits used when converting from double,
+// enough to get back every number typed on the keyboard
+#define DECIMAL_DOUBLE_DIGITS 15
+
+// value = (-1)^negative * coefficient * 10^exponent
+// the coefficient is always normalized to 18 digits, zero is the only exception
+class DecimalNumber
+{
+public:
+  DecimalNumber();
+  DecimalNumber(int value);
+  DecimalNumber(long value);
+  DecimalNumber(long long value);
+  explicit DecimalNumber(double value);
+
+  // parses a number like "-123.456" or "1.5e-3"
+  static DecimalNumber fromString(const char *s);
+
+  double toDouble() const;
+
+  bool isZero() const;
+  bool isNegative() const;
+  // true if the operation that gave this number rounded its magnitude up,
+  // copies and the sign change keep it, every operation sets it again
+  bool isRoundedUp() const;
+  bool isInteger() const;
+  DecimalNumber absolute() const;
+
+  // raw access
+  uint64_t getCoefficient() const;
+  int16_t getExponent() const;
+
+  DecimalNumber operator-() const;
+  DecimalNumber operator+(const DecimalNumber &other) const;
+  DecimalNumber operator-(const DecimalNumber &other) const;
+  DecimalNumber operator*(const DecimalNumber &other) const;
+  // division by zero returns zero, check the divisor before
+  DecimalNumber operator/(const DecimalNumber &other) const;
+  DecimalNumber &operator+=(const DecimalNumber &other);
+  DecimalNumber &operator-=(const DecimalNumber &other);
+  DecimalNumber &operator*=(const DecimalNumber &other);
+  DecimalNumber &operator/=(const DecimalNumber &other);
+
+  bool operator==(const DecimalNumber &other) const;
+  bool operator!=(const DecimalNumber &other) const;
+  bool operator<(const DecimalNumber &other) const;
+  bool operator>(const DecimalNumber &other) const;
+  bool operator<=(const DecimalNumber &other) const;
+  bool operator>=(const DecimalNumber &other) const;
+
+private:
+  uint64_t _coefficient;
+  int16_t _exponent;
+  bool _negative;
+  bool _roundedUp;
+
+  void setInteger(long long value);
+
+  // builds a rounded number from (hi * 10^18 + lo) * 10^exponent
+  static DecimalNumber compose(bool negative, uint64_t hi, uint64_t lo, int exponent);
+  static DecimalNumber addition(const DecimalNumber &left, const DecimalNumber &right, bool subtract);
+  static int compare(const DecimalNumber &left, const DecimalNumber &right);
+  static int compareMagnitude(const DecimalNumber &left, const DecimalNumber &right);
+  static uint8_t countDigits(uint64_t value);
+};
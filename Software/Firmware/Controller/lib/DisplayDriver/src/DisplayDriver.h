@@ -6,6 +6,15 @@
 // decimal points, the negative sign
 // and backlight
 
+// the display state is encoded into a packed frame
+// and clocked out by the SPI peripheral using DMA
+
+// the driver is specialized for one display type at compile time,
+// the HAL tables and the register lookup live in flash
+
+// after begin() a display task owns the shift registers and the LEDs,
+// refresh() only publishes the new frame to it
+
 // Copyright (C) 2023 highvoltglow
 // Licensed under the MIT License
 
@@ -13,15 +22,44 @@
 
 #include <Arduino.h>
 #include <HardwareInfo.h>
-#include <displayHAL.h>
-#include <displayHAL_IN16.h>
+#include <DisplayHAL.h>
+#include <DisplayHAL_IN16.h>
 #include <DisplayHAL_IN17.h>
 #include <DisplayHAL_IN12.h>
 #include <DisplayHAL_B5870.h>
-#include <Adafruit_Neopixel.h> // https://github.com/adafruit/Adafruit_NeoPixel
+#include <DisplayFrame.h>
+#include <Adafruit_NeoPixel.h> // https://github.com/adafruit/Adafruit_NeoPixel
+#include <driver/spi_master.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
 
 #define DIGIT_OFF 255
 
+// SPI output, PIN_DATA is MOSI, PIN_SHIFT is SCLK
+// data changes on the rising edge and is shifted on the falling edge (mode 1)
+#define DISPLAY_SPI_HOST SPI3_HOST
+#define DISPLAY_SPI_MODE 1
+#define DISPLAY_SPI_CLOCK 4000000
+
+// display task, the main loop runs on core 1
+#define DISPLAY_TASK_CORE 0
+#define DISPLAY_TASK_PRIORITY 2
+#define DISPLAY_TASK_STACK_SIZE 2048
+// ms between two checks for a new frame
+#define DISPLAY_REFRESH_INTERVAL 5
+
+// frame buffer slots, the producer and the display task
+// each own one, the third holds the last published frame
+#define FRAME_BUFFER_COUNT 3
+#define FRAME_PUBLISHED 0x80
+#define FRAME_SLOT_MASK 0x7F
+
+// requests carried out by the display task, it is the only one
+// that touches the registers and what they hold
+#define DISPLAY_REQUEST_BLANK 0x01
+#define DISPLAY_REQUEST_RESET_COUNTERS 0x02
+
 // shift transition
 #define SHIFT_BEGIN HIGH
 #define SHIFT_COMMIT LOW
@@ -54,18 +92,48 @@ enum class menu_sign_state
   on
 };
 
+// maps a display type to its HAL
+template <display_type displayType>
+struct DisplayHALSelector;
+
+template <>
+struct DisplayHALSelector<display_type::in12>
+{
+  typedef DisplayHAL_IN12 HAL;
+};
+
+template <>
+struct DisplayHALSelector<display_type::in16>
+{
+  typedef DisplayHAL_IN16 HAL;
+};
+
+template <>
+struct DisplayHALSelector<display_type::in17>
+{
+  typedef DisplayHAL_IN17 HAL;
+};
+
+template <>
+struct DisplayHALSelector<display_type::b5870>
+{
+  typedef DisplayHAL_B5870 HAL;
+};
+
+template <display_type displayType>
 class DisplayDriver
 {
 public:
-  DisplayDriver(display_type displayType, uint8_t dataPin,
-                uint8_t storePin, uint8_t shiftPin, uint8_t blankPin,
-                uint8_t ledCtlPin) : _displayType(displayType),
-                                     _dataPin(dataPin),
-                                     _storePin(storePin),
-                                     _shiftPin(shiftPin),
-                                     _blankPin(blankPin),
-                                     _ledCtlPin(ledCtlPin)
+  typedef typename DisplayHALSelector<displayType>::HAL HAL;
 
+  DisplayDriver(uint8_t dataPin, uint8_t storePin, uint8_t shiftPin,
+                uint8_t blankPin, uint8_t ledCtlPin) : _dataPin(dataPin),
+                                                       _storePin(storePin),
+                                                       _shiftPin(shiftPin),
+                                                       _blankPin(blankPin),
+                                                       _ledCtlPin(ledCtlPin),
+                                                       _leds(HAL::ledCount, ledCtlPin,
+                                                             (HAL::ledType == led_type::smd) ? (NEO_GRB + NEO_KHZ800) : (NEO_RGB + NEO_KHZ800))
   {
 
     // status (on or off) of the negative sign
@@ -74,80 +142,75 @@ public:
     // status (on or off) of the postivie sign
     _plusSign = plus_sign_state::off;
 
-    // select HAL
-    switch (_displayType)
-    {
-    case display_type::in16:
-      _dispHAL = new DisplayHAL_IN16();
-      break;
-
-    case display_type::in17:
-      _dispHAL = new DisplayHAL_IN17();
-      break;
-
-    case display_type::in12:
-      _dispHAL = new DisplayHAL_IN12();
-      break;
-
-    case display_type::b5870:
-      _dispHAL = new DisplayHAL_B5870;
-      break;
-    }
-
-    _digitCount = _dispHAL->getDigitCount();
-    _decimalPointCount = _dispHAL->getDecimalPointCount();
-    _ledCount = _dispHAL->getLEDCount();
-    _hasPlusSign = _dispHAL->hasPlusSign();
-
-    // array of digits
-    // digit 0 is the most left nixie
-    _digits = new uint8_t[_digitCount];
-
-    // array of decimal points
-    // decimal points are on the right side of the digits
-    _decimalPoints = new decimal_point_state[_decimalPointCount];
-
-    switch (_dispHAL->getLedType())
-    {
-    case led_type::smd:
-      _leds = new Adafruit_NeoPixel(_ledCount, _ledCtlPin, NEO_GRB + NEO_KHZ800);
-      break;
-
-    case led_type::tht:
-      _leds = new Adafruit_NeoPixel(_ledCount, _ledCtlPin, NEO_RGB + NEO_KHZ800);
-      break;
-    }
+    _spiDevice = nullptr;
+    _transferPending = false;
+
+    // nothing has been shifted out yet
+    _lastFrameValid = false;
+    _framesCommitted = 0;
+    _framesSkipped = 0;
+
+    _displayTask = nullptr;
+    _requests = 0;
+    memset(_frameSequence, 0, sizeof(_frameSequence));
+    _publishedSequence = 0;
+    _committedSequence = 0;
+    _commitMicros = 0;
+    _backFrame = 0;
+    _readyFrame = 1;
+    _frontFrame = 2;
+    _ledsPending = false;
+    portMUX_INITIALIZE(&_ledLock);
+    memset(_ledColors, 0, sizeof(_ledColors));
+
+    // start with a dark display
+    clear();
   };
 
   virtual ~DisplayDriver()
   {
-    delete[] _digits;
-    delete[] _decimalPoints;
-    delete _dispHAL;
-    delete _leds;
+    if (_displayTask)
+    {
+      vTaskDelete(_displayTask);
+    }
+    endSPI();
   }
 
   void begin()
   {
+    // init shift register output
+    beginSPI();
     // init LEDs
-    _leds->begin();
+    _leds.begin();
     clearLEDs();
+    // from now on the display task does the output,
+    // if it can't be started refresh() does it inline
+    if (xTaskCreatePinnedToCore(displayTaskCallback, "display", DISPLAY_TASK_STACK_SIZE, this,
+                                DISPLAY_TASK_PRIORITY, &_displayTask, DISPLAY_TASK_CORE) != pdPASS)
+    {
+      _displayTask = nullptr;
+    }
   }
 
   void clearLEDs()
   {
-    _leds->clear();
-    _leds->show();
+    memset(_ledColors, 0, sizeof(_ledColors));
+    showLEDs();
   }
 
   void setLED(uint16_t ledID, uint8_t red, uint8_t green, uint8_t blue)
   {
-    _leds->setPixelColor(ledID, red, green, blue);
+    if (ledID < HAL::ledCount)
+    {
+      _ledColors[ledID][0] = red;
+      _ledColors[ledID][1] = green;
+      _ledColors[ledID][2] = blue;
+    }
   }
 
   void setAllLED(uint8_t red, uint8_t green, uint8_t blue)
   {
-    for (int i = 0; i < _ledCount; i++)
+    for (int i = 0; i < HAL::ledCount; i++)
     {
       setLED(i, red, green, blue);
     }
@@ -155,37 +218,37 @@ public:
 
   void updateLEDs()
   {
-    _leds->show();
+    showLEDs();
   }
 
-  uint8_t getDigitCount()
+  constexpr uint8_t getDigitCount() const
   {
-    return (_digitCount);
+    return (HAL::digitCount);
   }
 
-  uint8_t getDecimalPointCount()
+  constexpr uint8_t getDecimalPointCount() const
   {
-    return (_decimalPointCount);
+    return (HAL::decimalPointCount);
   }
 
-  bool hasPlusSign()
+  constexpr bool hasPlusSign() const
   {
-    return (_dispHAL->hasPlusSign());
+    return (HAL::hasPlusSign);
   }
 
-  bool hasMenuSign()
+  constexpr bool hasMenuSign() const
   {
-    return (_dispHAL->hasMenuSign());
+    return (HAL::hasMenuSign);
   }
 
-  uint8_t getLedCount()
+  constexpr uint8_t getLedCount() const
   {
-    return (_ledCount);
+    return (HAL::ledCount);
   }
 
   void setDigit(uint8_t digit, uint8_t value)
   {
-    if ((digit < _digitCount) && (digit > (-1)))
+    if ((digit < HAL::digitCount) && (digit > (-1)))
     {
       _digits[digit] = value;
     }
@@ -193,7 +256,7 @@ public:
 
   uint8_t getDigit(uint8_t digit)
   {
-    if ((digit < _digitCount) && (digit > (-1)))
+    if ((digit < HAL::digitCount) && (digit > (-1)))
     {
       return (_digits[digit]);
     }
@@ -202,12 +265,21 @@ public:
 
   void setDecimalPoint(uint8_t decimalPoint, decimal_point_state state)
   {
-    if (decimalPoint < _decimalPointCount)
+    if (decimalPoint < HAL::decimalPointCount)
     {
       _decimalPoints[decimalPoint] = state;
     }
   }
 
+  decimal_point_state getDecimalPoint(uint8_t decimalPoint)
+  {
+    if (decimalPoint < HAL::decimalPointCount)
+    {
+      return (_decimalPoints[decimalPoint]);
+    }
+    return (decimal_point_state::off);
+  }
+
   void setMinusSign(minus_sign_state state)
   {
     _minusSign = state;
@@ -223,9 +295,88 @@ public:
     _menuSign = state;
   }
 
+  // publishes the current state, the display task shifts it out
   void refresh()
   {
-    commitToRegisters();
+    buildFrame(&_frames[_backFrame]);
+    _frameSequence[_backFrame] = ++_publishedSequence;
+    if (_displayTask)
+    {
+      // swap the back buffer with the published slot, never blocks
+      _backFrame = _readyFrame.exchange(_backFrame | FRAME_PUBLISHED) & FRAME_SLOT_MASK;
+    }
+    else
+    {
+      commitToRegisters(_frames[_backFrame]);
+      setCommitted(_frameSequence[_backFrame]);
+    }
+  }
+
+  // sequence number of the last published frame
+  uint32_t getPublishedSequence()
+  {
+    return (_publishedSequence);
+  }
+
+  // sequence number of the last frame on the registers
+  uint32_t getCommittedSequence()
+  {
+    return (_committedSequence);
+  }
+
+  // micros() when the last frame went out
+  unsigned long getCommitMicros()
+  {
+    return (_commitMicros);
+  }
+
+  // number of frames shifted out to the registers
+  uint32_t getFramesCommitted() const
+  {
+    return (_framesCommitted);
+  }
+
+  // number of refreshes skipped because the frame didn't change
+  uint32_t getFramesSkipped() const
+  {
+    return (_framesSkipped);
+  }
+
+  void resetFrameCounters()
+  {
+    request(DISPLAY_REQUEST_RESET_COUNTERS);
+  }
+
+  // encodes digits, decimal points and signs into a shift register frame
+  void buildFrame(DisplayFrame *frame)
+  {
+    frame->clear();
+    for (uint8_t i = 0; i < HAL::digitCount; i++)
+    {
+      if (_digits[i] < 10)
+      {
+        frame->setRegister(_registers.getNumberRegister(i, _digits[i]));
+      }
+    }
+    for (uint8_t i = 0; i < HAL::decimalPointCount; i++)
+    {
+      if (_decimalPoints[i] == decimal_point_state::on)
+      {
+        frame->setRegister(_registers.getDecimalPointRegister(i));
+      }
+    }
+    if (_minusSign == minus_sign_state::on)
+    {
+      frame->setRegister(_registers.getMinusSignRegister());
+    }
+    if (_plusSign == plus_sign_state::on)
+    {
+      frame->setRegister(_registers.getPlusSignRegister());
+    }
+    if (_menuSign == menu_sign_state::on)
+    {
+      frame->setRegister(_registers.getMenuSignRegister());
+    }
   }
 
   void clear()
@@ -245,7 +396,7 @@ public:
 
   void clearDecimalPoints()
   {
-    for (uint8_t i = 0; i < _decimalPointCount; i++)
+    for (uint8_t i = 0; i < HAL::decimalPointCount; i++)
     {
       _decimalPoints[i] = decimal_point_state::off;
     }
@@ -253,7 +404,7 @@ public:
 
   void clearDigits()
   {
-    for (uint8_t i = 0; i < _digitCount; i++)
+    for (uint8_t i = 0; i < HAL::digitCount; i++)
     {
       _digits[i] = DIGIT_OFF;
     }
@@ -275,141 +426,256 @@ public:
   }
 
 private:
-  uint8_t _digitCount;
-  uint8_t _decimalPointCount;
-  uint8_t _ledCount;
-  display_type _displayType;
-  uint8_t *_digits;
-  decimal_point_state *_decimalPoints;
+  // digit 0 is the most left nixie
+  uint8_t _digits[HAL::digitCount];
+  // decimal points are on the right side of the digits
+  decimal_point_state _decimalPoints[HAL::decimalPointCount];
   minus_sign_state _minusSign;
   plus_sign_state _plusSign;
   menu_sign_state _menuSign;
-  bool _hasPlusSign;
   uint8_t _dataPin;
   uint8_t _storePin;
   uint8_t _shiftPin;
   uint8_t _blankPin;
   uint8_t _ledCtlPin;
-  DisplayHAL *_dispHAL;
-  Adafruit_NeoPixel *_leds;
+  Adafruit_NeoPixel _leds;
+  // register numbers, REGISTER_NONE if not connected
+  static constexpr RegisterLookup<HAL> _registers{};
+  // shift register output
+  DisplayFrame _frames[FRAME_BUFFER_COUNT];
+  uint32_t _frameSequence[FRAME_BUFFER_COUNT];
+  uint32_t _publishedSequence;
+  std::atomic<uint32_t> _committedSequence;
+  std::atomic<unsigned long> _commitMicros;
+  uint8_t _backFrame;
+  std::atomic<uint8_t> _readyFrame;
+  uint8_t _frontFrame;
+  TaskHandle_t _displayTask;
+  // LED colors (red, green, blue), written by the producer,
+  // the published copy is handed over to the display task
+  uint8_t _ledColors[HAL::ledCount][3];
+  uint8_t _publishedLedColors[HAL::ledCount][3];
+  std::atomic<bool> _ledsPending;
+  portMUX_TYPE _ledLock;
+  // DISPLAY_REQUEST bits not yet carried out
+  std::atomic<uint8_t> _requests;
+  // what the registers currently hold, only the display task
+  // touches it while it runs
+  DisplayFrame _lastFrame;
+  bool _lastFrameValid;
+  std::atomic<uint32_t> _framesCommitted;
+  std::atomic<uint32_t> _framesSkipped;
+  spi_device_handle_t _spiDevice;
+  spi_transaction_t _transaction;
+  bool _transferPending;
+  WORD_ALIGNED_ATTR uint8_t _txBuffer[FRAME_SIZE];
+
+  // sets up the SPI bus with DMA, on failure
+  // the frames are bit banged
+  void beginSPI()
+  {
+    spi_bus_config_t busConfig = {};
+    busConfig.mosi_io_num = _dataPin;
+    busConfig.miso_io_num = -1;
+    busConfig.sclk_io_num = _shiftPin;
+    busConfig.quadwp_io_num = -1;
+    busConfig.quadhd_io_num = -1;
+    busConfig.max_transfer_sz = FRAME_SIZE;
+
+    spi_device_interface_config_t deviceConfig = {};
+    deviceConfig.mode = DISPLAY_SPI_MODE;
+    deviceConfig.clock_speed_hz = DISPLAY_SPI_CLOCK;
+    deviceConfig.spics_io_num = -1;
+    deviceConfig.queue_size = 1;
+    deviceConfig.post_cb = onTransferDone;
+
+    if (spi_bus_initialize(DISPLAY_SPI_HOST, &busConfig, SPI_DMA_CH_AUTO) == ESP_OK)
+    {
+      if (spi_bus_add_device(DISPLAY_SPI_HOST, &deviceConfig, &_spiDevice) != ESP_OK)
+      {
+        _spiDevice = nullptr;
+        spi_bus_free(DISPLAY_SPI_HOST);
+      }
+    }
+  }
 
-  void commitDigitNumber(uint8_t digit, uint8_t number)
+  void endSPI()
   {
-    if (_digits[digit] == number)
+    if (_spiDevice)
     {
-      commitBit(HIGH);
+      waitForTransfer();
+      spi_bus_remove_device(_spiDevice);
+      spi_bus_free(DISPLAY_SPI_HOST);
+      _spiDevice = nullptr;
     }
-    else
+  }
+
+  void waitForTransfer()
+  {
+    spi_transaction_t *transaction;
+    if (_transferPending)
     {
-      commitBit(LOW);
+      spi_device_get_trans_result(_spiDevice, &transaction, portMAX_DELAY);
+      _transferPending = false;
     }
   }
 
-  //
-  void commitDecimalPoint(int8_t decimalPoint)
+  // called from the SPI interrupt when the frame is shifted out
+  static void onTransferDone(spi_transaction_t *transaction)
   {
-    if (_decimalPoints[decimalPoint] == decimal_point_state::off)
+    // latch the shift registers
+    gpio_set_level((gpio_num_t)(uintptr_t)transaction->user, STORE_COMMIT);
+  }
+
+  void commitBit(uint8_t value)
+  {
+    digitalWrite(_shiftPin, SHIFT_BEGIN);
+    digitalWrite(_dataPin, value);
+    // delayMicroseconds(5);
+    digitalWrite(_shiftPin, SHIFT_COMMIT);
+  }
+
+  void blankRegisters()
+  {
+    request(DISPLAY_REQUEST_BLANK);
+  }
+
+  // the display task carries it out before the next frame,
+  // without a task it is done right away
+  void request(uint8_t requests)
+  {
+    if (_displayTask)
     {
-      commitBit(LOW);
+      _requests.fetch_or(requests);
     }
     else
     {
-      commitBit(HIGH);
+      processRequests(requests);
     }
   }
 
-  void commitMinusSign()
+  void processRequests(uint8_t requests)
   {
-    if (_minusSign == minus_sign_state::off)
+    if (requests & DISPLAY_REQUEST_BLANK)
     {
-      commitBit(LOW);
+      waitForTransfer();
+      digitalWrite(_blankPin, LOW);
+      digitalWrite(_blankPin, HIGH);
+      // the registers are cleared, the next frame must be shifted out
+      _lastFrameValid = false;
     }
-    else
+    if (requests & DISPLAY_REQUEST_RESET_COUNTERS)
     {
-      commitBit(HIGH);
+      _framesCommitted = 0;
+      _framesSkipped = 0;
     }
   }
 
-  void commitPlusSign()
+  static void displayTaskCallback(void *obj)
   {
-    if (_plusSign == plus_sign_state::off)
-    {
-      commitBit(LOW);
-    }
-    else
+    ((DisplayDriver *)obj)->runDisplayTask();
+  }
+
+  // shifts out every newly published frame and updates the LEDs,
+  // at a fixed rate, independent of the main loop
+  void runDisplayTask()
+  {
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;)
     {
-      commitBit(HIGH);
+      if (_requests.load())
+      {
+        processRequests(_requests.exchange(0));
+      }
+      if (_readyFrame.load() & FRAME_PUBLISHED)
+      {
+        _frontFrame = _readyFrame.exchange(_frontFrame) & FRAME_SLOT_MASK;
+        commitToRegisters(_frames[_frontFrame]);
+        setCommitted(_frameSequence[_frontFrame]);
+      }
+      if (_ledsPending.exchange(false))
+      {
+        portENTER_CRITICAL(&_ledLock);
+        applyLEDColors(_publishedLedColors);
+        portEXIT_CRITICAL(&_ledLock);
+        _leds.show();
+      }
+      vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(DISPLAY_REFRESH_INTERVAL));
     }
   }
 
-  void commitMenuSign()
+  // unchanged frames count as well, the registers already show them
+  void setCommitted(uint32_t sequence)
+  {
+    _commitMicros = micros();
+    _committedSequence = sequence;
+  }
+
+  void showLEDs()
   {
-    if (_menuSign == menu_sign_state::off)
+    if (_displayTask)
     {
-      commitBit(LOW);
+      portENTER_CRITICAL(&_ledLock);
+      memcpy(_publishedLedColors, _ledColors, sizeof(_ledColors));
+      portEXIT_CRITICAL(&_ledLock);
+      _ledsPending = true;
     }
     else
     {
-      commitBit(HIGH);
+      applyLEDColors(_ledColors);
+      _leds.show();
     }
   }
 
-  void commitBit(uint8_t value)
-  {
-    digitalWrite(_shiftPin, SHIFT_BEGIN);
-    digitalWrite(_dataPin, value);
-    // delayMicroseconds(5);
-    digitalWrite(_shiftPin, SHIFT_COMMIT);
-  }
-
-  void blankRegisters()
+  void applyLEDColors(const uint8_t colors[HAL::ledCount][3])
   {
-    digitalWrite(_blankPin, LOW);
-    digitalWrite(_blankPin, HIGH);
+    for (uint16_t i = 0; i < HAL::ledCount; i++)
+    {
+      _leds.setPixelColor(i, colors[i][0], colors[i][1], colors[i][2]);
+    }
   }
 
   // commits digits, decimal points and negative/plus sign to shift registers
-  void commitToRegisters()
+  void commitToRegisters(const DisplayFrame &frame)
   {
-    register_type regType;
-    uint8_t digit = 0;
-    uint8_t number = 0;
-    digitalWrite(_storePin, STORE_BEGIN);
+    if (_lastFrameValid && (frame == _lastFrame))
+    {
+      // the registers already show this frame
+      _framesSkipped++;
+      return;
+    }
+    _lastFrame = frame;
+    _lastFrameValid = true;
+    _framesCommitted++;
 
-    for (uint8_t i = REGISTER_COUNT; i > 0; i--)
+    if (_spiDevice)
     {
-      regType = _dispHAL->getRegisterInfo(i, &digit, &number);
-      switch (regType)
+      // the previous frame must be out before the buffer is reused
+      waitForTransfer();
+      memcpy(_txBuffer, frame.getData(), FRAME_SIZE);
+      digitalWrite(_storePin, STORE_BEGIN);
+      memset(&_transaction, 0, sizeof(_transaction));
+      _transaction.length = FRAME_SIZE * 8;
+      _transaction.tx_buffer = _txBuffer;
+      _transaction.user = (void *)(uintptr_t)_storePin;
+      if (spi_device_queue_trans(_spiDevice, &_transaction, portMAX_DELAY) == ESP_OK)
       {
-      case register_type::unknown:
-        break;
-
-      case register_type::minus_sign:
-        commitMinusSign();
-        break;
-
-      case register_type::plus_sign:
-        commitPlusSign();
-        break;
-
-      case register_type::menu_sign:
-        commitMenuSign();
-        break;
-
-      case register_type::decimal_point:
-        commitDecimalPoint(digit);
-        break;
-
-      case register_type::number:
-        commitDigitNumber(digit, number);
-        break;
-
-      case register_type::not_used:
-      case register_type::not_connected:
-        commitBit(LOW);
-        break;
+        _transferPending = true;
+      }
+      else
+      {
+        // not shifted out, try again on the next refresh
+        _lastFrameValid = false;
+      }
+    }
+    else
+    {
+      digitalWrite(_storePin, STORE_BEGIN);
+      for (uint8_t i = 0; i < REGISTER_COUNT; i++)
+      {
+        commitBit(frame.getBit(i) ? HIGH : LOW);
       }
+      digitalWrite(_storePin, STORE_COMMIT);
     }
-    digitalWrite(_storePin, STORE_COMMIT);
   }
 };
\ No newline at end of file
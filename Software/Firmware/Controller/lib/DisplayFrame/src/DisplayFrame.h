@@ -0,0 +1,78 @@
+// DisplayFrame.h
+
+// holds the state of all shift register outputs
+// packed in shift order: the first byte is shifted out first,
+// most significant bit first, starting with the last register
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <DisplayHAL.h>
+
+#define FRAME_SIZE (REGISTER_COUNT / 8)
+
+static_assert(REGISTER_COUNT % 8 == 0, "Register count must fill complete bytes!");
+
+class DisplayFrame
+{
+public:
+  DisplayFrame()
+  {
+    clear();
+  }
+
+  virtual ~DisplayFrame()
+  {
+  }
+
+  void clear()
+  {
+    memset(_data, 0, FRAME_SIZE);
+  }
+
+  // register numbers from 1 to REGISTER_COUNT, as used by the HALs
+  void setRegister(uint8_t registerNumber)
+  {
+    if ((registerNumber > 0) && (registerNumber <= REGISTER_COUNT))
+    {
+      uint8_t position = REGISTER_COUNT - registerNumber;
+      _data[position / 8] |= (0x80 >> (position % 8));
+    }
+  }
+
+  bool getRegister(uint8_t registerNumber) const
+  {
+    if ((registerNumber > 0) && (registerNumber <= REGISTER_COUNT))
+    {
+      return (getBit(REGISTER_COUNT - registerNumber));
+    }
+    return (false);
+  }
+
+  // bit in shift order, 0 is shifted out first
+  bool getBit(uint8_t position) const
+  {
+    return ((_data[position / 8] & (0x80 >> (position % 8))) != 0);
+  }
+
+  const uint8_t *getData() const
+  {
+    return (_data);
+  }
+
+  bool operator==(const DisplayFrame &other) const
+  {
+    return (memcmp(_data, other._data, FRAME_SIZE) == 0);
+  }
+
+  bool operator!=(const DisplayFrame &other) const
+  {
+    return (!(*this == other));
+  }
+
+private:
+  uint8_t _data[FRAME_SIZE];
+};
@@ -5,6 +5,9 @@
 // and driver boards.
 // IN-12, IN-16, IN-17 and B-5870
 
+// the HAL is selected at compile time,
+// tables are checked by static_assert
+
 // Copyright (C) 2023 highvoltglow
 // Licensed under the MIT License
 
@@ -13,6 +16,8 @@
 #include <Arduino.h>
 
 #define REGISTER_COUNT 160
+// register numbers start at 1
+#define REGISTER_NONE 0
 
 enum class register_type : uint8_t
 {
@@ -39,25 +44,188 @@ typedef struct
   uint8_t number;
 } TRANSLATION_TABLE_ENTRY;
 
-class DisplayHAL
+// what is connected to each shift register output,
+// index 0 is register number 1
+typedef struct
+{
+  TRANSLATION_TABLE_ENTRY entries[REGISTER_COUNT];
+} TRANSLATION_TABLE;
+
+// a HAL is a class with compile time constants only,
+// the translation table is constexpr and ends up in flash
+//
+// static constexpr uint8_t digitCount;
+// static constexpr uint8_t decimalPointCount;
+// static constexpr uint8_t ledCount;
+// static constexpr bool hasPlusSign;
+// static constexpr bool hasMenuSign;
+// static constexpr bool hasLedPerDigit; (LED for each nixie)
+// static constexpr led_type ledType;
+// static const TRANSLATION_TABLE translationTable;
+
+// every register must be described
+template <class HAL>
+constexpr bool isTranslationTableComplete()
+{
+  for (uint16_t i = 0; i < REGISTER_COUNT; i++)
+  {
+    if (HAL::translationTable.entries[i].rt == register_type::unknown)
+    {
+      return (false);
+    }
+  }
+  return (true);
+}
+
+// every digit must have its 10 numbers and every decimal point
+// must be connected, each of them exactly once
+template <class HAL>
+constexpr bool areDigitsComplete()
+{
+  uint8_t numbers[HAL::digitCount][10] = {};
+  uint8_t decimalPoints[HAL::decimalPointCount] = {};
+
+  for (uint16_t i = 0; i < REGISTER_COUNT; i++)
+  {
+    const TRANSLATION_TABLE_ENTRY &entry = HAL::translationTable.entries[i];
+    if (entry.rt == register_type::number)
+    {
+      if ((entry.digit >= HAL::digitCount) || (entry.number > 9))
+      {
+        return (false);
+      }
+      numbers[entry.digit][entry.number]++;
+    }
+    else if (entry.rt == register_type::decimal_point)
+    {
+      if (entry.digit >= HAL::decimalPointCount)
+      {
+        return (false);
+      }
+      decimalPoints[entry.digit]++;
+    }
+  }
+  for (uint8_t digit = 0; digit < HAL::digitCount; digit++)
+  {
+    for (uint8_t number = 0; number < 10; number++)
+    {
+      if (numbers[digit][number] != 1)
+      {
+        return (false);
+      }
+    }
+  }
+  for (uint8_t decimalPoint = 0; decimalPoint < HAL::decimalPointCount; decimalPoint++)
+  {
+    if (decimalPoints[decimalPoint] != 1)
+    {
+      return (false);
+    }
+  }
+  return (true);
+}
+
+template <class HAL>
+constexpr uint8_t countRegisters(register_type rt)
+{
+  uint8_t count = 0;
+  for (uint16_t i = 0; i < REGISTER_COUNT; i++)
+  {
+    if (HAL::translationTable.entries[i].rt == rt)
+    {
+      count++;
+    }
+  }
+  return (count);
+}
+
+// instantiating this class validates a HAL at compile time
+template <class HAL>
+class DisplayHALCheck
+{
+  static_assert(isTranslationTableComplete<HAL>(), "Translation table has undefined registers!");
+  static_assert(areDigitsComplete<HAL>(), "Translation table has missing, duplicate or invalid digit registers!");
+  static_assert(countRegisters<HAL>(register_type::minus_sign) == 1, "Translation table needs exactly one minus sign!");
+  static_assert(countRegisters<HAL>(register_type::plus_sign) == (HAL::hasPlusSign ? 1 : 0), "Translation table doesn't match the plus sign setting!");
+  static_assert(countRegisters<HAL>(register_type::menu_sign) == (HAL::hasMenuSign ? 1 : 0), "Translation table doesn't match the menu sign setting!");
+  static_assert(HAL::ledCount > 0, "At least one LED is required!");
+
+public:
+  static constexpr bool valid = true;
+};
+
+// inverse of the translation table, computed at compile time,
+// the frame encoder only visits the lit elements
+template <class HAL>
+class RegisterLookup
 {
 public:
-  DisplayHAL()
+  constexpr RegisterLookup() : _numberRegisters{},
+                               _decimalPointRegisters{},
+                               _minusSignRegister(REGISTER_NONE),
+                               _plusSignRegister(REGISTER_NONE),
+                               _menuSignRegister(REGISTER_NONE)
+  {
+    for (uint8_t i = REGISTER_COUNT; i > 0; i--)
+    {
+      const TRANSLATION_TABLE_ENTRY &entry = HAL::translationTable.entries[i - 1];
+      switch (entry.rt)
+      {
+      case register_type::minus_sign:
+        _minusSignRegister = i;
+        break;
+
+      case register_type::plus_sign:
+        _plusSignRegister = i;
+        break;
+
+      case register_type::menu_sign:
+        _menuSignRegister = i;
+        break;
+
+      case register_type::decimal_point:
+        _decimalPointRegisters[entry.digit] = i;
+        break;
+
+      case register_type::number:
+        _numberRegisters[entry.digit][entry.number] = i;
+        break;
+
+      default:
+        break;
+      }
+    }
+  }
+
+  constexpr uint8_t getNumberRegister(uint8_t digit, uint8_t number) const
+  {
+    return (_numberRegisters[digit][number]);
+  }
+
+  constexpr uint8_t getDecimalPointRegister(uint8_t decimalPoint) const
+  {
+    return (_decimalPointRegisters[decimalPoint]);
+  }
+
+  constexpr uint8_t getMinusSignRegister() const
+  {
+    return (_minusSignRegister);
+  }
+
+  constexpr uint8_t getPlusSignRegister() const
   {
+    return (_plusSignRegister);
   }
 
-  virtual ~DisplayHAL()
+  constexpr uint8_t getMenuSignRegister() const
   {
+    return (_menuSignRegister);
   }
 
-  // returns information about what is connected to a specific shift register output
-  virtual register_type getRegisterInfo(uint8_t registerNumber, uint8_t *digit, uint8_t *number) = 0;
-  virtual uint8_t getDigitCount() = 0;
-  virtual uint8_t getDecimalPointCount() = 0;
-  virtual bool hasPlusSign() = 0;
-  virtual bool hasMenuSign() = 0;
-  virtual uint8_t getLEDCount() = 0;
-  // indicates if there is a LED for each nixie
-  virtual bool hasLedPerDigit() = 0;
-  virtual led_type getLedType() = 0;
+private:
+  uint8_t _numberRegisters[HAL::digitCount][10];
+  uint8_t _decimalPointRegisters[HAL::decimalPointCount];
+  uint8_t _minusSignRegister;
+  uint8_t _plusSignRegister;
+  uint8_t _menuSignRegister;
 };
@@ -9,80 +9,26 @@
 #pragma once
 
 #include <Arduino.h>
-#include <displayHAL.h>
+#include <DisplayHAL.h>
 
 #define IN16_DIGITCOUNT 14
 #define IN16_DECIMALPOINTCOUNT 14
 #define IN16_LEDCOUNT 14
 
-class DisplayHAL_IN16 : public DisplayHAL
+class DisplayHAL_IN16
 {
 public:
-	DisplayHAL_IN16()
-	{
-		initTranslationTable();
-	}
-
-	virtual ~DisplayHAL_IN16()
-	{
-		free(_translationTable);
-	}
-
-	uint8_t getDigitCount()
-	{
-		return (IN16_DIGITCOUNT);
-	}
-
-	uint8_t getDecimalPointCount()
-	{
-		return (IN16_DECIMALPOINTCOUNT);
-	}
-
-	uint8_t getLEDCount()
-	{
-		return (IN16_LEDCOUNT);
-	}
-
-	bool hasPlusSign()
-	{
-		return (false);
-	}
-
-	bool hasMenuSign()
-	{
-		return (false);
-	}
-
-	bool hasLedPerDigit()
-	{
-		return (true);
-	}
-
-	led_type getLedType()
-	{
-		return (led_type::smd);
-	}
-
-	// returns information about what is connected to a specific shift register output
-	register_type getRegisterInfo(uint8_t registerNumber, uint8_t *digit, uint8_t *number)
-	{
-		*digit = 0;
-		*number = 0;
-
-		register_type regType;
-
-		if ((registerNumber < 1) || (registerNumber > REGISTER_COUNT))
-		{
-			regType = register_type::unknown;
-		}
-		else
-		{
-			regType = _translationTable[registerNumber - 1].rt;
-			*digit = _translationTable[registerNumber - 1].digit;
-			*number = _translationTable[registerNumber - 1].number;
-		}
-		return (regType);
-	}
+	static constexpr uint8_t digitCount = IN16_DIGITCOUNT;
+	static constexpr uint8_t decimalPointCount = IN16_DECIMALPOINTCOUNT;
+	static constexpr uint8_t ledCount = IN16_LEDCOUNT;
+	static constexpr bool hasPlusSign = false;
+	static constexpr bool hasMenuSign = false;
+	// indicates if there is a LED for each nixie
+	static constexpr bool hasLedPerDigit = true;
+	static constexpr led_type ledType = led_type::smd;
+
+	// what is connected to each shift register output, stored in flash
+	static const TRANSLATION_TABLE translationTable;
 
 private:
 	// translation table
@@ -103,171 +49,173 @@ private:
 	// N13 --> 12
 	// N14 --> 13
 
-	void initTranslationTable()
+	static constexpr TRANSLATION_TABLE initTranslationTable()
 	{
-		_translationTable = (TRANSLATION_TABLE_ENTRY *)malloc(sizeof(TRANSLATION_TABLE_ENTRY) * REGISTER_COUNT);
-		_translationTable[0] = {register_type::number, 0, 0};
-		_translationTable[1] = {register_type::number, 0, 1};
-		_translationTable[2] = {register_type::number, 0, 2};
-		_translationTable[3] = {register_type::number, 0, 3};
-		_translationTable[4] = {register_type::number, 0, 4};
-		_translationTable[5] = {register_type::number, 0, 5};
-		_translationTable[6] = {register_type::number, 0, 6};
-		_translationTable[7] = {register_type::number, 0, 7};
-		_translationTable[8] = {register_type::number, 0, 8};
-		_translationTable[9] = {register_type::number, 0, 9};
-		_translationTable[10] = {register_type::decimal_point, 0, 0};
-		_translationTable[11] = {register_type::number, 1, 0};
-		_translationTable[12] = {register_type::number, 1, 1};
-		_translationTable[13] = {register_type::number, 1, 2};
-		_translationTable[14] = {register_type::number, 1, 3};
-		_translationTable[15] = {register_type::number, 1, 4};
-		_translationTable[16] = {register_type::number, 1, 5};
-		_translationTable[17] = {register_type::number, 1, 6};
-		_translationTable[18] = {register_type::number, 1, 7};
-		_translationTable[19] = {register_type::number, 1, 8};
-		_translationTable[20] = {register_type::number, 1, 9};
-		_translationTable[21] = {register_type::decimal_point, 1, 0};
-		_translationTable[22] = {register_type::number, 2, 0};
-		_translationTable[23] = {register_type::number, 2, 1};
-		_translationTable[24] = {register_type::number, 2, 2};
-		_translationTable[25] = {register_type::number, 2, 3};
-		_translationTable[26] = {register_type::number, 2, 4};
-		_translationTable[27] = {register_type::number, 2, 5};
-		_translationTable[28] = {register_type::number, 2, 6};
-		_translationTable[29] = {register_type::number, 2, 7};
-		_translationTable[30] = {register_type::number, 2, 8};
-		_translationTable[31] = {register_type::number, 2, 9};
-		_translationTable[32] = {register_type::decimal_point, 2, 0};
-		_translationTable[33] = {register_type::number, 3, 0};
-		_translationTable[34] = {register_type::number, 3, 1};
-		_translationTable[35] = {register_type::number, 3, 2};
-		_translationTable[36] = {register_type::number, 3, 3};
-		_translationTable[37] = {register_type::number, 3, 4};
-		_translationTable[38] = {register_type::number, 3, 5};
-		_translationTable[39] = {register_type::number, 3, 6};
-		_translationTable[40] = {register_type::number, 3, 7};
-		_translationTable[41] = {register_type::number, 3, 8};
-		_translationTable[42] = {register_type::number, 3, 9};
-		_translationTable[43] = {register_type::decimal_point, 3, 0};
-		_translationTable[44] = {register_type::number, 4, 0};
-		_translationTable[45] = {register_type::number, 4, 1};
-		_translationTable[46] = {register_type::number, 4, 2};
-		_translationTable[47] = {register_type::number, 4, 3};
-		_translationTable[48] = {register_type::number, 4, 4};
-		_translationTable[49] = {register_type::number, 4, 5};
-		_translationTable[50] = {register_type::number, 4, 6};
-		_translationTable[51] = {register_type::number, 4, 7};
-		_translationTable[52] = {register_type::number, 4, 8};
-		_translationTable[53] = {register_type::number, 4, 9};
-		_translationTable[54] = {register_type::decimal_point, 4, 0};
-		_translationTable[55] = {register_type::number, 5, 0};
-		_translationTable[56] = {register_type::number, 5, 1};
-		_translationTable[57] = {register_type::number, 5, 2};
-		_translationTable[58] = {register_type::number, 5, 3};
-		_translationTable[59] = {register_type::number, 5, 4};
-		_translationTable[60] = {register_type::number, 5, 5};
-		_translationTable[61] = {register_type::number, 5, 6};
-		_translationTable[62] = {register_type::number, 5, 7};
-		_translationTable[63] = {register_type::number, 5, 8};
-		_translationTable[64] = {register_type::number, 5, 9};
-		_translationTable[65] = {register_type::decimal_point, 5, 0};
-		_translationTable[66] = {register_type::number, 6, 0};
-		_translationTable[67] = {register_type::number, 6, 1};
-		_translationTable[68] = {register_type::number, 6, 2};
-		_translationTable[69] = {register_type::number, 6, 3};
-		_translationTable[70] = {register_type::number, 6, 4};
-		_translationTable[71] = {register_type::number, 6, 5};
-		_translationTable[72] = {register_type::number, 6, 6};
-		_translationTable[73] = {register_type::number, 6, 7};
-		_translationTable[74] = {register_type::number, 6, 8};
-		_translationTable[75] = {register_type::number, 6, 9};
-		_translationTable[76] = {register_type::decimal_point, 6, 0};
-		_translationTable[77] = {register_type::number, 7, 0};
-		_translationTable[78] = {register_type::number, 7, 1};
-		_translationTable[79] = {register_type::number, 7, 2};
-		_translationTable[80] = {register_type::number, 7, 3};
-		_translationTable[81] = {register_type::number, 7, 4};
-		_translationTable[82] = {register_type::number, 7, 5};
-		_translationTable[83] = {register_type::number, 7, 6};
-		_translationTable[84] = {register_type::number, 7, 7};
-		_translationTable[85] = {register_type::number, 7, 8};
-		_translationTable[86] = {register_type::number, 7, 9};
-		_translationTable[87] = {register_type::decimal_point, 7, 0};
-		_translationTable[88] = {register_type::number, 8, 0};
-		_translationTable[89] = {register_type::number, 8, 1};
-		_translationTable[90] = {register_type::number, 8, 2};
-		_translationTable[91] = {register_type::number, 8, 3};
-		_translationTable[92] = {register_type::number, 8, 4};
-		_translationTable[93] = {register_type::number, 8, 5};
-		_translationTable[94] = {register_type::number, 8, 6};
-		_translationTable[95] = {register_type::number, 8, 7};
-		_translationTable[96] = {register_type::number, 8, 8};
-		_translationTable[97] = {register_type::number, 8, 9};
-		_translationTable[98] = {register_type::decimal_point, 8, 0};
-		_translationTable[99] = {register_type::number, 9, 0};
-		_translationTable[100] = {register_type::number, 9, 1};
-		_translationTable[101] = {register_type::number, 9, 2};
-		_translationTable[102] = {register_type::number, 9, 3};
-		_translationTable[103] = {register_type::number, 9, 4};
-		_translationTable[104] = {register_type::number, 9, 5};
-		_translationTable[105] = {register_type::number, 9, 6};
-		_translationTable[106] = {register_type::number, 9, 7};
-		_translationTable[107] = {register_type::number, 9, 8};
-		_translationTable[108] = {register_type::number, 9, 9};
-		_translationTable[109] = {register_type::decimal_point, 9, 0};
-		_translationTable[110] = {register_type::number, 10, 0};
-		_translationTable[111] = {register_type::number, 10, 1};
-		_translationTable[112] = {register_type::number, 10, 2};
-		_translationTable[113] = {register_type::number, 10, 3};
-		_translationTable[114] = {register_type::number, 10, 4};
-		_translationTable[115] = {register_type::number, 10, 5};
-		_translationTable[116] = {register_type::number, 10, 6};
-		_translationTable[117] = {register_type::number, 10, 7};
-		_translationTable[118] = {register_type::number, 10, 8};
-		_translationTable[119] = {register_type::number, 10, 9};
-		_translationTable[120] = {register_type::decimal_point, 10, 0};
-		_translationTable[121] = {register_type::number, 11, 0};
-		_translationTable[122] = {register_type::number, 11, 1};
-		_translationTable[123] = {register_type::number, 11, 2};
-		_translationTable[124] = {register_type::number, 11, 3};
-		_translationTable[125] = {register_type::number, 11, 4};
-		_translationTable[126] = {register_type::number, 11, 5};
-		_translationTable[127] = {register_type::number, 11, 6};
-		_translationTable[128] = {register_type::number, 11, 7};
-		_translationTable[129] = {register_type::number, 11, 8};
-		_translationTable[130] = {register_type::number, 11, 9};
-		_translationTable[131] = {register_type::decimal_point, 11, 0};
-		_translationTable[132] = {register_type::number, 12, 0};
-		_translationTable[133] = {register_type::number, 12, 1};
-		_translationTable[134] = {register_type::number, 12, 2};
-		_translationTable[135] = {register_type::number, 12, 3};
-		_translationTable[136] = {register_type::number, 12, 4};
-		_translationTable[137] = {register_type::number, 12, 5};
-		_translationTable[138] = {register_type::number, 12, 6};
-		_translationTable[139] = {register_type::number, 12, 7};
-		_translationTable[140] = {register_type::number, 12, 8};
-		_translationTable[141] = {register_type::number, 12, 9};
-		_translationTable[142] = {register_type::decimal_point, 12, 0};
-		_translationTable[143] = {register_type::number, 13, 0};
-		_translationTable[144] = {register_type::number, 13, 1};
-		_translationTable[145] = {register_type::number, 13, 2};
-		_translationTable[146] = {register_type::number, 13, 3};
-		_translationTable[147] = {register_type::number, 13, 4};
-		_translationTable[148] = {register_type::number, 13, 5};
-		_translationTable[149] = {register_type::number, 13, 6};
-		_translationTable[150] = {register_type::number, 13, 7};
-		_translationTable[151] = {register_type::number, 13, 8};
-		_translationTable[152] = {register_type::number, 13, 9};
-		_translationTable[153] = {register_type::decimal_point, 13, 0};
-		_translationTable[154] = {register_type::minus_sign, 0, 0};
-		_translationTable[155] = {register_type::not_connected, 0, 0};
-		_translationTable[156] = {register_type::not_connected, 0, 0};
-		_translationTable[157] = {register_type::not_connected, 0, 0};
-		_translationTable[158] = {register_type::not_connected, 0, 0};
-		_translationTable[159] = {register_type::not_connected, 0, 0};
+		TRANSLATION_TABLE table = {};
+		table.entries[0] = {register_type::number, 0, 0};
+		table.entries[1] = {register_type::number, 0, 1};
+		table.entries[2] = {register_type::number, 0, 2};
+		table.entries[3] = {register_type::number, 0, 3};
+		table.entries[4] = {register_type::number, 0, 4};
+		table.entries[5] = {register_type::number, 0, 5};
+		table.entries[6] = {register_type::number, 0, 6};
+		table.entries[7] = {register_type::number, 0, 7};
+		table.entries[8] = {register_type::number, 0, 8};
+		table.entries[9] = {register_type::number, 0, 9};
+		table.entries[10] = {register_type::decimal_point, 0, 0};
+		table.entries[11] = {register_type::number, 1, 0};
+		table.entries[12] = {register_type::number, 1, 1};
+		table.entries[13] = {register_type::number, 1, 2};
+		table.entries[14] = {register_type::number, 1, 3};
+		table.entries[15] = {register_type::number, 1, 4};
+		table.entries[16] = {register_type::number, 1, 5};
+		table.entries[17] = {register_type::number, 1, 6};
+		table.entries[18] = {register_type::number, 1, 7};
+		table.entries[19] = {register_type::number, 1, 8};
+		table.entries[20] = {register_type::number, 1, 9};
+		table.entries[21] = {register_type::decimal_point, 1, 0};
+		table.entries[22] = {register_type::number, 2, 0};
+		table.entries[23] = {register_type::number, 2, 1};
+		table.entries[24] = {register_type::number, 2, 2};
+		table.entries[25] = {register_type::number, 2, 3};
+		table.entries[26] = {register_type::number, 2, 4};
+		table.entries[27] = {register_type::number, 2, 5};
+		table.entries[28] = {register_type::number, 2, 6};
+		table.entries[29] = {register_type::number, 2, 7};
+		table.entries[30] = {register_type::number, 2, 8};
+		table.entries[31] = {register_type::number, 2, 9};
+		table.entries[32] = {register_type::decimal_point, 2, 0};
+		table.entries[33] = {register_type::number, 3, 0};
+		table.entries[34] = {register_type::number, 3, 1};
+		table.entries[35] = {register_type::number, 3, 2};
+		table.entries[36] = {register_type::number, 3, 3};
+		table.entries[37] = {register_type::number, 3, 4};
+		table.entries[38] = {register_type::number, 3, 5};
+		table.entries[39] = {register_type::number, 3, 6};
+		table.entries[40] = {register_type::number, 3, 7};
+		table.entries[41] = {register_type::number, 3, 8};
+		table.entries[42] = {register_type::number, 3, 9};
+		table.entries[43] = {register_type::decimal_point, 3, 0};
+		table.entries[44] = {register_type::number, 4, 0};
+		table.entries[45] = {register_type::number, 4, 1};
+		table.entries[46] = {register_type::number, 4, 2};
+		table.entries[47] = {register_type::number, 4, 3};
+		table.entries[48] = {register_type::number, 4, 4};
+		table.entries[49] = {register_type::number, 4, 5};
+		table.entries[50] = {register_type::number, 4, 6};
+		table.entries[51] = {register_type::number, 4, 7};
+		table.entries[52] = {register_type::number, 4, 8};
+		table.entries[53] = {register_type::number, 4, 9};
+		table.entries[54] = {register_type::decimal_point, 4, 0};
+		table.entries[55] = {register_type::number, 5, 0};
+		table.entries[56] = {register_type::number, 5, 1};
+		table.entries[57] = {register_type::number, 5, 2};
+		table.entries[58] = {register_type::number, 5, 3};
+		table.entries[59] = {register_type::number, 5, 4};
+		table.entries[60] = {register_type::number, 5, 5};
+		table.entries[61] = {register_type::number, 5, 6};
+		table.entries[62] = {register_type::number, 5, 7};
+		table.entries[63] = {register_type::number, 5, 8};
+		table.entries[64] = {register_type::number, 5, 9};
+		table.entries[65] = {register_type::decimal_point, 5, 0};
+		table.entries[66] = {register_type::number, 6, 0};
+		table.entries[67] = {register_type::number, 6, 1};
+		table.entries[68] = {register_type::number, 6, 2};
+		table.entries[69] = {register_type::number, 6, 3};
+		table.entries[70] = {register_type::number, 6, 4};
+		table.entries[71] = {register_type::number, 6, 5};
+		table.entries[72] = {register_type::number, 6, 6};
+		table.entries[73] = {register_type::number, 6, 7};
+		table.entries[74] = {register_type::number, 6, 8};
+		table.entries[75] = {register_type::number, 6, 9};
+		table.entries[76] = {register_type::decimal_point, 6, 0};
+		table.entries[77] = {register_type::number, 7, 0};
+		table.entries[78] = {register_type::number, 7, 1};
+		table.entries[79] = {register_type::number, 7, 2};
+		table.entries[80] = {register_type::number, 7, 3};
+		table.entries[81] = {register_type::number, 7, 4};
+		table.entries[82] = {register_type::number, 7, 5};
+		table.entries[83] = {register_type::number, 7, 6};
+		table.entries[84] = {register_type::number, 7, 7};
+		table.entries[85] = {register_type::number, 7, 8};
+		table.entries[86] = {register_type::number, 7, 9};
+		table.entries[87] = {register_type::decimal_point, 7, 0};
+		table.entries[88] = {register_type::number, 8, 0};
+		table.entries[89] = {register_type::number, 8, 1};
+		table.entries[90] = {register_type::number, 8, 2};
+		table.entries[91] = {register_type::number, 8, 3};
+		table.entries[92] = {register_type::number, 8, 4};
+		table.entries[93] = {register_type::number, 8, 5};
+		table.entries[94] = {register_type::number, 8, 6};
+		table.entries[95] = {register_type::number, 8, 7};
+		table.entries[96] = {register_type::number, 8, 8};
+		table.entries[97] = {register_type::number, 8, 9};
+		table.entries[98] = {register_type::decimal_point, 8, 0};
+		table.entries[99] = {register_type::number, 9, 0};
+		table.entries[100] = {register_type::number, 9, 1};
+		table.entries[101] = {register_type::number, 9, 2};
+		table.entries[102] = {register_type::number, 9, 3};
+		table.entries[103] = {register_type::number, 9, 4};
+		table.entries[104] = {register_type::number, 9, 5};
+		table.entries[105] = {register_type::number, 9, 6};
+		table.entries[106] = {register_type::number, 9, 7};
+		table.entries[107] = {register_type::number, 9, 8};
+		table.entries[108] = {register_type::number, 9, 9};
+		table.entries[109] = {register_type::decimal_point, 9, 0};
+		table.entries[110] = {register_type::number, 10, 0};
+		table.entries[111] = {register_type::number, 10, 1};
+		table.entries[112] = {register_type::number, 10, 2};
+		table.entries[113] = {register_type::number, 10, 3};
+		table.entries[114] = {register_type::number, 10, 4};
+		table.entries[115] = {register_type::number, 10, 5};
+		table.entries[116] = {register_type::number, 10, 6};
+		table.entries[117] = {register_type::number, 10, 7};
+		table.entries[118] = {register_type::number, 10, 8};
+		table.entries[119] = {register_type::number, 10, 9};
+		table.entries[120] = {register_type::decimal_point, 10, 0};
+		table.entries[121] = {register_type::number, 11, 0};
+		table.entries[122] = {register_type::number, 11, 1};
+		table.entries[123] = {register_type::number, 11, 2};
+		table.entries[124] = {register_type::number, 11, 3};
+		table.entries[125] = {register_type::number, 11, 4};
+		table.entries[126] = {register_type::number, 11, 5};
+		table.entries[127] = {register_type::number, 11, 6};
+		table.entries[128] = {register_type::number, 11, 7};
+		table.entries[129] = {register_type::number, 11, 8};
+		table.entries[130] = {register_type::number, 11, 9};
+		table.entries[131] = {register_type::decimal_point, 11, 0};
+		table.entries[132] = {register_type::number, 12, 0};
+		table.entries[133] = {register_type::number, 12, 1};
+		table.entries[134] = {register_type::number, 12, 2};
+		table.entries[135] = {register_type::number, 12, 3};
+		table.entries[136] = {register_type::number, 12, 4};
+		table.entries[137] = {register_type::number, 12, 5};
+		table.entries[138] = {register_type::number, 12, 6};
+		table.entries[139] = {register_type::number, 12, 7};
+		table.entries[140] = {register_type::number, 12, 8};
+		table.entries[141] = {register_type::number, 12, 9};
+		table.entries[142] = {register_type::decimal_point, 12, 0};
+		table.entries[143] = {register_type::number, 13, 0};
+		table.entries[144] = {register_type::number, 13, 1};
+		table.entries[145] = {register_type::number, 13, 2};
+		table.entries[146] = {register_type::number, 13, 3};
+		table.entries[147] = {register_type::number, 13, 4};
+		table.entries[148] = {register_type::number, 13, 5};
+		table.entries[149] = {register_type::number, 13, 6};
+		table.entries[150] = {register_type::number, 13, 7};
+		table.entries[151] = {register_type::number, 13, 8};
+		table.entries[152] = {register_type::number, 13, 9};
+		table.entries[153] = {register_type::decimal_point, 13, 0};
+		table.entries[154] = {register_type::minus_sign, 0, 0};
+		table.entries[155] = {register_type::not_connected, 0, 0};
+		table.entries[156] = {register_type::not_connected, 0, 0};
+		table.entries[157] = {register_type::not_connected, 0, 0};
+		table.entries[158] = {register_type::not_connected, 0, 0};
+		table.entries[159] = {register_type::not_connected, 0, 0};
+		return (table);
 	}
-
-private:
-	TRANSLATION_TABLE_ENTRY *_translationTable;
 };
+
+inline constexpr TRANSLATION_TABLE DisplayHAL_IN16::translationTable = DisplayHAL_IN16::initTranslationTable();
+
+static_assert(DisplayHALCheck<DisplayHAL_IN16>::valid, "Invalid IN-16 translation table!");
@@ -1,6 +1,7 @@
 // DisplayHandler.h
 
 // provides formatting und display functions
+// and non-blocking display animations
 
 // Copyright (C) 2023 highvoltglow
 // Licensed under the MIT License
@@ -9,24 +10,41 @@
 
 #include <Arduino.h>
 #include <DisplayDriver.h>
+#include <NumberFormatter.h>
 
-class DisplayHandler : public DisplayDriver
+// default time between two animation frames in ms
+#define ANIMATION_INTERVAL 75
+
+enum class animation_type : uint8_t
+{
+  none,
+  scroll_out,
+  digit_cycle
+};
+
+class DisplayHandler : public DisplayDriver<DISPLAY_TYPE>
 {
 public:
-  using DisplayDriver::DisplayDriver;
+  using DisplayDriver<DISPLAY_TYPE>::DisplayDriver;
 
   void show()
   {
     refresh();
   }
 
-  void show(char *buffer)
+  void show(const char *buffer)
   {
-    String s = buffer;
-    show(s);
+    show(buffer, strlen(buffer));
   }
 
   void show(const String &s, bool leftZeroPadding = false)
+  {
+    show(s.c_str(), s.length(), leftZeroPadding);
+  }
+
+  // shows length characters of s, digits are filled in from the right,
+  // the tubes have no letters, A to F light 0 to 5 and the decimal point
+  void show(const char *s, uint8_t length, bool leftZeroPadding = false)
   {
     bool prevDot = false;
 
@@ -40,12 +58,20 @@ public:
       }
     }
     int digit = getDigitCount() - 1;
-    for (int i = s.length() - 1; i >= 0; i--)
+    for (int i = length - 1; i >= 0; i--)
     {
       switch (s[i])
       {
       case '-':
-        setMinusSign(minus_sign_state::on);
+        if ((i > 0) && (s[i - 1] == FORMAT_EXPONENT_MARK))
+        {
+          // negative exponent, the decimal point of the blank tube
+          setDecimalPoint(digit, decimal_point_state::on);
+        }
+        else
+        {
+          setMinusSign(minus_sign_state::on);
+        }
         prevDot = false;
         break;
 
@@ -78,6 +104,19 @@ public:
         prevDot = false;
         break;
 
+      case 'A':
+      case 'B':
+      case 'C':
+      case 'D':
+      case 'E':
+      case 'F':
+        // HEX digits, 0 to 5 with the decimal point of the tube
+        setDigit(digit, s[i] - 'A');
+        setDecimalPoint(digit, decimal_point_state::on);
+        digit--;
+        prevDot = false;
+        break;
+
       default:
         digit--;
         prevDot = false;
@@ -150,6 +189,156 @@ public:
     delay(interval);
   }
 
+  // scrolls the current content out to the left, one digit per interval,
+  // the animation ends with an empty display
+  void scrollOut(uint16_t interval = ANIMATION_INTERVAL)
+  {
+    for (uint8_t i = 0; i < getDigitCount(); i++)
+    {
+      _animationDigits[i] = getDigit(i);
+    }
+    for (uint8_t i = 0; i < getDecimalPointCount(); i++)
+    {
+      _animationDecimalPoints[i] = getDecimalPoint(i);
+    }
+    startAnimation(animation_type::scroll_out, interval);
+  }
+
+  // runs all digits through 0 to 9 (slot machine)
+  // to prevent cathode poisoning
+  void cycleDigits(uint16_t interval = ANIMATION_INTERVAL)
+  {
+    clear();
+    startAnimation(animation_type::digit_cycle, interval);
+  }
+
+  void stopAnimation()
+  {
+    if (_animation != animation_type::none)
+    {
+      _animation = animation_type::none;
+      clear();
+    }
+  }
+
+  bool isAnimating()
+  {
+    return (_animation != animation_type::none);
+  }
+
+  // advances the running animation when the next frame is due,
+  // call it from the main loop, it never blocks
+  // returns true as long as the animation owns the display
+  bool animate()
+  {
+    if (_animation == animation_type::none)
+    {
+      return (false);
+    }
+
+    unsigned long now = micros();
+    if ((long)(now - _nextFrameMicros) >= 0)
+    {
+      // how late the loop came back for this frame
+      if (now - _nextFrameMicros > _maxAnimationLatency)
+      {
+        _maxAnimationLatency = now - _nextFrameMicros;
+      }
+      _nextFrameMicros = now + _animationInterval * 1000UL;
+      _animationStep++;
+      showAnimationStep();
+    }
+    return (_animation != animation_type::none);
+  }
+
+  // ms until the next animation frame is due
+  uint32_t getAnimationTimeout()
+  {
+    long remaining = (long)(_nextFrameMicros - micros());
+    return ((remaining > 0) ? ((remaining + 999) / 1000) : 0);
+  }
+
+  // worst case delay of an animation frame behind its schedule, in us
+  unsigned long getMaxAnimationLatency()
+  {
+    return (_maxAnimationLatency);
+  }
+
+  void resetAnimationLatency()
+  {
+    _maxAnimationLatency = 0;
+  }
+
 private:
   String _currentDisplay;
+  animation_type _animation = animation_type::none;
+  uint8_t _animationStep = 0;
+  uint16_t _animationInterval = ANIMATION_INTERVAL;
+  unsigned long _nextFrameMicros = 0;
+  unsigned long _maxAnimationLatency = 0;
+  // content captured when a scroll starts
+  uint8_t _animationDigits[HAL::digitCount];
+  decimal_point_state _animationDecimalPoints[HAL::decimalPointCount];
+
+  void startAnimation(animation_type animation, uint16_t interval)
+  {
+    _animation = animation;
+    _animationInterval = interval;
+    _animationStep = 1;
+    _nextFrameMicros = micros() + _animationInterval * 1000UL;
+    showAnimationStep();
+  }
+
+  // renders the frame of the current step, ends the animation after the last one
+  void showAnimationStep()
+  {
+    bool empty = true;
+
+    switch (_animation)
+    {
+    case animation_type::scroll_out:
+      clearDigits();
+      clearDecimalPoints();
+      for (uint8_t i = 0; i + _animationStep < getDigitCount(); i++)
+      {
+        setDigit(i, _animationDigits[i + _animationStep]);
+        if (_animationDigits[i + _animationStep] != DIGIT_OFF)
+        {
+          empty = false;
+        }
+      }
+      for (uint8_t i = 0; i + _animationStep < getDecimalPointCount(); i++)
+      {
+        setDecimalPoint(i, _animationDecimalPoints[i + _animationStep]);
+        if (_animationDecimalPoints[i + _animationStep] == decimal_point_state::on)
+        {
+          empty = false;
+        }
+      }
+      if (empty)
+      {
+        _animation = animation_type::none;
+      }
+      break;
+
+    case animation_type::digit_cycle:
+      if (_animationStep > 10)
+      {
+        clearDigits();
+        _animation = animation_type::none;
+      }
+      else
+      {
+        for (uint8_t i = 0; i < getDigitCount(); i++)
+        {
+          setDigit(i, _animationStep - 1);
+        }
+      }
+      break;
+
+    default:
+      break;
+    }
+    refresh();
+  }
 };
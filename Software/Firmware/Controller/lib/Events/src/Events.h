@@ -0,0 +1,115 @@
+// Events.h
+
+// wakes the main loop when something happens
+// event sources signal from interrupts, UART callbacks or timers,
+// the events are notification bits of the loop task
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+// event bits
+#define EVENT_NONE 0x00
+#define EVENT_KEYBOARD 0x01
+#define EVENT_GPS 0x02
+#define EVENT_PIR 0x04
+#define EVENT_TICK 0x08
+#define EVENT_TIMER 0x10
+#define EVENT_CONSOLE 0x20
+#define EVENT_RTC 0x40
+#define EVENT_ALL 0xFFFFFFFF
+
+// the tick covers everything that is checked once per second
+#define EVENT_TICK_INTERVAL 1000000 // us
+#define EVENT_MAX_TIMEOUT 1000      // ms
+
+class Events
+{
+public:
+  // the calling task is the one waiting for the events
+  static void begin()
+  {
+    _task = xTaskGetCurrentTaskHandle();
+    _wakeups = 0;
+    _wakeupsPerSecond = 0;
+    _windowStart = millis();
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = onTick;
+    timerArgs.name = "tick";
+    if (esp_timer_create(&timerArgs, &_tickTimer) == ESP_OK)
+    {
+      esp_timer_start_periodic(_tickTimer, EVENT_TICK_INTERVAL);
+    }
+  }
+
+  // from a task or a callback
+  static void signal(uint32_t events)
+  {
+    if (_task)
+    {
+      xTaskNotify(_task, events, eSetBits);
+    }
+  }
+
+  static void IRAM_ATTR signalFromISR(uint32_t events)
+  {
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    if (_task)
+    {
+      xTaskNotifyFromISR(_task, events, eSetBits, &higherPriorityTaskWoken);
+      if (higherPriorityTaskWoken)
+      {
+        portYIELD_FROM_ISR();
+      }
+    }
+  }
+
+  // sleeps until events are signaled or the timeout (ms) is over,
+  // returns the signaled events, EVENT_NONE on timeout
+  static uint32_t wait(uint32_t timeout)
+  {
+    uint32_t events = EVENT_NONE;
+
+    if (timeout > EVENT_MAX_TIMEOUT)
+    {
+      timeout = EVENT_MAX_TIMEOUT;
+    }
+    xTaskNotifyWait(0, EVENT_ALL, &events, pdMS_TO_TICKS(timeout));
+
+    // instrumentation
+    _wakeups++;
+    unsigned long currentMillis = millis();
+    if (currentMillis - _windowStart >= 1000)
+    {
+      _wakeupsPerSecond = _wakeups;
+      _wakeups = 0;
+      _windowStart = currentMillis;
+    }
+    return (events);
+  }
+
+  // loop wakeups during the last second
+  static uint32_t getWakeupsPerSecond()
+  {
+    return (_wakeupsPerSecond);
+  }
+
+private:
+  inline static TaskHandle_t _task = nullptr;
+  inline static esp_timer_handle_t _tickTimer = nullptr;
+  inline static uint32_t _wakeups = 0;
+  inline static uint32_t _wakeupsPerSecond = 0;
+  inline static unsigned long _windowStart = 0;
+
+  static void onTick(void *arg)
+  {
+    signal(EVENT_TICK);
+  }
+};
@@ -8,30 +8,57 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
 #include <Timezone.h>
-#include <SoftwareSerial.h>
+#include <HardwareSerial.h>
 #include <Settings.h>
+#include <Events.h>
 #include <ubGPSTime.h>
 
 #define GPS_SYNC_INTERVAL_SHORT 15 * 1000 // the initial interval is 15 seconds
 #define GPS_MSG_INTERVAL 60               // one msg every 60 seconds
+#define GPS_UART 1
+// the module sends NAV-TIMEUTC after the navigation epoch it describes,
+// the delay depends on the module, the transfer time on the baud rate,
+// without a PPS input the delay can't be measured, any error in it
+// is a constant offset of the RTC to GPS time, 50 ms is an estimate for
+// u-blox modules at one navigation solution per second, another module
+// can set it with a build flag like -D GPS_OUTPUT_DELAY=80000,
+// the simulator sends its messages VIRTUAL_GPS_OUTPUT_DELAY after the epoch
+#ifndef GPS_OUTPUT_DELAY
+#define GPS_OUTPUT_DELAY 50000 // us
+#endif
+#define GPS_TIMEUTC_MESSAGE_LENGTH 28
+// samples with a worse time accuracy are not used
+#define GPS_MAX_TIME_ACCURACY 1000000 // ns
+
+// a GPS second and the ESP32 timer when it started
+typedef struct
+{
+  time_t utc;
+  int64_t micros;
+  uint32_t accuracy; // ns
+} GPS_TIME;
 
 class GPS
 {
 
 protected:
-  using notifyCallBack = void (*)(void *obj, time_t utc);
+  using notifyCallBack = void (*)(void *obj, GPS_TIME *gpsTime);
 
 public:
   GPS(Settings *settings)
-      : _settings(settings)
+      : _settings(settings),
+        _gpsCom(GPS_UART)
   {
     _obj = nullptr;
     _notify = nullptr;
     _gpsSyncTimestamp = 0;
-    _gpsSyncIntervalActive = _gpsSyncIntervalActive;
+    _gpsSyncIntervalActive = GPS_SYNC_INTERVAL_SHORT;
     _gpsInitialized = false;
     _gpsMessageInterval = GPS_MSG_INTERVAL;
+    _arrival = 0;
   }
 
   virtual ~GPS()
@@ -43,7 +70,12 @@ public:
     _pinRX = pinRX;
     _pinTX = pinTX;
     setParameters();
-    _gpsCom.begin(_gpsCommSpeed, SWSERIAL_8N1, _pinRX, _pinTX);
+    _gpsCom.begin(_gpsCommSpeed, SERIAL_8N1, _pinRX, _pinTX);
+    // wake the main loop when data arrives, the time is taken here,
+    // the main loop may get to the message much later
+    _gpsCom.onReceive([this]()
+                      { _arrival = (uint32_t)esp_timer_get_time();
+                        Events::signal(EVENT_GPS); });
     _uGPS.begin(_gpsCom);
     _uGPS.initialize(false);
   }
@@ -128,11 +160,14 @@ private:
   unsigned long _gpsSyncTimestamp;
   uint8_t _pinRX;
   uint8_t _pinTX;
-  SoftwareSerial _gpsCom;
+  HardwareSerial _gpsCom;
   ubGPSTime _uGPS;
   void *_obj;
   notifyCallBack _notify;
   bool _gpsInitialized;
+  // the ESP32 timer at the end of the last data received, the low
+  // 32 bits are enough for the next hour, written by the UART callback
+  std::atomic<uint32_t> _arrival;
 
   int getSpeed(gps_speed::gps_speed speed)
   {
@@ -190,35 +225,33 @@ private:
 
   void gpsTimeSync(TIMEUTC timeUTC)
   {
-    TimeElements tm;
+    // the message ended the last data received, the next one is
+    // a minute away
+    int64_t now = esp_timer_get_time();
+    int64_t arrival = now - (uint32_t)((uint32_t)now - _arrival);
+
     if (millis() - _gpsSyncTimestamp > (_gpsSyncIntervalActive))
     {
-      time_t utc = now();
-      breakTime(utc, tm);
-      if (timeUTC.timeOfWeekValid)
+      if (timeUTC.timeOfWeekValid && timeUTC.weekNumberValid && (timeUTC.accuracy <= GPS_MAX_TIME_ACCURACY))
       {
+        TimeElements tm;
+        GPS_TIME gpsTime;
 
         tm.Second = timeUTC.second;
         tm.Minute = timeUTC.minute;
         tm.Hour = timeUTC.hour;
-      }
-      if (timeUTC.weekNumberValid)
-      {
         tm.Day = timeUTC.day;
         tm.Month = timeUTC.month;
         tm.Year = timeUTC.year - 1970;
-      }
-      if (timeUTC.timeOfWeekValid || timeUTC.weekNumberValid)
-      {
-        utc = makeTime(tm);
-        setTime(utc);
+        gpsTime.utc = makeTime(tm);
+        // the epoch was at utc + nanoSecond
+        gpsTime.micros = arrival - getTransferTime(GPS_TIMEUTC_MESSAGE_LENGTH) - GPS_OUTPUT_DELAY -
+                         timeUTC.nanoSecond / 1000;
+        gpsTime.accuracy = timeUTC.accuracy;
         if (_notify)
         {
-          _notify(_obj, utc);
+          _notify(_obj, &gpsTime);
         }
-      }
-      if (timeUTC.timeOfWeekValid && timeUTC.weekNumberValid)
-      {
         _gpsSyncIntervalActive = _gpsSyncInterval;
       }
       else
@@ -228,4 +261,10 @@ private:
       _gpsSyncTimestamp = millis();
     }
   }
+
+  // us for length bytes, 10 bits each
+  int64_t getTransferTime(uint16_t length)
+  {
+    return ((int64_t)length * 10 * 1000000LL / _gpsCommSpeed);
+  }
 };
@@ -0,0 +1,56 @@
+// HeapCounter.cpp
+
+// counts the heap allocations of the firmware
+// malloc, calloc and realloc are wrapped by the linker,
+// see the --wrap options in platformio.ini
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include "HeapCounter.h"
+#include <atomic>
+
+// allocations may come from any task
+static std::atomic<uint32_t> allocations(0);
+static std::atomic<uint32_t> allocatedBytes(0);
+
+static void countAllocation(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+extern "C"
+{
+  void *__real_malloc(size_t size);
+  void *__real_calloc(size_t count, size_t size);
+  void *__real_realloc(void *ptr, size_t size);
+
+  void *__wrap_malloc(size_t size)
+  {
+    countAllocation(size);
+    return (__real_malloc(size));
+  }
+
+  void *__wrap_calloc(size_t count, size_t size)
+  {
+    countAllocation(count * size);
+    return (__real_calloc(count, size));
+  }
+
+  void *__wrap_realloc(void *ptr, size_t size)
+  {
+    countAllocation(size);
+    return (__real_realloc(ptr, size));
+  }
+}
+
+uint32_t HeapCounter::getAllocations()
+{
+  return (allocations.load(std::memory_order_relaxed));
+}
+
+uint32_t HeapCounter::getAllocatedBytes()
+{
+  return (allocatedBytes.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,22 @@
+// HeapCounter.h
+
+// counts the heap allocations of the firmware
+// malloc, calloc and realloc are wrapped by the linker,
+// see the --wrap options in platformio.ini
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+
+class HeapCounter
+{
+public:
+  // number of allocations since startup
+  static uint32_t getAllocations();
+
+  // bytes requested since startup
+  static uint32_t getAllocatedBytes();
+};
@@ -0,0 +1,243 @@
+// KeyLatency.h
+
+// measures how long a key press takes to reach the tubes
+// every stage of the path gets its own latency histogram
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <HeapCounter.h>
+
+// values below 8 us get their own bucket, above that
+// every power of two is split into 4 buckets (25% resolution)
+#define LATENCY_LINEAR_BUCKETS 8
+#define LATENCY_BUCKETS 80
+
+// 2 bytes, 10 bits each, at 9600 baud, sent by the keyboard
+// before the controller can see anything
+#define KEYBOARD_LINK_TIME 2083 // us
+
+enum class latency_stage : uint8_t
+{
+  queue,     // UART data received until the main loop reads the key
+  calculate, // key event handling, calculation and formatting
+  display,   // display encoding until the frame is published
+  output,    // published until the display task shifted it out
+  total      // UART data received until the frame is out
+};
+
+#define LATENCY_STAGE_COUNT 5
+
+class LatencyHistogram
+{
+public:
+  LatencyHistogram()
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    memset(_buckets, 0, sizeof(_buckets));
+    _count = 0;
+    _max = 0;
+  }
+
+  void add(uint32_t value)
+  {
+    _buckets[getBucket(value)]++;
+    _count++;
+    if (value > _max)
+    {
+      _max = value;
+    }
+  }
+
+  uint32_t getCount()
+  {
+    return (_count);
+  }
+
+  uint32_t getMax()
+  {
+    return (_max);
+  }
+
+  // upper limit of the bucket holding the percentile, never above the maximum
+  uint32_t getPercentile(uint8_t percent)
+  {
+    uint32_t rank;
+    uint32_t sum = 0;
+
+    if (_count == 0)
+    {
+      return (0);
+    }
+    rank = ((uint64_t)_count * percent + 99) / 100;
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+      sum += _buckets[i];
+      if (sum >= rank)
+      {
+        return (min(getBucketLimit(i), _max));
+      }
+    }
+    return (_max);
+  }
+
+private:
+  uint32_t _buckets[LATENCY_BUCKETS];
+  uint32_t _count;
+  uint32_t _max;
+
+  static uint8_t getBucket(uint32_t value)
+  {
+    uint8_t bucket;
+
+    if (value < LATENCY_LINEAR_BUCKETS)
+    {
+      bucket = value;
+    }
+    else
+    {
+      uint8_t exponent = 31 - __builtin_clz(value);
+      uint8_t sub = (value >> (exponent - 2)) & 0x03;
+      bucket = LATENCY_LINEAR_BUCKETS + (exponent - 3) * 4 + sub;
+    }
+    if (bucket >= LATENCY_BUCKETS)
+    {
+      bucket = LATENCY_BUCKETS - 1;
+    }
+    return (bucket);
+  }
+
+  static uint32_t getBucketLimit(uint8_t bucket)
+  {
+    if (bucket < LATENCY_LINEAR_BUCKETS)
+    {
+      return (bucket);
+    }
+    if (bucket == LATENCY_BUCKETS - 1)
+    {
+      return (UINT32_MAX);
+    }
+    uint8_t exponent = (bucket - LATENCY_LINEAR_BUCKETS) / 4 + 3;
+    uint8_t sub = (bucket - LATENCY_LINEAR_BUCKETS) % 4;
+    return ((((uint32_t)(4 + sub + 1)) << (exponent - 2)) - 1);
+  }
+};
+
+class KeyLatency
+{
+public:
+  KeyLatency()
+  {
+    _arrival = 0;
+    _pending = false;
+    _dropped = 0;
+    _heapAllocations = 0;
+    _heapBytes = 0;
+  }
+
+  // keyboard data received, called from the UART callback
+  void markArrival()
+  {
+    _arrival = micros();
+  }
+
+  // the main loop starts handling a key
+  void beginKey()
+  {
+    if (_pending)
+    {
+      // the previous frame wasn't out yet
+      _dropped++;
+    }
+    _pending = false;
+    _timestamps[0] = _arrival;
+    _timestamps[1] = micros();
+    _keyHeapAllocations = HeapCounter::getAllocations();
+    _keyHeapBytes = HeapCounter::getAllocatedBytes();
+  }
+
+  void markCalculated()
+  {
+    _timestamps[2] = micros();
+  }
+
+  // the frame showing the key has been published
+  void markDisplayed(uint32_t frameSequence)
+  {
+    _timestamps[3] = micros();
+    // heap used while handling the key
+    _heapAllocations += HeapCounter::getAllocations() - _keyHeapAllocations;
+    _heapBytes += HeapCounter::getAllocatedBytes() - _keyHeapBytes;
+    _frameSequence = frameSequence;
+    _pending = true;
+  }
+
+  // completes the measurement when the display task shifted the frame out
+  void process(uint32_t committedSequence, unsigned long commitMicros)
+  {
+    if (_pending && ((int32_t)(committedSequence - _frameSequence) >= 0))
+    {
+      _pending = false;
+      _histograms[(uint8_t)latency_stage::queue].add(_timestamps[1] - _timestamps[0]);
+      _histograms[(uint8_t)latency_stage::calculate].add(_timestamps[2] - _timestamps[1]);
+      _histograms[(uint8_t)latency_stage::display].add(_timestamps[3] - _timestamps[2]);
+      _histograms[(uint8_t)latency_stage::output].add(commitMicros - _timestamps[3]);
+      _histograms[(uint8_t)latency_stage::total].add(commitMicros - _timestamps[0]);
+    }
+  }
+
+  void reset()
+  {
+    for (uint8_t i = 0; i < LATENCY_STAGE_COUNT; i++)
+    {
+      _histograms[i].reset();
+    }
+    _pending = false;
+    _dropped = 0;
+    _heapAllocations = 0;
+    _heapBytes = 0;
+  }
+
+  LatencyHistogram *getHistogram(latency_stage stage)
+  {
+    return (&_histograms[(uint8_t)stage]);
+  }
+
+  void dump(Print &out)
+  {
+    static const char *stageNames[LATENCY_STAGE_COUNT] = {"queue", "calculate", "display", "output", "total"};
+
+    out.printf("key to display latency (us), %u keys, %u dropped\r\n",
+               _histograms[(uint8_t)latency_stage::total].getCount(), _dropped);
+    out.printf("%-10s %8s %8s %8s\r\n", "stage", "p50", "p99", "max");
+    out.printf("%-10s %8u %8u %8u (keyboard, not measured)\r\n", "link",
+               KEYBOARD_LINK_TIME, KEYBOARD_LINK_TIME, KEYBOARD_LINK_TIME);
+    for (uint8_t i = 0; i < LATENCY_STAGE_COUNT; i++)
+    {
+      out.printf("%-10s %8u %8u %8u\r\n", stageNames[i],
+                 _histograms[i].getPercentile(50), _histograms[i].getPercentile(99), _histograms[i].getMax());
+    }
+    out.printf("heap: %u allocations, %u bytes\r\n", _heapAllocations, _heapBytes);
+  }
+
+private:
+  std::atomic<uint32_t> _arrival;
+  // arrival, read, calculated, published
+  uint32_t _timestamps[4];
+  uint32_t _frameSequence;
+  bool _pending;
+  uint32_t _dropped;
+  uint32_t _keyHeapAllocations;
+  uint32_t _keyHeapBytes;
+  uint32_t _heapAllocations;
+  uint32_t _heapBytes;
+  LatencyHistogram _histograms[LATENCY_STAGE_COUNT];
+};
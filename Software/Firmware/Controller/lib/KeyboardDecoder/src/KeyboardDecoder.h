@@ -8,6 +8,7 @@
 #include <Arduino.h>
 #include <KeyboardHandler.h>
 #include <NixieCalc.h>
+#include <ProgrammerCalc.h>
 
 enum class key_function_type
 {
@@ -16,7 +17,13 @@ enum class key_function_type
   numericx2,
   dp,
   operation,
-  function
+  function,
+  historyback,
+  historyforward,
+  memoryselect,
+  programmer,
+  numberbase,
+  window
 };
 
 class KeyboardDecoder
@@ -30,7 +37,12 @@ public:
   {
   }
 
-  static void decode(uint8_t keyCode, bool functionKeyPressed, key_function_type *function, operation *op, uint8_t *digit)
+  // in RPN mode the equals key is ENTER and the function key
+  // adds the stack operations: F+/- swap, F C roll down, F= lastx
+  // F - and F + step back and forth through the calculation history
+  // F and a memory key select a memory register with the next digit
+  // F and the square root key switch to programmer mode
+  static void decode(uint8_t keyCode, bool functionKeyPressed, key_function_type *function, operation *op, uint8_t *digit, bool rpn = false)
   {
 
     *op = operation::none;
@@ -127,7 +139,7 @@ public:
 
       case KEY_EQUALS:
         *function = key_function_type::operation;
-        *op = operation::equals;
+        *op = rpn ? operation::enter : operation::equals;
         break;
 
       case KEY_DIV:
@@ -229,6 +241,189 @@ public:
         *function = key_function_type::operation;
         *op = operation::pi;
         break;
+
+      case KEY_MINUS:
+        *function = key_function_type::historyback;
+        break;
+
+      case KEY_PLUS:
+        *function = key_function_type::historyforward;
+        break;
+
+      case KEY_MC:
+        *function = key_function_type::memoryselect;
+        *op = operation::memclear;
+        break;
+
+      case KEY_MR:
+        *function = key_function_type::memoryselect;
+        *op = operation::memread;
+        break;
+
+      case KEY_MS:
+        *function = key_function_type::memoryselect;
+        *op = operation::memstore;
+        break;
+
+      case KEY_MMINUS:
+        *function = key_function_type::memoryselect;
+        *op = operation::memsubtraction;
+        break;
+
+      case KEY_MPLUS:
+        *function = key_function_type::memoryselect;
+        *op = operation::memaddition;
+        break;
+
+      case KEY_SQUAREROOT:
+        *function = key_function_type::programmer;
+        break;
+      }
+      if (rpn)
+      {
+        switch (keyCode)
+        {
+        case KEY_PLUSMINUS:
+          *function = key_function_type::operation;
+          *op = operation::swap;
+          break;
+
+        case KEY_C:
+          *function = key_function_type::operation;
+          *op = operation::rolldown;
+          break;
+
+        case KEY_EQUALS:
+          *function = key_function_type::operation;
+          *op = operation::lastx;
+          break;
+        }
+      }
+    }
+  }
+
+  // programmer mode: the scientific keys are the HEX digits A to F,
+  // ln is NOT, % is the remainder, the memory keys are AND, OR, XOR
+  // and the shifts, the base is the function key and the last digit
+  // of its number: F 2 BIN, F 8 OCT, F 0 DEC, F 6 HEX, F . shows the
+  // next window of digits, F and the square root key switch back
+  static void decodeProgrammer(uint8_t keyCode, bool functionKeyPressed, key_function_type *function, operation *op, uint8_t *digit)
+  {
+    *op = operation::none;
+    *digit = -1;
+    *function = key_function_type::unknown;
+
+    if (!functionKeyPressed)
+    {
+      switch (keyCode)
+      {
+      case KEY_INV:
+        *function = key_function_type::numeric;
+        *digit = 10;
+        break;
+
+      case KEY_POW:
+        *function = key_function_type::numeric;
+        *digit = 11;
+        break;
+
+      case KEY_SIN:
+        *function = key_function_type::numeric;
+        *digit = 12;
+        break;
+
+      case KEY_COS:
+        *function = key_function_type::numeric;
+        *digit = 13;
+        break;
+
+      case KEY_TAN:
+        *function = key_function_type::numeric;
+        *digit = 14;
+        break;
+
+      case KEY_LOG:
+        *function = key_function_type::numeric;
+        *digit = 15;
+        break;
+
+      case KEY_LN:
+        *function = key_function_type::operation;
+        *op = operation::bitwisenot;
+        break;
+
+      case KEY_PERCENT:
+        *function = key_function_type::operation;
+        *op = operation::modulo;
+        break;
+
+      case KEY_MC:
+        *function = key_function_type::operation;
+        *op = operation::bitwiseand;
+        break;
+
+      case KEY_MR:
+        *function = key_function_type::operation;
+        *op = operation::bitwiseor;
+        break;
+
+      case KEY_MS:
+        *function = key_function_type::operation;
+        *op = operation::bitwisexor;
+        break;
+
+      case KEY_MMINUS:
+        *function = key_function_type::operation;
+        *op = operation::shiftleft;
+        break;
+
+      case KEY_MPLUS:
+        *function = key_function_type::operation;
+        *op = operation::shiftright;
+        break;
+
+      case KEY_DOT:
+      case KEY_SQUAREROOT:
+        // no fractions and roots
+        break;
+
+      default:
+        // digits and the basic operations as usual
+        decode(keyCode, false, function, op, digit);
+        break;
+      }
+    }
+    else
+    {
+      switch (keyCode)
+      {
+      case KEY_2:
+        *function = key_function_type::numberbase;
+        *digit = (uint8_t)number_base::bin;
+        break;
+
+      case KEY_8:
+        *function = key_function_type::numberbase;
+        *digit = (uint8_t)number_base::oct;
+        break;
+
+      case KEY_0:
+        *function = key_function_type::numberbase;
+        *digit = (uint8_t)number_base::dec;
+        break;
+
+      case KEY_6:
+        *function = key_function_type::numberbase;
+        *digit = (uint8_t)number_base::hex;
+        break;
+
+      case KEY_DOT:
+        *function = key_function_type::window;
+        break;
+
+      case KEY_SQUAREROOT:
+        *function = key_function_type::programmer;
+        break;
       }
     }
   }
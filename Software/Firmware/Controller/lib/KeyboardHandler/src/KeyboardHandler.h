@@ -6,6 +6,8 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
 #include <Wire.h>
 
 // keyboard
@@ -59,6 +61,9 @@
 #define KEYBOARD_CMD_SETFASTAUTOREPEATINTERVAL 6
 #define KEYBOARD_CMD_SETFASTAUTOREPEATDELAY 7
 
+// arrival times of the key messages not read yet
+#define KEYBOARD_ARRIVALS 16
+
 enum class key_state : uint8_t
 {
   idle,
@@ -87,7 +92,7 @@ class KeyboardHandler
 {
 
 protected:
-  using notifyCallBack = void (*)(void *obj, uint8_t key, key_state keyState, bool functionKeyPressed, special_keyboard_event specialEvent);
+  using notifyCallBack = void (*)(void *obj, uint8_t key, key_state keyState, bool functionKeyPressed, special_keyboard_event specialEvent, int64_t arrival);
   using notifyRawCallBack = void (*)(void *obj, uint8_t key, key_state keyState);
 
 public:
@@ -103,6 +108,8 @@ public:
     _notify = nullptr;
     _notifyRaw = nullptr;
     _lastKeyTimestamp = millis();
+    _arrivalHead = 0;
+    _arrivalTail = 0;
   }
 
   virtual ~KeyboardHandler()
@@ -142,6 +149,23 @@ public:
     _obj = nullptr;
   }
 
+  // keyboard data received, called from the UART callback,
+  // every complete message without a time gets this one
+  void markArrival()
+  {
+    int64_t now = esp_timer_get_time();
+    // the tail first, a message read in between still has its time
+    uint8_t tail = _arrivalTail;
+    uint8_t head = _arrivalHead;
+    int messages = _serialPort ? _serialPort->available() / 2 : 0;
+    while (((uint8_t)(head - tail) < messages) && ((uint8_t)(head - tail) < KEYBOARD_ARRIVALS))
+    {
+      _arrivals[head % KEYBOARD_ARRIVALS] = now;
+      head++;
+    }
+    _arrivalHead = head;
+  }
+
   void process()
   {
     uint8_t buffer[2];
@@ -150,20 +174,21 @@ public:
       while (_serialPort->available())
       {
         _serialPort->readBytes(buffer, 2);
+        int64_t arrival = takeArrival();
         if (_notifyRaw)
         {
           _notifyRaw(_obj, buffer[0], (key_state)buffer[1]);
         }
         if (_notify)
         {
-          notifyKeyboardEvent(buffer[0], (key_state)buffer[1]);
+          notifyKeyboardEvent(buffer[0], (key_state)buffer[1], arrival);
         }
       }
     }
   }
 
-  //
-  void notifyKeyboardEvent(uint8_t key, key_state state)
+  // arrival is the ESP32 timer when the message was received
+  void notifyKeyboardEvent(uint8_t key, key_state state, int64_t arrival)
   {
     special_keyboard_event specialEvent = special_keyboard_event::none;
     // check if function key is pressed
@@ -222,7 +247,7 @@ public:
         break;
       }
     }
-    _notify(_obj, key, state, _functionKeyPressed, specialEvent);
+    _notify(_obj, key, state, _functionKeyPressed, specialEvent, arrival);
   }
 
   bool setHoldTime(uint16_t holdTime)
@@ -365,4 +390,21 @@ private:
   bool _functionKeyHold;
   bool _keyPressed;
   unsigned long _lastKeyTimestamp;
+  // written by the UART callback, read by the main loop
+  int64_t _arrivals[KEYBOARD_ARRIVALS];
+  std::atomic<uint8_t> _arrivalHead;
+  std::atomic<uint8_t> _arrivalTail;
+
+  // the time of the message just read, now if it has none
+  int64_t takeArrival()
+  {
+    uint8_t tail = _arrivalTail;
+    if (tail == _arrivalHead)
+    {
+      return (esp_timer_get_time());
+    }
+    int64_t arrival = _arrivals[tail % KEYBOARD_ARRIVALS];
+    _arrivalTail = tail + 1;
+    return (arrival);
+  }
 };
@@ -0,0 +1,131 @@
+// MemoryBank.h
+
+// keeps the memory registers of the calculator in NVS
+// changes are only noted on the keystroke path, the registers are
+// written when they haven't changed for a while, a series of M+
+// ends up as one flash write
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <NixieCalc.h>
+
+#define MEMORY_NAMESPACE "CalcMemory"
+#define MEMORY_KEY "registers"
+#define MEMORY_VERSION 1
+
+// write after this quiet time, but at the latest after the max delay
+#define MEMORY_SAVE_DELAY 30000     // ms
+#define MEMORY_MAX_SAVE_DELAY 300000 // ms
+
+// stored as one blob, the engine type tells if the registers can be read back
+typedef struct
+{
+  uint8_t version;
+  calc_engine engine;
+  uint8_t registerCount;
+  CALCNUMBER registers[MEMORY_REGISTERS];
+} MEMORY_BANK_DATA;
+
+class MemoryBank
+{
+public:
+  MemoryBank()
+      : _dirty(false),
+        _firstChange(0),
+        _lastChange(0),
+        _writes(0)
+  {
+    // nothing saved yet
+    _saved.version = 0;
+  }
+
+  bool begin()
+  {
+    return (_preferences.begin(MEMORY_NAMESPACE, false));
+  }
+
+  // registers as saved, false if there is nothing valid,
+  // registers stay untouched then
+  bool load(CALCNUMBER *registers)
+  {
+    MEMORY_BANK_DATA data;
+
+    if ((_preferences.getBytes(MEMORY_KEY, &data, sizeof(data)) != sizeof(data)) ||
+        (data.version != MEMORY_VERSION) || (data.engine != CALC_ENGINE) ||
+        (data.registerCount != MEMORY_REGISTERS))
+    {
+      return (false);
+    }
+    memcpy(registers, data.registers, sizeof(data.registers));
+    _saved = data;
+    return (true);
+  }
+
+  // keystroke path, a register may have changed
+  void onChange()
+  {
+    if (!_dirty)
+    {
+      _dirty = true;
+      _firstChange = millis();
+    }
+    _lastChange = millis();
+  }
+
+  // true when the registers should be written
+  bool isDue()
+  {
+    return (_dirty && ((millis() - _lastChange >= MEMORY_SAVE_DELAY) || (millis() - _firstChange >= MEMORY_MAX_SAVE_DELAY)));
+  }
+
+  // writes the registers if they differ from flash
+  void flush(const CALCNUMBER *registers)
+  {
+    _dirty = false;
+    if ((_saved.version == MEMORY_VERSION) && isSaved(registers))
+    {
+      // back to the saved values
+      return;
+    }
+    _saved.version = MEMORY_VERSION;
+    _saved.engine = CALC_ENGINE;
+    _saved.registerCount = MEMORY_REGISTERS;
+    memcpy(_saved.registers, registers, sizeof(_saved.registers));
+    if (_preferences.putBytes(MEMORY_KEY, &_saved, sizeof(_saved)) == sizeof(_saved))
+    {
+      _writes++;
+    }
+  }
+
+  // flash writes since the start
+  uint32_t getWrites()
+  {
+    return (_writes);
+  }
+
+private:
+  Preferences _preferences;
+  MEMORY_BANK_DATA _saved;
+  bool _dirty;
+  unsigned long _firstChange;
+  unsigned long _lastChange;
+  uint32_t _writes;
+
+  // compares values, the number types may have padding bytes
+  bool isSaved(const CALCNUMBER *registers)
+  {
+    for (uint8_t i = 0; i < MEMORY_REGISTERS; i++)
+    {
+      if (_saved.registers[i] != registers[i])
+      {
+        return (false);
+      }
+    }
+    return (true);
+  }
+};
@@ -0,0 +1,436 @@
+// CalcHistory.h
+
+// ring buffer of the last calculations in a storage owned by the caller,
+// put the storage in RTC memory to keep it over deep sleep and soft resets
+// an entry is 16 bytes: one operand and the result with 14 significant
+// digits, the operation and the return code
+// dual value operations take their left operand from the result of the
+// entry before, a number entry is written first if that doesn't match
+// the tape goes out as CSV, one line per calculation
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <NixieCalc.h>
+
+#define CALC_HISTORY_SIZE 64
+#define CALC_HISTORY_MAGIC 0x48495354 // "HIST"
+
+// packed number, 56 bits little endian:
+// bit 55 sign, bits 47-54 exponent + CALC_HISTORY_BIAS, bits 0-46 the
+// 14-digit mantissa, value = mantissa * 10^(exponent - 13), 0 is all zero
+#define CALC_HISTORY_NUMBER_SIZE 7
+#define CALC_HISTORY_DIGITS 14
+#define CALC_HISTORY_BIAS 128
+#define CALC_HISTORY_MANTISSA_BITS 47
+
+// flags: the return code in the low bits, the angle mode of trigonometric functions
+#define CALC_HISTORY_RETURN_CODE_MASK 0x0F
+#define CALC_HISTORY_FLAG_RAD 0x80
+
+// smallest exponent written in fixed notation
+#define CALC_HISTORY_MIN_FIXED_EXPONENT (-5)
+
+// text of a number, sign, 14 digits, point, exponent and terminator
+#define CALC_HISTORY_TEXT_SIZE 28
+
+typedef struct
+{
+  uint8_t operand[CALC_HISTORY_NUMBER_SIZE];
+  uint8_t result[CALC_HISTORY_NUMBER_SIZE];
+  // none: a number, the left operand of the next entry
+  operation op;
+  uint8_t flags;
+} CALC_HISTORY_ENTRY;
+
+static_assert(sizeof(CALC_HISTORY_ENTRY) == 16, "History entry must be 16 bytes!");
+
+typedef struct
+{
+  uint32_t magic;
+  uint16_t next;
+  uint16_t count;
+  CALC_HISTORY_ENTRY entries[CALC_HISTORY_SIZE];
+} CALC_HISTORY_DATA;
+
+class CalcHistory
+{
+public:
+  CalcHistory(CALC_HISTORY_DATA *data)
+      : _data(data)
+  {
+  }
+
+  // keeps the tape of the last run if the storage is intact,
+  // clears it after a power up
+  void begin()
+  {
+    if ((_data->magic != CALC_HISTORY_MAGIC) || (_data->next >= CALC_HISTORY_SIZE) ||
+        (_data->count > CALC_HISTORY_SIZE))
+    {
+      clear();
+    }
+  }
+
+  void clear()
+  {
+    memset(_data, 0, sizeof(CALC_HISTORY_DATA));
+    _data->magic = CALC_HISTORY_MAGIC;
+  }
+
+  // entries, calculations and numbers
+  uint16_t getCount()
+  {
+    return (_data->count);
+  }
+
+  // called by the engine after every calculation
+  void add(operation op, const CALCNUMBER &leftValue, const CALCNUMBER &rightValue,
+           const CALCNUMBER &result, operation_return_code returnCode, angle_mode angleMode)
+  {
+    CALC_HISTORY_ENTRY entry;
+
+    if (op == operation::switchsign)
+    {
+      return;
+    }
+    if (isDualValueOperation(op))
+    {
+      pack(leftValue, entry.result);
+      if ((_data->count == 0) || (memcmp(getEntry(0)->result, entry.result, CALC_HISTORY_NUMBER_SIZE) != 0))
+      {
+        memcpy(entry.operand, entry.result, CALC_HISTORY_NUMBER_SIZE);
+        entry.op = operation::none;
+        entry.flags = (uint8_t)operation_return_code::success;
+        append(&entry);
+      }
+      pack(rightValue, entry.operand);
+    }
+    else
+    {
+      pack(leftValue, entry.operand);
+    }
+    pack(result, entry.result);
+    entry.op = op;
+    entry.flags = (uint8_t)returnCode & CALC_HISTORY_RETURN_CODE_MASK;
+    if (angleMode == angle_mode::rad)
+    {
+      entry.flags |= CALC_HISTORY_FLAG_RAD;
+    }
+    append(&entry);
+  }
+
+  // age 0 is the latest entry, nullptr beyond the oldest
+  const CALC_HISTORY_ENTRY *getEntry(uint16_t age)
+  {
+    if (age >= _data->count)
+    {
+      return (nullptr);
+    }
+    return (&_data->entries[(_data->next + CALC_HISTORY_SIZE - 1 - age) % CALC_HISTORY_SIZE]);
+  }
+
+  // the age of the next successful calculation older (step > 0) or
+  // newer (step < 0) than age, -1 if there is none
+  int findCalculation(int age, int step)
+  {
+    for (age += step; (age >= 0) && (age < _data->count); age += step)
+    {
+      const CALC_HISTORY_ENTRY *entry = getEntry(age);
+      if ((entry->op != operation::none) &&
+          ((entry->flags & CALC_HISTORY_RETURN_CODE_MASK) == (uint8_t)operation_return_code::success))
+      {
+        return (age);
+      }
+    }
+    return (-1);
+  }
+
+  // the tape from the oldest to the latest calculation
+  void dump(Print &out)
+  {
+    char left[CALC_HISTORY_TEXT_SIZE];
+    char right[CALC_HISTORY_TEXT_SIZE];
+    char result[CALC_HISTORY_TEXT_SIZE];
+    uint16_t line = 0;
+
+    out.printf("n,left,operation,right,result,angle,status\r\n");
+    for (int age = _data->count - 1; age >= 0; age--)
+    {
+      const CALC_HISTORY_ENTRY *entry = getEntry(age);
+      if (entry->op == operation::none)
+      {
+        continue;
+      }
+      const CALC_HISTORY_ENTRY *previous = getEntry(age + 1);
+      right[0] = 0;
+      if (!isDualValueOperation(entry->op))
+      {
+        toText(entry->operand, left, sizeof(left));
+      }
+      else
+      {
+        left[0] = 0;
+        if (previous != nullptr)
+        {
+          toText(previous->result, left, sizeof(left));
+        }
+        toText(entry->operand, right, sizeof(right));
+      }
+      toText(entry->result, result, sizeof(result));
+      out.printf("%u,%s,%s,%s,%s,%s,%s\r\n", ++line, left, getOperationName(entry->op), right, result,
+                 isTrigonometric(entry->op) ? ((entry->flags & CALC_HISTORY_FLAG_RAD) ? "rad" : "deg") : "",
+                 getReturnCodeName((operation_return_code)(entry->flags & CALC_HISTORY_RETURN_CODE_MASK)));
+    }
+  }
+
+  // a packed number as text, like %g fixed notation for exponents
+  // from -5 to 13, otherwise mantissa and exponent
+  static uint8_t toText(const uint8_t *packed, char *buffer, uint8_t size)
+  {
+    bool negative;
+    uint64_t mantissa;
+    int exponent;
+    char digits[CALC_HISTORY_TEXT_SIZE];
+    char text[CALC_HISTORY_TEXT_SIZE];
+    uint8_t length = 0;
+
+    unpackRaw(packed, &negative, &mantissa, &exponent);
+    if (mantissa == 0)
+    {
+      return (snprintf(buffer, size, "0"));
+    }
+    snprintf(digits, sizeof(digits), "%014llu", (unsigned long long)mantissa);
+    uint8_t significant = CALC_HISTORY_DIGITS;
+    while (digits[significant - 1] == '0')
+    {
+      significant--;
+    }
+    if (negative)
+    {
+      text[length++] = '-';
+    }
+    if ((exponent >= 0) && (exponent < CALC_HISTORY_DIGITS))
+    {
+      for (int i = 0; (i <= exponent) || (i < significant); i++)
+      {
+        if (i == exponent + 1)
+        {
+          text[length++] = '.';
+        }
+        text[length++] = (i < significant) ? digits[i] : '0';
+      }
+    }
+    else if ((exponent < 0) && (exponent >= CALC_HISTORY_MIN_FIXED_EXPONENT))
+    {
+      text[length++] = '0';
+      text[length++] = '.';
+      for (int i = -1; i > exponent; i--)
+      {
+        text[length++] = '0';
+      }
+      memcpy(text + length, digits, significant);
+      length += significant;
+    }
+    else
+    {
+      text[length++] = digits[0];
+      if (significant > 1)
+      {
+        text[length++] = '.';
+        memcpy(text + length, digits + 1, significant - 1);
+        length += significant - 1;
+      }
+      length += snprintf(text + length, sizeof(text) - length, "e%d", exponent);
+    }
+    text[length] = 0;
+    return (snprintf(buffer, size, "%s", text));
+  }
+
+  // a packed number in the engine number type
+  static CALCNUMBER unpack(const uint8_t *packed)
+  {
+    char text[CALC_HISTORY_TEXT_SIZE];
+    CALCNUMBER value;
+
+    toText(packed, text, sizeof(text));
+    parseNumber(text, &value);
+    return (value);
+  }
+
+private:
+  CALC_HISTORY_DATA *_data;
+
+  void append(const CALC_HISTORY_ENTRY *entry)
+  {
+    _data->entries[_data->next] = *entry;
+    _data->next = (_data->next + 1) % CALC_HISTORY_SIZE;
+    if (_data->count < CALC_HISTORY_SIZE)
+    {
+      _data->count++;
+    }
+  }
+
+  static bool isDualValueOperation(operation op)
+  {
+    return ((op == operation::addition) || (op == operation::subtraction) ||
+            (op == operation::multiplication) || (op == operation::division) ||
+            (op == operation::pow));
+  }
+
+  static bool isTrigonometric(operation op)
+  {
+    return ((op == operation::sin) || (op == operation::cos) || (op == operation::tan));
+  }
+
+  // rounds half up to 14 significant digits
+  static void pack(const CALCNUMBER &value, uint8_t *packed)
+  {
+    bool negative = false;
+    uint64_t mantissa = 0;
+    int exponent = 0;
+
+    getDigits(value, &negative, &mantissa, &exponent);
+    if (mantissa == 0)
+    {
+      memset(packed, 0, CALC_HISTORY_NUMBER_SIZE);
+      return;
+    }
+    if (exponent + CALC_HISTORY_BIAS < 0)
+    {
+      memset(packed, 0, CALC_HISTORY_NUMBER_SIZE);
+      return;
+    }
+    if (exponent + CALC_HISTORY_BIAS > 0xFF)
+    {
+      exponent = 0xFF - CALC_HISTORY_BIAS;
+    }
+    uint64_t bits = mantissa | ((uint64_t)(exponent + CALC_HISTORY_BIAS) << CALC_HISTORY_MANTISSA_BITS);
+    if (negative)
+    {
+      bits |= 1ULL << (CALC_HISTORY_MANTISSA_BITS + 8);
+    }
+    for (uint8_t i = 0; i < CALC_HISTORY_NUMBER_SIZE; i++)
+    {
+      packed[i] = (uint8_t)(bits >> (i * 8));
+    }
+  }
+
+  static void unpackRaw(const uint8_t *packed, bool *negative, uint64_t *mantissa, int *exponent)
+  {
+    uint64_t bits = 0;
+
+    for (uint8_t i = 0; i < CALC_HISTORY_NUMBER_SIZE; i++)
+    {
+      bits |= (uint64_t)packed[i] << (i * 8);
+    }
+    *mantissa = bits & ((1ULL << CALC_HISTORY_MANTISSA_BITS) - 1);
+    *exponent = (int)((bits >> CALC_HISTORY_MANTISSA_BITS) & 0xFF) - CALC_HISTORY_BIAS;
+    *negative = (bits >> (CALC_HISTORY_MANTISSA_BITS + 8)) & 1;
+  }
+
+  // mantissa with 14 digits and the exponent of the first digit
+  static void getDigits(const DecimalNumber &value, bool *negative, uint64_t *mantissa, int *exponent)
+  {
+    if (value.isZero())
+    {
+      return;
+    }
+    // the coefficient is normalized to 18 digits
+    *negative = value.isNegative();
+    *mantissa = (value.getCoefficient() + 5000) / 10000;
+    *exponent = value.getExponent() + DECIMAL_PRECISION - 1;
+    if (*mantissa > 99999999999999ULL)
+    {
+      *mantissa /= 10;
+      (*exponent)++;
+    }
+  }
+
+  static void getDigits(double value, bool *negative, uint64_t *mantissa, int *exponent)
+  {
+    char text[CALC_HISTORY_TEXT_SIZE];
+
+    if ((value == 0.0) || !isfinite(value))
+    {
+      return;
+    }
+    // d.ddddddddddddde+x
+    snprintf(text, sizeof(text), "%.*e", CALC_HISTORY_DIGITS - 1, fabs(value));
+    *negative = (value < 0.0);
+    *mantissa = 0;
+    for (const char *p = text; *p && (*p != 'e'); p++)
+    {
+      if ((*p >= '0') && (*p <= '9'))
+      {
+        *mantissa = *mantissa * 10 + (*p - '0');
+      }
+    }
+    *exponent = atoi(strchr(text, 'e') + 1);
+  }
+
+  static void parseNumber(const char *s, double *value)
+  {
+    *value = strtod(s, nullptr);
+  }
+
+  static void parseNumber(const char *s, DecimalNumber *value)
+  {
+    *value = DecimalNumber::fromString(s);
+  }
+
+  static const char *getOperationName(operation op)
+  {
+    switch (op)
+    {
+    case operation::addition:
+      return ("+");
+    case operation::subtraction:
+      return ("-");
+    case operation::multiplication:
+      return ("*");
+    case operation::division:
+      return ("/");
+    case operation::pow:
+      return ("pow");
+    case operation::squareroot:
+      return ("sqrt");
+    case operation::inv:
+      return ("1/x");
+    case operation::sin:
+      return ("sin");
+    case operation::cos:
+      return ("cos");
+    case operation::tan:
+      return ("tan");
+    case operation::log:
+      return ("log");
+    case operation::ln:
+      return ("ln");
+    case operation::factorial:
+      return ("n!");
+    default:
+      return ("?");
+    }
+  }
+
+  static const char *getReturnCodeName(operation_return_code returnCode)
+  {
+    switch (returnCode)
+    {
+    case operation_return_code::success:
+      return ("ok");
+    case operation_return_code::overflow:
+      return ("overflow");
+    case operation_return_code::divideByZero:
+      return ("divide by zero");
+    case operation_return_code::domain:
+      return ("domain");
+    default:
+      return ("unknown operation");
+    }
+  }
+};
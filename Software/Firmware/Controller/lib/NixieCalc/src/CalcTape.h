@@ -0,0 +1,113 @@
+// CalcTape.h
+
+// writes a keystroke tape for NixieCalc::runTape
+// into a buffer owned by the caller
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <NixieCalc.h>
+
+class CalcTape
+{
+public:
+  CalcTape(uint8_t *buffer, size_t size)
+      : _buffer(buffer),
+        _size(size),
+        _length(0)
+  {
+  }
+
+  void clear()
+  {
+    _length = 0;
+  }
+
+  // false if the tape is full
+  bool addOperation(operation op)
+  {
+    if (_length >= _size)
+    {
+      return (false);
+    }
+    _buffer[_length++] = (uint8_t)op;
+    return (true);
+  }
+
+  // the number as typed, digits, '.', '-' and 'e',
+  // false if the tape is full or the number can't be packed
+  bool addNumber(const char *number)
+  {
+    size_t characters = strlen(number);
+    size_t packed = (characters + 1) / 2;
+    if ((characters == 0) || (packed > CALC_TAPE_MAX_NUMBER) || (_length + 2 + packed > _size))
+    {
+      return (false);
+    }
+    uint8_t *p = _buffer + _length + 2;
+    for (size_t i = 0; i < packed * 2; i++)
+    {
+      uint8_t nibble = (i < characters) ? toNibble(number[i]) : CALC_NIBBLE_END;
+      if ((nibble == CALC_NIBBLE_END) && (i < characters))
+      {
+        return (false);
+      }
+      if (i & 1)
+      {
+        p[i / 2] |= nibble;
+      }
+      else
+      {
+        p[i / 2] = nibble << 4;
+      }
+    }
+    _buffer[_length] = CALC_TAPE_NUMBER;
+    _buffer[_length + 1] = (uint8_t)packed;
+    _length += 2 + packed;
+    return (true);
+  }
+
+  const uint8_t *getData() const
+  {
+    return (_buffer);
+  }
+
+  size_t getLength() const
+  {
+    return (_length);
+  }
+
+private:
+  uint8_t *_buffer;
+  size_t _size;
+  size_t _length;
+
+  static uint8_t toNibble(char c)
+  {
+    uint8_t nibble;
+
+    switch (c)
+    {
+    case '.':
+      nibble = CALC_NIBBLE_POINT;
+      break;
+
+    case '-':
+      nibble = CALC_NIBBLE_MINUS;
+      break;
+
+    case 'e':
+    case 'E':
+      nibble = CALC_NIBBLE_EXPONENT;
+      break;
+
+    default:
+      nibble = ((c >= '0') && (c <= '9')) ? c - '0' : CALC_NIBBLE_END;
+      break;
+    }
+    return (nibble);
+  }
+};
@@ -0,0 +1,336 @@
+// CalcTrig.h
+
+// sin, cos and tan of angles in degrees
+// the angle is reduced to a quadrant and an angle below 90 degrees
+// without rounding, in the decimal domain for the decimal engine,
+// multiples of 30 and 45 degrees come from a table of exact results,
+// all other angles from a polynomial kernel on 0 to 45 degrees
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <math.h>
+#include <DecimalNumber.h>
+
+// largest power of ten with 360 * 10^n below 2^64
+#define TRIG_MAX_SCALE 16
+
+// kernel results go to the decimal engine with all digits of the double,
+// rounding to 15 digits first would round the display twice
+#define TRIG_RESULT_DIGITS 17
+
+// a result of the table, the digits are for the decimal engine
+typedef struct
+{
+  double value;
+  const char *digits;
+} TRIG_CONSTANT;
+
+// 0, 1/2, sqrt(2)/2, sqrt(3)/2, 1, sqrt(3)/3, sqrt(3)
+static constexpr TRIG_CONSTANT trigConstants[] = {
+    {0.0, "0"},
+    {0.5, "0.5"},
+    {0.70710678118654752440, "0.707106781186547524"},
+    {0.86602540378443864676, "0.866025403784438647"},
+    {1.0, "1"},
+    {0.57735026918962576451, "0.577350269189625765"},
+    {1.73205080756887729353, "1.73205080756887729"}};
+
+// constants of the exact angles 0, 30, 45 and 60 degrees,
+// the cotangent of 0 is undefined
+#define TRIG_EXACT_ANGLES 4
+#define TRIG_UNDEFINED 0xFF
+static constexpr uint8_t trigSinIndex[TRIG_EXACT_ANGLES] = {0, 1, 2, 3};
+static constexpr uint8_t trigCosIndex[TRIG_EXACT_ANGLES] = {4, 3, 2, 1};
+static constexpr uint8_t trigTanIndex[TRIG_EXACT_ANGLES] = {0, 5, 4, 6};
+static constexpr uint8_t trigCotIndex[TRIG_EXACT_ANGLES] = {TRIG_UNDEFINED, 6, 4, 5};
+
+// Taylor coefficients, 1/n! with alternating signs,
+// below 1e-16 relative error up to pi/4
+static constexpr double trigSinCoefficients[] = {
+    1.0, -1.0 / 6, 1.0 / 120, -1.0 / 5040, 1.0 / 362880, -1.0 / 39916800,
+    1.0 / 6227020800.0, -1.0 / 1307674368000.0};
+static constexpr double trigCosCoefficients[] = {
+    1.0, -1.0 / 2, 1.0 / 24, -1.0 / 720, 1.0 / 40320, -1.0 / 3628800,
+    1.0 / 479001600, -1.0 / 87178291200.0, 1.0 / 20922789888000.0};
+
+enum class trig_function : uint8_t
+{
+  sin,
+  cos,
+  tan
+};
+
+// the angle after the reduction: (-1)^negative * (quadrant * 90 + angle),
+// exact is the index of the table angle or -1
+typedef struct
+{
+  bool negative;
+  uint8_t quadrant;
+  int8_t exact;
+  double angle;
+} TRIG_ANGLE;
+
+class CalcTrig
+{
+public:
+  // false if the function is undefined for the angle, tan(90)
+  static bool degrees(trig_function function, const DecimalNumber &angle, DecimalNumber *result)
+  {
+    TRIG_ANGLE reduced;
+    bool negative = false;
+    uint8_t index = 0;
+    double value = 0.0;
+    char buffer[32];
+
+    reduce(angle, &reduced);
+    if (reduced.exact >= 0)
+    {
+      if (!getExact(function, &reduced, &index, &negative))
+      {
+        return (false);
+      }
+      *result = DecimalNumber::fromString(trigConstants[index].digits);
+      if (negative)
+      {
+        *result = -*result;
+      }
+      return (true);
+    }
+    if (!evaluate(function, &reduced, &value))
+    {
+      return (false);
+    }
+    snprintf(buffer, sizeof(buffer), "%.*e", TRIG_RESULT_DIGITS - 1, value);
+    *result = DecimalNumber::fromString(buffer);
+    return (true);
+  }
+
+  static bool degrees(trig_function function, double angle, double *result)
+  {
+    TRIG_ANGLE reduced;
+    bool negative = false;
+    uint8_t index = 0;
+
+    reduce(angle, &reduced);
+    if (reduced.exact >= 0)
+    {
+      if (!getExact(function, &reduced, &index, &negative))
+      {
+        return (false);
+      }
+      *result = negative ? -trigConstants[index].value : trigConstants[index].value;
+      return (true);
+    }
+    return (evaluate(function, &reduced, result));
+  }
+
+  // sin and cos of x in radians, |x| <= pi/4
+  static double kernelSin(double x)
+  {
+    double x2 = x * x;
+    double sum = 0.0;
+    for (int i = sizeof(trigSinCoefficients) / sizeof(trigSinCoefficients[0]) - 1; i >= 0; i--)
+    {
+      sum = sum * x2 + trigSinCoefficients[i];
+    }
+    return (sum * x);
+  }
+
+  static double kernelCos(double x)
+  {
+    double x2 = x * x;
+    double sum = 0.0;
+    for (int i = sizeof(trigCosCoefficients) / sizeof(trigCosCoefficients[0]) - 1; i >= 0; i--)
+    {
+      sum = sum * x2 + trigCosCoefficients[i];
+    }
+    return (sum);
+  }
+
+private:
+  // |angle| mod 360 on the integers of the coefficient, nothing is rounded
+  static void reduce(const DecimalNumber &angle, TRIG_ANGLE *reduced)
+  {
+    uint64_t coefficient = angle.getCoefficient();
+    int exponent = angle.getExponent();
+    uint64_t scale = 1;
+    uint64_t rest;
+
+    reduced->negative = angle.isNegative();
+    if (exponent >= 0)
+    {
+      // coefficient * 10^exponent mod 360
+      uint64_t power = 1;
+      for (int i = 0; i < exponent; i++)
+      {
+        power = (power * 10) % 360;
+      }
+      rest = ((coefficient % 360) * power) % 360;
+    }
+    else if (-exponent <= TRIG_MAX_SCALE)
+    {
+      for (int i = 0; i < -exponent; i++)
+      {
+        scale *= 10;
+      }
+      rest = coefficient % (360 * scale);
+    }
+    else
+    {
+      // below 10 degrees, the quadrant is 0
+      rest = coefficient;
+      scale = 0;
+    }
+    reduced->quadrant = 0;
+    if (scale != 0)
+    {
+      reduced->quadrant = rest / (90 * scale);
+      rest -= reduced->quadrant * 90 * scale;
+    }
+    reduced->exact = -1;
+    if ((rest == 0) || ((scale != 0) && (rest % (15 * scale) == 0)))
+    {
+      reduced->exact = getExactIndex(rest / ((scale != 0) ? scale : 1));
+    }
+    reduced->angle = (scale != 0) ? (double)rest / (double)scale : (double)rest * pow(10.0, exponent);
+  }
+
+  // fmod is exact, the quadrant angle as well
+  static void reduce(double angle, TRIG_ANGLE *reduced)
+  {
+    double rest = fmod(fabs(angle), 360.0);
+
+    reduced->negative = (angle < 0.0);
+    reduced->quadrant = (rest >= 270.0) ? 3 : ((rest >= 180.0) ? 2 : ((rest >= 90.0) ? 1 : 0));
+    reduced->angle = rest - 90.0 * reduced->quadrant;
+    reduced->exact = -1;
+    if (reduced->angle == floor(reduced->angle))
+    {
+      reduced->exact = getExactIndex((uint64_t)reduced->angle);
+    }
+  }
+
+  // index of 0, 30, 45 and 60 degrees, -1 for other angles
+  static int8_t getExactIndex(uint64_t degrees)
+  {
+    switch (degrees)
+    {
+    case 0:
+      return (0);
+    case 30:
+      return (1);
+    case 45:
+      return (2);
+    case 60:
+      return (3);
+    default:
+      return (-1);
+    }
+  }
+
+  // sin(90 + a) = cos(a), cos(90 + a) = -sin(a), tan(90 + a) = -cot(a)
+  static bool getExact(trig_function function, const TRIG_ANGLE *reduced, uint8_t *index, bool *negative)
+  {
+    uint8_t exact = reduced->exact;
+    bool odd = reduced->quadrant & 1;
+
+    switch (function)
+    {
+    case trig_function::sin:
+      *index = odd ? trigCosIndex[exact] : trigSinIndex[exact];
+      *negative = (reduced->quadrant >= 2) != reduced->negative;
+      break;
+
+    case trig_function::cos:
+      *index = odd ? trigSinIndex[exact] : trigCosIndex[exact];
+      *negative = (reduced->quadrant == 1) || (reduced->quadrant == 2);
+      break;
+
+    case trig_function::tan:
+      *index = odd ? trigCotIndex[exact] : trigTanIndex[exact];
+      *negative = odd != reduced->negative;
+      break;
+    }
+    if (*index == TRIG_UNDEFINED)
+    {
+      return (false);
+    }
+    if (*index == 0)
+    {
+      // no -0
+      *negative = false;
+    }
+    return (true);
+  }
+
+  // the kernel on 0 to 45 degrees, above with the complement
+  static bool evaluate(trig_function function, const TRIG_ANGLE *reduced, double *result)
+  {
+    double s;
+    double c;
+    double sinValue;
+    double cosValue;
+
+    if (reduced->angle <= 45.0)
+    {
+      double x = reduced->angle * (PI / 180.0);
+      s = kernelSin(x);
+      c = kernelCos(x);
+    }
+    else
+    {
+      double x = (90.0 - reduced->angle) * (PI / 180.0);
+      s = kernelCos(x);
+      c = kernelSin(x);
+    }
+    switch (reduced->quadrant)
+    {
+    case 1:
+      sinValue = c;
+      cosValue = -s;
+      break;
+
+    case 2:
+      sinValue = -s;
+      cosValue = -c;
+      break;
+
+    case 3:
+      sinValue = -c;
+      cosValue = s;
+      break;
+
+    default:
+      sinValue = s;
+      cosValue = c;
+      break;
+    }
+    if (reduced->negative)
+    {
+      sinValue = -sinValue;
+    }
+    switch (function)
+    {
+    case trig_function::sin:
+      *result = sinValue;
+      break;
+
+    case trig_function::cos:
+      *result = cosValue;
+      break;
+
+    case trig_function::tan:
+      if (cosValue == 0.0)
+      {
+        return (false);
+      }
+      *result = sinValue / cosValue;
+      break;
+    }
+    return (true);
+  }
+};
@@ -1,16 +1,23 @@
 // NixieCalc.cpp
 
 // provides the calculator functions
-// uses double type, 64-bit on ESP32
+// uses either the decimal number type (default) or
+// the double type, 64-bit soft-float on ESP32
 
 // Copyright (C) 2023 highvoltglow
 // Licensed under the MIT License
 
 #include "NixieCalc.h"
+#include "CalcHistory.h"
+#include "CalcTrig.h"
 
 // constructor
-NixieCalc::NixieCalc() : _angleMode(angle_mode::deg)
+NixieCalc::NixieCalc() : _angleMode(angle_mode::deg), _calcMode(calc_mode::algebraic), _stackLevels(RPN_DEFAULT_LEVELS), _history(nullptr)
 {
+  for (uint8_t i = 0; i < MEMORY_REGISTERS; i++)
+  {
+    _memory[i] = 0;
+  }
   onAllClear();
 }
 
@@ -22,6 +29,12 @@ operation_return_code NixieCalc::getOperationReturnCode()
 
 // returns the current result or input value
 double NixieCalc::getDisplayValue()
+{
+  return (toDouble(_displayValue));
+}
+
+// returns the current result or input value in the number type of the engine
+CALCNUMBER NixieCalc::getDisplayNumber()
 {
   return (_displayValue);
 }
@@ -38,20 +51,180 @@ void NixieCalc::setAngleMode(angle_mode angleMode)
   _angleMode = angleMode;
 }
 
+// returns the entry mode, algebraic (default) or rpn
+calc_mode NixieCalc::getCalcMode()
+{
+  return (_calcMode);
+}
+
+// returns the RPN stack levels including X
+uint8_t NixieCalc::getStackLevels()
+{
+  return (_stackLevels);
+}
+
+// sets the entry mode, a pending operation or the stack don't
+// translate to the other mode, everything except memory is cleared
+void NixieCalc::setCalcMode(calc_mode calcMode, uint8_t stackLevels)
+{
+  if (stackLevels < RPN_MIN_LEVELS)
+  {
+    stackLevels = RPN_MIN_LEVELS;
+  }
+  if (stackLevels > RPN_MAX_LEVELS)
+  {
+    stackLevels = RPN_MAX_LEVELS;
+  }
+  if ((calcMode != _calcMode) || (stackLevels != _stackLevels))
+  {
+    _calcMode = calcMode;
+    _stackLevels = stackLevels;
+    onAllClear();
+  }
+}
+
+// returns a stack register, zero above the top
+CALCNUMBER NixieCalc::getStackValue(uint8_t level)
+{
+  if (level == 0)
+  {
+    return (_displayValue);
+  }
+  return ((level < _stackLevels) ? _stack[level - 1] : CALCNUMBER(0));
+}
+
+// copies the complete engine state
+void NixieCalc::getState(NIXIECALC_STATE *state)
+{
+  state->displayValue = _displayValue;
+  state->leftValue = _leftValue;
+  state->rightValue = _rightValue;
+  memcpy(state->memory, _memory, sizeof(_memory));
+  state->operationReturnCode = _operationReturnCode;
+  state->angleMode = _angleMode;
+  state->numberEntered = _numberEntered;
+  state->equalsEntered = _equalsEntered;
+  state->currentOperation = _operation;
+  memcpy(state->stack, _stack, sizeof(_stack));
+  state->lastXValue = _lastXValue;
+  state->calcMode = _calcMode;
+  state->stackLevels = _stackLevels;
+  state->stackLift = _stackLift;
+}
+
+// continues exactly where the snapshot was taken
+void NixieCalc::setState(const NIXIECALC_STATE *state)
+{
+  _displayValue = state->displayValue;
+  _leftValue = state->leftValue;
+  _rightValue = state->rightValue;
+  memcpy(_memory, state->memory, sizeof(_memory));
+  _operationReturnCode = state->operationReturnCode;
+  _angleMode = state->angleMode;
+  _numberEntered = state->numberEntered;
+  _equalsEntered = state->equalsEntered;
+  _operation = state->currentOperation;
+  memcpy(_stack, state->stack, sizeof(_stack));
+  _lastXValue = state->lastXValue;
+  _calcMode = state->calcMode;
+  _stackLevels = state->stackLevels;
+  _stackLift = state->stackLift;
+}
+
+// copies all memory registers
+void NixieCalc::getMemory(CALCNUMBER *memory)
+{
+  memcpy(memory, _memory, sizeof(_memory));
+}
+
+void NixieCalc::setMemory(const CALCNUMBER *memory)
+{
+  memcpy(_memory, memory, sizeof(_memory));
+}
+
+// the history gets every calculation from now on
+void NixieCalc::setHistory(CalcHistory *history)
+{
+  _history = history;
+}
+
+// feeds a tape through the engine in one loop, errors stop the math
+// like on the keyboard, only allclear gets through
+operation_return_code NixieCalc::runTape(const uint8_t *tape, size_t length, CALCNUMBER *displayValue)
+{
+  char number[2 * CALC_TAPE_MAX_NUMBER + 1];
+  size_t position = 0;
+
+  while (position < length)
+  {
+    uint8_t code = tape[position++];
+    if (code == CALC_TAPE_NUMBER)
+    {
+      if ((position >= length) || (tape[position] > CALC_TAPE_MAX_NUMBER) ||
+          (position + 1 + tape[position] > length) ||
+          !unpackNumber(tape + position + 1, tape[position], number))
+      {
+        return (operation_return_code::unknownoperation);
+      }
+      position += 1 + tape[position];
+      onNumericInput(number);
+    }
+    else if (code <= (uint8_t)operation::lastx)
+    {
+      onOperation((operation)code);
+    }
+    else
+    {
+      return (operation_return_code::unknownoperation);
+    }
+  }
+  if (displayValue)
+  {
+    *displayValue = _displayValue;
+  }
+  return (_operationReturnCode);
+}
+
 // call to enter a numeric value
 void NixieCalc::onNumericInput(double value)
+{
+  onNumberInput(CALCNUMBER(value));
+}
+
+// call to enter a numeric value as typed by the user,
+// avoids the binary rounding of the double conversion
+void NixieCalc::onNumericInput(const char *value)
+{
+  CALCNUMBER number;
+  parseNumber(value, &number);
+  onNumberInput(number);
+}
+
+// stores a numeric input value
+void NixieCalc::onNumberInput(const CALCNUMBER &value)
 {
   // accept numeric input only if no previous error
   //  use allclear operation to reset error
   if (_operationReturnCode == operation_return_code::success)
   {
+    if (_calcMode == calc_mode::rpn)
+    {
+      // a new number goes on top of the stack, unless after enter or clear
+      if (_stackLift)
+      {
+        liftStack();
+      }
+      _displayValue = value;
+      _stackLift = true;
+      return;
+    }
     if (_equalsEntered)
     {
       // numeric input after equals, clean up
       _equalsEntered = false;
       _operation = operation::none;
-      _leftValue = 0.0;
-      _rightValue = 0.0;
+      _leftValue = 0;
+      _rightValue = 0;
     }
     _displayValue = value;
     _numberEntered = true;
@@ -61,6 +234,11 @@ void NixieCalc::onNumericInput(double value)
 // call to enter an operation
 void NixieCalc::onOperation(operation op)
 {
+  if (_calcMode == calc_mode::rpn)
+  {
+    onRPNOperation(op);
+    return;
+  }
   // accept operation only if no previous error,
   //  use allclear operation to reset error
   if (_operationReturnCode == operation_return_code::success)
@@ -95,7 +273,7 @@ void NixieCalc::onOperation(operation op)
     case operation::memstore:
     case operation::memsubtraction:
     case operation::memaddition:
-      onMemoryOperation(op);
+      onMemoryOperation(op, 0);
       break;
 
     case operation::euler:
@@ -152,7 +330,7 @@ void NixieCalc::onDualValueOperation(operation op)
   else
   {
     // do calculation
-    double result;
+    CALCNUMBER result;
     _operationReturnCode = calculateValue(&result, _operation, _leftValue, _displayValue);
     _displayValue = result;
     _leftValue = result;
@@ -167,14 +345,14 @@ void NixieCalc::onSingleValueOperation(operation op)
 {
   if (_operation == operation::none)
   {
-    double result;
+    CALCNUMBER result;
     _operationReturnCode = calculateValue(&result, op, _displayValue);
     _leftValue = result;
     _displayValue = result;
   }
   else
   {
-    double result;
+    CALCNUMBER result;
     _operationReturnCode = calculateValue(&result, op, _displayValue);
     _displayValue = result;
   }
@@ -189,7 +367,7 @@ void NixieCalc::onEqualsOperation(operation op)
     if (!_equalsEntered)
     {
       // first equals
-      double result;
+      CALCNUMBER result;
       _operationReturnCode = calculateValue(&result, _operation, _leftValue, _displayValue);
       _equalsEntered = true;
       // store value for repeating operations
@@ -199,7 +377,7 @@ void NixieCalc::onEqualsOperation(operation op)
     else
     {
       // equals after equals, repeat previous operation
-      double result;
+      CALCNUMBER result;
       _operationReturnCode = calculateValue(&result, _operation, _displayValue, _rightValue);
       _leftValue = _displayValue;
       _displayValue = result;
@@ -208,31 +386,190 @@ void NixieCalc::onEqualsOperation(operation op)
   }
 }
 
-// performs memory operations
-void NixieCalc::onMemoryOperation(operation op)
+// RPN: the operations take their operands from the stack,
+// nothing is pending, the result is X and the stack drops after
+// dual value operations, errors leave the stack as it was
+void NixieCalc::onRPNOperation(operation op)
 {
+  CALCNUMBER result;
+
+  // accept only allclear after an error
+  if (_operationReturnCode != operation_return_code::success)
+  {
+    if (op == operation::allclear)
+    {
+      onAllClear();
+    }
+    return;
+  }
+
   switch (op)
   {
+  case operation::addition:
+  case operation::subtraction:
+  case operation::multiplication:
+  case operation::division:
+  case operation::pow:
+    // Y op X
+    _operationReturnCode = calculateValue(&result, op, _stack[0], _displayValue);
+    if (_operationReturnCode == operation_return_code::success)
+    {
+      _lastXValue = _displayValue;
+      dropStack();
+      _displayValue = result;
+      _stackLift = true;
+    }
+    break;
+
+  case operation::squareroot:
+  case operation::inv:
+  case operation::sin:
+  case operation::cos:
+  case operation::tan:
+  case operation::log:
+  case operation::ln:
+  case operation::factorial:
+    _operationReturnCode = calculateValue(&result, op, _displayValue);
+    if (_operationReturnCode == operation_return_code::success)
+    {
+      _lastXValue = _displayValue;
+      _displayValue = result;
+      _stackLift = true;
+    }
+    break;
+
+  case operation::switchsign:
+    // doesn't change lastx or the stack lift
+    _operationReturnCode = calculateValue(&result, op, _displayValue);
+    if (_operationReturnCode == operation_return_code::success)
+    {
+      _displayValue = result;
+    }
+    break;
+
+  case operation::percent:
+    // X percent of Y, Y stays for a following + or -
+    _operationReturnCode = calculateValue(&result, operation::multiplication, _stack[0], _displayValue / 100);
+    if (_operationReturnCode == operation_return_code::success)
+    {
+      _lastXValue = _displayValue;
+      _displayValue = result;
+      _stackLift = true;
+    }
+    break;
+
+  case operation::enter:
+  case operation::equals:
+    // X to Y, the next number overwrites X
+    liftStack();
+    _stackLift = false;
+    break;
+
+  case operation::rolldown:
+    result = _displayValue;
+    _displayValue = _stack[0];
+    dropStack();
+    _stack[_stackLevels - 2] = result;
+    _stackLift = true;
+    break;
+
+  case operation::swap:
+    result = _displayValue;
+    _displayValue = _stack[0];
+    _stack[0] = result;
+    _stackLift = true;
+    break;
+
+  case operation::lastx:
+    onNumberInput(_lastXValue);
+    break;
+
   case operation::memclear:
-    _memoryValue = 0.0;
+  case operation::memread:
+  case operation::memstore:
+  case operation::memsubtraction:
+  case operation::memaddition:
+    onMemoryOperation(op, 0);
+    break;
+
+  case operation::euler:
+  case operation::pi:
+    onConstantOperation(op);
+    break;
+
+  case operation::clear:
+    _displayValue = 0;
+    _stackLift = false;
+    break;
+
+  case operation::allclear:
+    onAllClear();
+    break;
+
+  default:
+    break;
+  }
+}
+
+// pushes X to Y, the top level is lost
+void NixieCalc::liftStack()
+{
+  for (uint8_t i = _stackLevels - 2; i > 0; i--)
+  {
+    _stack[i] = _stack[i - 1];
+  }
+  _stack[0] = _displayValue;
+}
+
+// everything above X moves down one level, the top level is duplicated
+void NixieCalc::dropStack()
+{
+  for (uint8_t i = 0; i + 2 < _stackLevels; i++)
+  {
+    _stack[i] = _stack[i + 1];
+  }
+}
+
+// performs memory operations on one register,
+// accepted only if there is no error, like all operations
+void NixieCalc::onMemoryOperation(operation op, uint8_t memoryRegister)
+{
+  if ((_operationReturnCode != operation_return_code::success) || (memoryRegister >= MEMORY_REGISTERS))
+  {
+    return;
+  }
+  CALCNUMBER &memory = _memory[memoryRegister];
+  switch (op)
+  {
+  case operation::memclear:
+    memory = 0;
     break;
 
   case operation::memread:
     // as entered by user
-    onNumericInput(_memoryValue);
+    onNumberInput(memory);
     break;
 
   case operation::memstore:
-    _memoryValue = _displayValue;
+    memory = _displayValue;
     break;
 
   case operation::memaddition:
-    _memoryValue = _memoryValue + _displayValue;
-    break;
-
   case operation::memsubtraction:
-    _memoryValue = _memoryValue - _displayValue;
+  {
+    CALCNUMBER value = (op == operation::memaddition) ? memory + _displayValue : memory - _displayValue;
+    if (limitRange(&value))
+    {
+      memory = value;
+    }
+    else
+    {
+      // the memory keeps what it had
+      _operationReturnCode = operation_return_code::overflow;
+      _displayValue = 0;
+    }
     break;
+  }
 
   default: // avoid warnings
     break;
@@ -244,11 +581,14 @@ void NixieCalc::onConstantOperation(operation op)
   switch (op)
   {
   case operation::euler:
-    onNumericInput(EULER);
+    onNumericInput(EULER_DIGITS);
     break;
 
   case operation::pi:
-    onNumericInput(PI);
+    onNumericInput(PI_DIGITS);
+    break;
+
+  default: // avoid warnings
     break;
   }
 }
@@ -263,7 +603,7 @@ void NixieCalc::onClearOperation(operation op)
     break;
 
   case operation::clear:
-    _displayValue = 0.0;
+    _displayValue = 0;
     break;
 
   default: // avoid warnings
@@ -276,8 +616,9 @@ void NixieCalc::onPercentOperation(operation op)
 {
   if ((_operation == operation::none) || _equalsEntered)
   {
-    // no previous operation, just divide by 100
+    // no previous operation, just divide by 100, only ever gets smaller
     _displayValue = _displayValue / 100;
+    limitRange(&_displayValue);
     _leftValue = _displayValue;
     _numberEntered = false;
   }
@@ -288,7 +629,8 @@ void NixieCalc::onPercentOperation(operation op)
     // if previous operation
     case operation::addition:
     case operation::subtraction:
-      _displayValue = _leftValue * _displayValue / 100;
+      // the division by 100 is exact, the product is rounded once
+      _displayValue = _leftValue * (_displayValue / 100);
       break;
 
     case operation::multiplication:
@@ -300,25 +642,39 @@ void NixieCalc::onPercentOperation(operation op)
       break;
     }
   }
+  if (!limitRange(&_displayValue))
+  {
+    _operationReturnCode = operation_return_code::overflow;
+    _displayValue = 0;
+  }
 }
 
 // clear all values except memory
 void NixieCalc::onAllClear()
 {
-  _leftValue = 0.0;
-  _rightValue = 0.0;
-  _displayValue = 0.0;
+  _leftValue = 0;
+  _rightValue = 0;
+  _displayValue = 0;
   _operationReturnCode = operation_return_code::success;
   _operation = operation::none;
   _numberEntered = false;
   _equalsEntered = false;
+  for (CALCNUMBER &value : _stack)
+  {
+    value = 0;
+  }
+  _lastXValue = 0;
+  _stackLift = false;
 }
 
 // does the math and catches some basic errors
-operation_return_code NixieCalc::calculateValue(double *result, operation op, double leftValue, double rightValue)
+// the basic arithmetic is done with the engine number type,
+// the other functions are calculated with double values
+operation_return_code NixieCalc::calculateValue(CALCNUMBER *result, operation op, const CALCNUMBER &leftValue, const CALCNUMBER &rightValue)
 {
   operation_return_code retVal = operation_return_code::success;
-  *result = 0.0;
+  *result = 0;
+  double left = 0.0;
   double absolute = 0.0;
 
   switch (op)
@@ -349,7 +705,7 @@ operation_return_code NixieCalc::calculateValue(double *result, operation op, do
   case operation::squareroot:
     if (leftValue >= 0)
     {
-      *result = sqrt(leftValue);
+      *result = CALCNUMBER(sqrt(toDouble(leftValue)));
     }
     else
     {
@@ -358,13 +714,21 @@ operation_return_code NixieCalc::calculateValue(double *result, operation op, do
     break;
 
   case operation::pow:
-    *result = pow(leftValue, rightValue);
+    left = pow(toDouble(leftValue), toDouble(rightValue));
+    if (isnan(left))
+    {
+      retVal = operation_return_code::domain;
+    }
+    else
+    {
+      *result = CALCNUMBER(left);
+    }
     break;
 
   case operation::inv:
     if (leftValue != 0)
     {
-      *result = 1 / leftValue;
+      *result = CALCNUMBER(1) / leftValue;
     }
     else
     {
@@ -376,11 +740,12 @@ operation_return_code NixieCalc::calculateValue(double *result, operation op, do
     switch (_angleMode)
     {
     case angle_mode::deg:
-      *result = sin(leftValue * PI / 180.0);
+      CalcTrig::degrees(trig_function::sin, leftValue, result);
       break;
 
     case angle_mode::rad:
-      *result = sin(leftValue);
+      left = toDouble(leftValue);
+      *result = CALCNUMBER(sin(left));
       break;
     }
     break;
@@ -389,11 +754,12 @@ operation_return_code NixieCalc::calculateValue(double *result, operation op, do
     switch (_angleMode)
     {
     case angle_mode::deg:
-      *result = cos(leftValue * PI / 180.0);
+      CalcTrig::degrees(trig_function::cos, leftValue, result);
       break;
 
     case angle_mode::rad:
-      *result = cos(leftValue);
+      left = toDouble(leftValue);
+      *result = CALCNUMBER(cos(left));
       break;
     }
     break;
@@ -402,20 +768,18 @@ operation_return_code NixieCalc::calculateValue(double *result, operation op, do
     switch (_angleMode)
     {
     case angle_mode::deg:
-      if (abs(remainder(leftValue, 360.0)) == 90)
+      // exact reduction, tan(90) is caught by the table
+      if (!CalcTrig::degrees(trig_function::tan, leftValue, result))
       {
         retVal = operation_return_code::domain;
       }
-      else
-      {
-        *result = tan(leftValue * PI / 180.0);
-      }
       break;
 
     case angle_mode::rad:
-      if (cos(leftValue) != 0.0)
+      left = toDouble(leftValue);
+      if (cos(left) != 0.0)
       {
-        *result = tan(leftValue);
+        *result = CALCNUMBER(tan(left));
       }
       else
       {
@@ -428,7 +792,7 @@ operation_return_code NixieCalc::calculateValue(double *result, operation op, do
   case operation::log:
     if (leftValue > 0)
     {
-      *result = log10(leftValue);
+      *result = CALCNUMBER(log10(toDouble(leftValue)));
     }
     else
     {
@@ -439,7 +803,7 @@ operation_return_code NixieCalc::calculateValue(double *result, operation op, do
   case operation::ln:
     if (leftValue > 0)
     {
-      *result = log(leftValue);
+      *result = CALCNUMBER(log(toDouble(leftValue)));
     }
     else
     {
@@ -448,7 +812,8 @@ operation_return_code NixieCalc::calculateValue(double *result, operation op, do
     break;
 
   case operation::switchsign:
-    *result = leftValue * (-1);
+    // keeps how the value was rounded
+    *result = -leftValue;
     break;
 
   case operation::factorial:
@@ -458,8 +823,8 @@ operation_return_code NixieCalc::calculateValue(double *result, operation op, do
     }
     else
     {
-      absolute = abs(leftValue);
-      if (absolute == floor(absolute) && (leftValue >= 0))
+      absolute = abs(toDouble(leftValue));
+      if (isInteger(leftValue) && (leftValue >= 0))
       {
         *result = 1;
         for (int i = 1; i <= absolute; i++)
@@ -481,15 +846,126 @@ operation_return_code NixieCalc::calculateValue(double *result, operation op, do
   if (retVal == operation_return_code::success)
   {
     // check for result overflow if no other error was produced
-    if ((*result > MAX_CALC_VALUE) || (*result < MIN_CALC_VALUE))
+    if (isOverflow(*result))
     {
       retVal = operation_return_code::overflow;
     }
+    else if (isUnderflow(*result))
+    {
+      *result = 0;
+    }
   }
   // reset result value if an error courred
   if (retVal != operation_return_code::success)
   {
-    *result = 0.0;
+    *result = 0;
+  }
+  if (_history != nullptr)
+  {
+    _history->add(op, leftValue, rightValue, *result, retVal, _angleMode);
   }
   return (retVal);
 }
+
+// range helpers for both engine number types, from MAX_CALC_VALUE on
+// the display would need a 3-digit exponent, nan and infinity overflow as well
+bool NixieCalc::isOverflow(double value)
+{
+  return (!(fabs(value) < MAX_CALC_VALUE));
+}
+
+// the limits are checked on the exact result, like the display rounding,
+// a limit rounded up to comes from an exact result below it
+bool NixieCalc::isOverflow(const DecimalNumber &value)
+{
+  static const DecimalNumber maxValue(MAX_CALC_VALUE);
+
+  if (value.absolute() == maxValue)
+  {
+    return (!value.isRoundedUp());
+  }
+  return (value.absolute() > maxValue);
+}
+
+bool NixieCalc::isUnderflow(double value)
+{
+  return ((value != 0) && (fabs(value) < 1e-99));
+}
+
+bool NixieCalc::isUnderflow(const DecimalNumber &value)
+{
+  int exponent = DECIMAL_PRECISION - 1 + value.getExponent();
+  if (value.isZero() || (exponent > -MAX_CALC_EXPONENT))
+  {
+    return (false);
+  }
+  return ((exponent < -MAX_CALC_EXPONENT) || ((value.getCoefficient() == DECIMAL_MIN_COEFFICIENT) && value.isRoundedUp()));
+}
+
+// checked on the number itself, 0.999999999999999999
+// is no integer even though its double is
+bool NixieCalc::limitRange(CALCNUMBER *value)
+{
+  if (isOverflow(*value))
+  {
+    return (false);
+  }
+  if (isUnderflow(*value))
+  {
+    *value = 0;
+  }
+  return (true);
+}
+
+bool NixieCalc::isInteger(double value)
+{
+  return (value == floor(value));
+}
+
+bool NixieCalc::isInteger(const DecimalNumber &value)
+{
+  return (value.isInteger());
+}
+
+// conversion helpers for both engine number types
+double NixieCalc::toDouble(double value)
+{
+  return (value);
+}
+
+double NixieCalc::toDouble(const DecimalNumber &value)
+{
+  return (value.toDouble());
+}
+
+void NixieCalc::parseNumber(const char *s, double *value)
+{
+  *value = strtod(s, nullptr);
+}
+
+void NixieCalc::parseNumber(const char *s, DecimalNumber *value)
+{
+  *value = DecimalNumber::fromString(s);
+}
+
+// packed tape number to text, false on an invalid nibble
+bool NixieCalc::unpackNumber(const uint8_t *packed, uint8_t length, char *s)
+{
+  static const char characters[] = "0123456789.-e";
+
+  for (uint8_t i = 0; i < 2 * length; i++)
+  {
+    uint8_t nibble = (i & 1) ? (packed[i / 2] & 0x0F) : (packed[i / 2] >> 4);
+    if (nibble == CALC_NIBBLE_END)
+    {
+      break;
+    }
+    if (nibble > CALC_NIBBLE_EXPONENT)
+    {
+      return (false);
+    }
+    *s++ = characters[nibble];
+  }
+  *s = '\0';
+  return (true);
+}
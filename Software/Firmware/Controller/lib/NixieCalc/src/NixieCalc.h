@@ -1,7 +1,8 @@
 // NixieCalc.h
 
 // provides the calculator functions
-// uses double type, 64-bit on ESP32
+// uses either the decimal number type (default) or
+// the double type, 64-bit soft-float on ESP32
 
 // Copyright (C) 2023 highvoltglow
 // Licensed under the MIT License
@@ -10,13 +11,46 @@
 
 #include <Arduino.h>
 #include <math.h>
+#include <type_traits>
+#include <DecimalNumber.h>
 
-// MIN/MAX VALUES, defined for 14-digit calculator
-#define MAX_CALC_VALUE 99999999999999
-#define MIN_CALC_VALUE -99999999999999
-#define MAX_FACT 20
+// range of the results, the display switches to scientific notation
+// beyond 14 digits, results that the 11-digit mantissa would show
+// as 1e100 are an overflow, results below 1e-99 are zero
+#define MAX_CALC_EXPONENT 99
+#define MAX_CALC_VALUE 9.99999999995e99
+#define MAX_FACT 69
+
+// memory registers, the M keys alone work on register 0
+#define MEMORY_REGISTERS 10
+
+// RPN stack levels including X, the stack array is always this big
+#define RPN_MAX_LEVELS 8
+#define RPN_MIN_LEVELS 2
+#define RPN_DEFAULT_LEVELS 4
+
+// constants with all digits of the decimal engine,
+// the double constants are already rounded to 15 digits on conversion
+#define EULER_DIGITS "2.71828182845904524"
+#define PI_DIGITS "3.14159265358979324"
 
 // enums
+enum class calc_engine : uint8_t
+{
+  binary,
+  decimal
+};
+
+//==========================================
+// set here the calculation engine
+#ifndef CALC_ENGINE
+#define CALC_ENGINE calc_engine::decimal
+#endif
+//==========================================
+
+// number type used by the calculation engine
+typedef std::conditional<CALC_ENGINE == calc_engine::decimal, DecimalNumber, double>::type CALCNUMBER;
+
 enum class operation : uint8_t
 {
   none,
@@ -44,7 +78,19 @@ enum class operation : uint8_t
   ln,
   factorial,
   euler,
-  pi
+  pi,
+  enter,
+  rolldown,
+  swap,
+  lastx,
+  // programmer mode, 64-bit integers
+  modulo,
+  bitwiseand,
+  bitwiseor,
+  bitwisexor,
+  bitwisenot,
+  shiftleft,
+  shiftright
 };
 
 enum class operation_return_code : uint8_t
@@ -62,32 +108,103 @@ enum class angle_mode : uint8_t
   rad
 };
 
+// algebraic: left/right register with a pending operation,
+// rpn: operands on a stack, X is the display value
+enum class calc_mode : uint8_t
+{
+  algebraic,
+  rpn
+};
+
+// keystroke tape, calculator input as a compact byte code
+//   operation: one byte, the value of the operation enum
+//   number:    CALC_TAPE_NUMBER, the count of packed bytes, then the
+//              number as typed, two characters per byte, high nibble first,
+//              0-9 digits, the CALC_NIBBLE_ characters, CALC_NIBBLE_END pads
+#define CALC_TAPE_NUMBER 0xFF
+#define CALC_TAPE_MAX_NUMBER 16 // packed bytes, 32 characters
+#define CALC_NIBBLE_POINT 0x0A
+#define CALC_NIBBLE_MINUS 0x0B
+#define CALC_NIBBLE_EXPONENT 0x0C
+#define CALC_NIBBLE_END 0x0F
+
+// complete engine state, trivially copyable,
+// a snapshot can go to RTC memory or a file as it is
+typedef struct
+{
+  CALCNUMBER displayValue;
+  CALCNUMBER leftValue;
+  CALCNUMBER rightValue;
+  CALCNUMBER memory[MEMORY_REGISTERS];
+  operation_return_code operationReturnCode;
+  angle_mode angleMode;
+  bool numberEntered;
+  bool equalsEntered;
+  operation currentOperation;
+  CALCNUMBER stack[RPN_MAX_LEVELS - 1];
+  CALCNUMBER lastXValue;
+  calc_mode calcMode;
+  uint8_t stackLevels;
+  bool stackLift;
+} NIXIECALC_STATE;
+
+static_assert(std::is_trivially_copyable<NIXIECALC_STATE>::value, "Engine state must be trivially copyable!");
+
+class CalcHistory;
+
 // calculator engine class
 class NixieCalc
 {
 public:
   NixieCalc();
 
-  // user input
+  // user input, memory operations work on register 0
   void onOperation(operation op);
+  void onMemoryOperation(operation op, uint8_t memoryRegister);
   void onNumericInput(double value);
+  void onNumericInput(const char *value);
 
   // get return code of math operation
   operation_return_code getOperationReturnCode();
 
   // get input/operation result
   double getDisplayValue();
+  CALCNUMBER getDisplayNumber();
 
   // get/set angle mode
   angle_mode getAngleMode();
   void setAngleMode(angle_mode angleMode);
 
+  // get/set entry mode and RPN stack levels including X,
+  // a change clears everything except memory
+  calc_mode getCalcMode();
+  uint8_t getStackLevels();
+  void setCalcMode(calc_mode calcMode, uint8_t stackLevels = RPN_DEFAULT_LEVELS);
+
+  // RPN stack register, 0 is X, 1 is Y...
+  CALCNUMBER getStackValue(uint8_t level);
+
+  // runs a whole tape, returns the return code after the last entry,
+  // unknownoperation if the tape is malformed, the engine stops there
+  operation_return_code runTape(const uint8_t *tape, size_t length, CALCNUMBER *displayValue = nullptr);
+
+  // snapshot/restore of the engine state
+  void getState(NIXIECALC_STATE *state);
+  void setState(const NIXIECALC_STATE *state);
+
+  // every calculation goes to the history, nullptr (default) to stop
+  void setHistory(CalcHistory *history);
+
+  // all memory registers at once, MEMORY_REGISTERS values
+  void getMemory(CALCNUMBER *memory);
+  void setMemory(const CALCNUMBER *memory);
+
 private:
   // numeric registers
-  double _displayValue;
-  double _leftValue;
-  double _rightValue;
-  double _memoryValue;
+  CALCNUMBER _displayValue;
+  CALCNUMBER _leftValue;
+  CALCNUMBER _rightValue;
+  CALCNUMBER _memory[MEMORY_REGISTERS];
 
   // return code of math operations
   operation_return_code _operationReturnCode;
@@ -102,18 +219,54 @@ private:
   // current operation
   operation _operation;
 
+  // RPN: Y, Z, T... in a fixed array, X is the display value
+  calc_mode _calcMode;
+  uint8_t _stackLevels;
+  CALCNUMBER _stack[RPN_MAX_LEVELS - 1];
+  CALCNUMBER _lastXValue;
+  // a number entry pushes X, off after enter and clear
+  bool _stackLift;
+
+  // calculation tape, not part of the state
+  CalcHistory *_history;
+
   // functions for operation types
   void onDualValueOperation(operation op);
   void onSingleValueOperation(operation op);
-  void onMemoryOperation(operation op);
   void onConstantOperation(operation op);
   void onClearOperation(operation op);
   void onPercentOperation(operation op);
   void onEqualsOperation(operation op);
+  void onRPNOperation(operation op);
+
+  // RPN stack movement
+  void liftStack();
+  void dropStack();
 
   // clean up
   void onAllClear();
 
+  // number input
+  void onNumberInput(const CALCNUMBER &value);
+
   // math operations
-  operation_return_code calculateValue(double *result, operation op, double leftValue, double rightValue = 0.0);
+  operation_return_code calculateValue(CALCNUMBER *result, operation op, const CALCNUMBER &leftValue, const CALCNUMBER &rightValue = 0);
+
+  // range check of the results, both number types
+  static bool isOverflow(double value);
+  static bool isOverflow(const DecimalNumber &value);
+  static bool isUnderflow(double value);
+  static bool isUnderflow(const DecimalNumber &value);
+  // for the results that don't go through calculateValue,
+  // false on an overflow, a value below the range becomes zero
+  static bool limitRange(CALCNUMBER *value);
+  static bool isInteger(double value);
+  static bool isInteger(const DecimalNumber &value);
+
+  // conversion for the functions without a decimal implementation
+  static double toDouble(double value);
+  static double toDouble(const DecimalNumber &value);
+  static void parseNumber(const char *s, double *value);
+  static void parseNumber(const char *s, DecimalNumber *value);
+  static bool unpackNumber(const uint8_t *packed, uint8_t length, char *s);
 };
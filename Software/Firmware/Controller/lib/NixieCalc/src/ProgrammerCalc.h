@@ -0,0 +1,349 @@
+// ProgrammerCalc.h
+
+// programmer mode of the calculator, 64-bit two's complement integers
+// shown in HEX, DEC, OCT or BIN, algebraic entry like NixieCalc
+// everything is integer math, no floating point on any path
+// the arithmetic wraps around like on a 64-bit register,
+// DEC shows the value signed, the other bases show the bit pattern
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <NixieCalc.h>
+
+// 64 binary digits
+#define PROGRAMMER_MAX_DIGITS 64
+
+// the value of the enum is the base
+enum class number_base : uint8_t
+{
+  bin = 2,
+  oct = 8,
+  dec = 10,
+  hex = 16
+};
+
+class ProgrammerCalc
+{
+public:
+  ProgrammerCalc()
+      : _base(number_base::dec)
+  {
+    onAllClear();
+  }
+
+  number_base getBase()
+  {
+    return (_base);
+  }
+
+  // the value stays, only the display changes
+  void setBase(number_base base)
+  {
+    _base = base;
+  }
+
+  operation_return_code getOperationReturnCode()
+  {
+    return (_operationReturnCode);
+  }
+
+  uint64_t getDisplayValue()
+  {
+    return (_displayValue);
+  }
+
+  void onNumericInput(uint64_t value)
+  {
+    if (_operationReturnCode == operation_return_code::success)
+    {
+      if (_equalsEntered)
+      {
+        // numeric input after equals, clean up
+        _equalsEntered = false;
+        _operation = operation::none;
+        _leftValue = 0;
+        _rightValue = 0;
+      }
+      _displayValue = value;
+      _numberEntered = true;
+    }
+  }
+
+  void onOperation(operation op)
+  {
+    if (_operationReturnCode != operation_return_code::success)
+    {
+      // always accept allclear
+      if (op == operation::allclear)
+      {
+        onAllClear();
+      }
+      return;
+    }
+    switch (op)
+    {
+    case operation::addition:
+    case operation::subtraction:
+    case operation::multiplication:
+    case operation::division:
+    case operation::modulo:
+    case operation::bitwiseand:
+    case operation::bitwiseor:
+    case operation::bitwisexor:
+    case operation::shiftleft:
+    case operation::shiftright:
+      onDualValueOperation(op);
+      break;
+
+    case operation::switchsign:
+    case operation::bitwisenot:
+      _operationReturnCode = calculateValue(&_displayValue, op, _displayValue);
+      if (_operation == operation::none)
+      {
+        _leftValue = _displayValue;
+      }
+      break;
+
+    case operation::equals:
+      onEqualsOperation();
+      break;
+
+    case operation::clear:
+      _displayValue = 0;
+      break;
+
+    case operation::allclear:
+      onAllClear();
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  // adds a digit of the base to an input value,
+  // false if the digit is not valid or the value would overflow,
+  // DEC input is a positive signed number, +/- makes it negative
+  static bool appendDigit(uint64_t *value, uint8_t digit, number_base base)
+  {
+    uint64_t radix = (uint64_t)base;
+    uint64_t limit = (base == number_base::dec) ? (uint64_t)INT64_MAX : UINT64_MAX;
+
+    if ((digit >= radix) || (*value > (limit - digit) / radix))
+    {
+      return (false);
+    }
+    *value = *value * radix + digit;
+    return (true);
+  }
+
+  // display windows of digitCount digits the value needs in the base
+  static uint8_t getWindowCount(uint64_t value, number_base base, uint8_t digitCount)
+  {
+    uint8_t digits[PROGRAMMER_MAX_DIGITS];
+    uint8_t count = getDigits(value, base, digits);
+    return ((count + digitCount - 1) / digitCount);
+  }
+
+  // writes one window of digitCount digits, window 0 holds the lowest
+  // digits, higher windows are padded with zeros to the full width,
+  // A to F are the letters of HEX, a negative DEC value gets a '-'
+  // returns the length without the terminator
+  static uint8_t format(uint64_t value, number_base base, uint8_t digitCount, uint8_t window, char *buffer, uint8_t size)
+  {
+    uint8_t digits[PROGRAMMER_MAX_DIGITS];
+    uint8_t count = getDigits(value, base, digits);
+    uint8_t first = window * digitCount;
+    uint8_t length = 0;
+
+    if (first >= count)
+    {
+      // past the top, the last window
+      first = ((count - 1) / digitCount) * digitCount;
+      window = first / digitCount;
+    }
+    uint8_t last = first + digitCount;
+    if ((window == 0) && (last > count))
+    {
+      last = count;
+    }
+    if ((base == number_base::dec) && ((int64_t)value < 0) && (length < size - 1))
+    {
+      buffer[length++] = '-';
+    }
+    for (int i = last - 1; (i >= first) && (length < size - 1); i--)
+    {
+      uint8_t digit = (i < count) ? digits[i] : 0;
+      buffer[length++] = (digit < 10) ? '0' + digit : 'A' + digit - 10;
+    }
+    buffer[length] = 0;
+    return (length);
+  }
+
+private:
+  uint64_t _displayValue;
+  uint64_t _leftValue;
+  uint64_t _rightValue;
+  operation_return_code _operationReturnCode;
+  bool _numberEntered;
+  bool _equalsEntered;
+  operation _operation;
+  number_base _base;
+
+  // same flow as the algebraic entry of NixieCalc
+  void onDualValueOperation(operation op)
+  {
+    if (_operation == operation::none)
+    {
+      _leftValue = _displayValue;
+    }
+    else if (!_numberEntered)
+    {
+      if (_equalsEntered)
+      {
+        // new operation after equals
+        _leftValue = _displayValue;
+      }
+    }
+    else
+    {
+      _operationReturnCode = calculateValue(&_displayValue, _operation, _leftValue, _displayValue);
+      _leftValue = _displayValue;
+    }
+    _operation = op;
+    _numberEntered = false;
+    _equalsEntered = false;
+  }
+
+  void onEqualsOperation()
+  {
+    if (_operation != operation::none)
+    {
+      uint64_t result;
+      if (!_equalsEntered)
+      {
+        _operationReturnCode = calculateValue(&result, _operation, _leftValue, _displayValue);
+        _equalsEntered = true;
+        // store value for repeating operations
+        _rightValue = _displayValue;
+      }
+      else
+      {
+        // equals after equals, repeat previous operation
+        _operationReturnCode = calculateValue(&result, _operation, _displayValue, _rightValue);
+        _leftValue = _displayValue;
+      }
+      _displayValue = result;
+      _numberEntered = false;
+    }
+  }
+
+  void onAllClear()
+  {
+    _displayValue = 0;
+    _leftValue = 0;
+    _rightValue = 0;
+    _operationReturnCode = operation_return_code::success;
+    _operation = operation::none;
+    _numberEntered = false;
+    _equalsEntered = false;
+  }
+
+  // unsigned math wraps without undefined behavior, division and
+  // modulo are signed, the shifts are logical, 64 and more shift
+  // all bits out
+  static operation_return_code calculateValue(uint64_t *result, operation op, uint64_t leftValue, uint64_t rightValue = 0)
+  {
+    int64_t left = (int64_t)leftValue;
+    int64_t right = (int64_t)rightValue;
+
+    *result = leftValue;
+    switch (op)
+    {
+    case operation::addition:
+      *result = leftValue + rightValue;
+      break;
+
+    case operation::subtraction:
+      *result = leftValue - rightValue;
+      break;
+
+    case operation::multiplication:
+      *result = leftValue * rightValue;
+      break;
+
+    case operation::division:
+    case operation::modulo:
+      if (right == 0)
+      {
+        return (operation_return_code::divideByZero);
+      }
+      if ((left == INT64_MIN) && (right == -1))
+      {
+        // the quotient 2^63 doesn't fit, the remainder is 0
+        if (op == operation::division)
+        {
+          return (operation_return_code::overflow);
+        }
+        *result = 0;
+        break;
+      }
+      *result = (uint64_t)((op == operation::division) ? left / right : left % right);
+      break;
+
+    case operation::bitwiseand:
+      *result = leftValue & rightValue;
+      break;
+
+    case operation::bitwiseor:
+      *result = leftValue | rightValue;
+      break;
+
+    case operation::bitwisexor:
+      *result = leftValue ^ rightValue;
+      break;
+
+    case operation::shiftleft:
+      *result = (rightValue < 64) ? leftValue << rightValue : 0;
+      break;
+
+    case operation::shiftright:
+      *result = (rightValue < 64) ? leftValue >> rightValue : 0;
+      break;
+
+    case operation::switchsign:
+      *result = 0 - leftValue;
+      break;
+
+    case operation::bitwisenot:
+      *result = ~leftValue;
+      break;
+
+    default:
+      return (operation_return_code::unknownoperation);
+    }
+    return (operation_return_code::success);
+  }
+
+  // digits of the value in the base, lowest first, at least one,
+  // the magnitude for a negative DEC value
+  static uint8_t getDigits(uint64_t value, number_base base, uint8_t *digits)
+  {
+    uint8_t count = 0;
+
+    if ((base == number_base::dec) && ((int64_t)value < 0))
+    {
+      value = 0 - value;
+    }
+    do
+    {
+      digits[count++] = value % (uint8_t)base;
+      value /= (uint8_t)base;
+    } while (value != 0);
+    return (count);
+  }
+};
@@ -0,0 +1,339 @@
+// NumberFormatter.cpp
+
+// formats calculator numbers for the display
+// the integer part is always shown, the remaining digits of the display
+// are used for decimals, the number is rounded at the last digit
+// and trailing zeros after the decimal point are removed
+// numbers that don't fit or would lose significant digits in fixed
+// notation are shown in scientific notation
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include "NumberFormatter.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// 10^0 to 10^19
+static const uint64_t POWERS_OF_TEN[] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL};
+
+// 64 x 64 bit multiplication, the result is hi * 2^64 + lo
+static void multiply(uint64_t left, uint64_t right, uint64_t *hi, uint64_t *lo)
+{
+  uint64_t ll = (left & 0xFFFFFFFF) * (right & 0xFFFFFFFF);
+  uint64_t lh = (left & 0xFFFFFFFF) * (right >> 32);
+  uint64_t hl = (left >> 32) * (right & 0xFFFFFFFF);
+  uint64_t hh = (left >> 32) * (right >> 32);
+  uint64_t middle = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+
+  *lo = (middle << 32) | (ll & 0xFFFFFFFF);
+  *hi = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+}
+
+uint8_t NumberFormatter::format(const DecimalNumber &number, uint8_t digitCount, char *buffer, uint8_t size)
+{
+  uint64_t coefficient = number.getCoefficient();
+  int exponent = number.getExponent();
+  uint8_t integerDigits = 1;
+  uint8_t mantissaDigits = getMantissaDigits(digitCount);
+  uint64_t mantissa = 0;
+  int decimalExponent = 0;
+  uint64_t value;
+
+  if (coefficient != 0)
+  {
+    // the coefficient is normalized to DECIMAL_PRECISION digits
+    int digits = DECIMAL_PRECISION + exponent;
+    if (digits > integerDigits)
+    {
+      integerDigits = (digits < FORMAT_MAX_POWER) ? digits : FORMAT_MAX_POWER;
+    }
+    // the mantissa for scientific notation, rounded half up
+    uint64_t divisor = getPowerOfTen(DECIMAL_PRECISION - mantissaDigits);
+    decimalExponent = digits - 1;
+    mantissa = coefficient / divisor;
+    if (isRoundingUp(number, coefficient % divisor, divisor))
+    {
+      mantissa++;
+    }
+    if (mantissa == getPowerOfTen(mantissaDigits))
+    {
+      mantissa /= 10;
+      decimalExponent++;
+    }
+    // after the rounding, the 18 digits may be just below a power of ten
+    if (!fitsFixed(mantissa, mantissaDigits, decimalExponent, digitCount))
+    {
+      return (composeScientific(number.isNegative(), mantissa, mantissaDigits, decimalExponent, buffer, size));
+    }
+  }
+
+  uint8_t decimals = getDecimals(integerDigits, digitCount);
+  // value * 10^decimals = coefficient * 10^shift
+  int shift = exponent + decimals;
+  if (shift >= 0)
+  {
+    // whole number, doesn't overflow as long as the integer part fits into the display
+    value = coefficient * getPowerOfTen(shift);
+  }
+  else if (shift > -FORMAT_MAX_POWER)
+  {
+    uint64_t divisor = getPowerOfTen(-shift);
+    value = coefficient / divisor;
+    if (isRoundingUp(number, coefficient % divisor, divisor))
+    {
+      value++;
+    }
+  }
+  else
+  {
+    // the coefficient has less digits than the divisor, always below half
+    value = 0;
+  }
+  if ((decimals == 0) && (value >= getPowerOfTen(digitCount)))
+  {
+    // rounded up to one digit more than the display has
+    return (composeScientific(number.isNegative(), mantissa, mantissaDigits, decimalExponent, buffer, size));
+  }
+  return (compose(number.isNegative(), value, decimals, buffer, size));
+}
+
+uint8_t NumberFormatter::format(double number, uint8_t digitCount, char *buffer, uint8_t size)
+{
+  uint8_t integerDigits = 1;
+  uint64_t value = 0;
+  int exponent;
+  double magnitude = fabs(number);
+
+  if (!isfinite(number))
+  {
+    return (compose(false, 0, 0, buffer, size));
+  }
+
+  if (magnitude >= 1)
+  {
+    integerDigits = (magnitude < 1e19) ? countDigits((uint64_t)magnitude) : FORMAT_MAX_POWER;
+  }
+  // scientific notation, printf rounds the exact binary value
+  uint8_t mantissaDigits = getMantissaDigits(digitCount);
+  uint64_t scientificMantissa = 0;
+  int decimalExponent = 0;
+  if (magnitude != 0)
+  {
+    char text[32];
+    char *mark;
+    snprintf(text, sizeof(text), "%.*e", mantissaDigits - 1, magnitude);
+    mark = strchr(text, 'e');
+    decimalExponent = atoi(mark + 1);
+    for (char *c = text; c < mark; c++)
+    {
+      if (*c != '.')
+      {
+        scientificMantissa = scientificMantissa * 10 + (*c - '0');
+      }
+    }
+    int unrounded = (magnitude >= 1) ? (integerDigits - 1) : decimalExponent;
+    if ((magnitude >= 1e19) || !fitsFixed(scientificMantissa, mantissaDigits, unrounded, digitCount))
+    {
+      return (composeScientific(number < 0, scientificMantissa, mantissaDigits, decimalExponent, buffer, size));
+    }
+  }
+
+  uint8_t decimals = getDecimals(integerDigits, digitCount);
+
+  // magnitude = mantissa * 2^exponent, exactly
+  uint64_t mantissa = (uint64_t)ldexp(frexp(magnitude, &exponent), 53);
+  exponent -= 53;
+
+  if (mantissa != 0)
+  {
+    uint64_t hi;
+    uint64_t lo;
+    // mantissa * 10^decimals has at most 53 + 64 bits
+    multiply(mantissa, getPowerOfTen(decimals), &hi, &lo);
+    if (exponent >= 0)
+    {
+      // whole number, doesn't overflow as long as the integer part fits into the display
+      value = (exponent < 64) ? (lo << exponent) : 0;
+    }
+    else if (exponent > -128)
+    {
+      // value = (hi, lo) >> -exponent, rounded half to even on the remainder
+      uint8_t bits = -exponent;
+      uint64_t remainderHi;
+      uint64_t remainderLo;
+      uint64_t halfHi;
+      uint64_t halfLo;
+
+      if (bits < 64)
+      {
+        value = (lo >> bits) | (hi << (64 - bits));
+        remainderHi = 0;
+        remainderLo = lo & ((1ULL << bits) - 1);
+        halfHi = 0;
+        halfLo = 1ULL << (bits - 1);
+      }
+      else
+      {
+        value = hi >> (bits - 64);
+        remainderHi = hi & ((1ULL << (bits - 64)) - 1);
+        remainderLo = lo;
+        halfHi = (bits > 64) ? (1ULL << (bits - 65)) : 0;
+        halfLo = (bits > 64) ? 0 : (1ULL << 63);
+      }
+      if ((remainderHi > halfHi) || ((remainderHi == halfHi) && (remainderLo > halfLo)) ||
+          ((remainderHi == halfHi) && (remainderLo == halfLo) && (value & 1)))
+      {
+        value++;
+      }
+    }
+  }
+  if ((decimals == 0) && (value >= getPowerOfTen(digitCount)))
+  {
+    // rounded up to one digit more than the display has
+    return (composeScientific(number < 0, scientificMantissa, mantissaDigits, decimalExponent, buffer, size));
+  }
+  return (compose(number < 0, value, decimals, buffer, size));
+}
+
+// half up, a number on the tie that was rounded up before
+// comes from an exact value below the tie
+bool NumberFormatter::isRoundingUp(const DecimalNumber &number, uint64_t remainder, uint64_t divisor)
+{
+  if (remainder == divisor / 2)
+  {
+    return (!number.isRoundedUp());
+  }
+  return (remainder > divisor / 2);
+}
+
+uint8_t NumberFormatter::compose(bool negative, uint64_t value, uint8_t decimals, char *buffer, uint8_t size)
+{
+  char digits[FORMAT_MAX_POWER + 2];
+  uint8_t digitCount = 0;
+  uint8_t length = 0;
+
+  // trailing zeros of the decimals are not shown
+  while ((decimals > 0) && (value % 10 == 0))
+  {
+    value /= 10;
+    decimals--;
+  }
+  // digits in reverse order, at least one before the decimal point
+  do
+  {
+    digits[digitCount++] = '0' + (value % 10);
+    value /= 10;
+  } while ((value != 0) || (digitCount <= decimals));
+
+  // a number rounded to zero has no sign
+  if (negative && ((digitCount > 1) || (digits[0] != '0')) && (length < size - 1))
+  {
+    buffer[length++] = '-';
+  }
+  while ((digitCount > 0) && (length < size - 1))
+  {
+    buffer[length++] = digits[--digitCount];
+    if ((digitCount == decimals) && (decimals > 0) && (length < size - 1))
+    {
+      buffer[length++] = '.';
+    }
+  }
+  buffer[length] = 0;
+  return (length);
+}
+
+uint8_t NumberFormatter::composeScientific(bool negative, uint64_t mantissa, uint8_t mantissaDigits, int exponent, char *buffer, uint8_t size)
+{
+  if (exponent > FORMAT_MAX_EXPONENT)
+  {
+    // beyond the range, the calculator reports an overflow before
+    buffer[0] = 0;
+    return (0);
+  }
+  else if (exponent < -FORMAT_MAX_EXPONENT)
+  {
+    // below the range, the calculator makes it zero before
+    return (compose(false, 0, 0, buffer, size));
+  }
+  uint8_t length = compose(negative, mantissa, mantissaDigits - 1, buffer, size);
+  if (length + FORMAT_EXPONENT_DIGITS + 2 < size)
+  {
+    buffer[length++] = FORMAT_EXPONENT_MARK;
+    if (exponent < 0)
+    {
+      buffer[length++] = '-';
+      exponent = -exponent;
+    }
+    buffer[length++] = '0' + exponent / 10;
+    buffer[length++] = '0' + exponent % 10;
+    buffer[length] = 0;
+  }
+  return (length);
+}
+
+// a number below one has digitCount + exponent significant digits
+// in fixed notation, enough if the mantissa has no more
+bool NumberFormatter::fitsFixed(uint64_t mantissa, uint8_t mantissaDigits, int exponent, uint8_t digitCount)
+{
+  if (exponent >= 0)
+  {
+    return (exponent < digitCount);
+  }
+  uint8_t significantDigits = mantissaDigits;
+  while ((significantDigits > 1) && (mantissa % 10 == 0))
+  {
+    mantissa /= 10;
+    significantDigits--;
+  }
+  return (significantDigits <= digitCount + exponent);
+}
+
+uint8_t NumberFormatter::countDigits(uint64_t value)
+{
+  uint8_t digits = 1;
+  while ((digits <= FORMAT_MAX_POWER) && (value >= POWERS_OF_TEN[digits]))
+  {
+    digits++;
+  }
+  return (digits);
+}
+
+// the display digits left after the integer part
+uint8_t NumberFormatter::getDecimals(uint8_t integerDigits, uint8_t digitCount)
+{
+  return ((integerDigits < digitCount) ? (digitCount - integerDigits) : 0);
+}
+
+// the digits left for the mantissa after the blank tube and the exponent
+uint8_t NumberFormatter::getMantissaDigits(uint8_t digitCount)
+{
+  uint8_t digits = (digitCount > FORMAT_EXPONENT_DIGITS + 2) ? (digitCount - FORMAT_EXPONENT_DIGITS - 1) : 1;
+  return ((digits < DECIMAL_PRECISION) ? digits : DECIMAL_PRECISION - 1);
+}
+
+uint64_t NumberFormatter::getPowerOfTen(uint8_t exponent)
+{
+  return (POWERS_OF_TEN[(exponent < FORMAT_MAX_POWER) ? exponent : FORMAT_MAX_POWER]);
+}
@@ -0,0 +1,55 @@
+// NumberFormatter.h
+
+// formats calculator numbers for the display
+// the integer part is always shown, the remaining digits of the display
+// are used for decimals, the number is rounded at the last digit
+// and trailing zeros after the decimal point are removed
+// numbers that don't fit or would lose significant digits in fixed
+// notation are shown as mantissa, a blank tube and a 2-digit exponent,
+// written as "-1.2345678901e-05", the display lights the decimal point
+// of the blank tube for a negative exponent
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <DecimalNumber.h>
+
+// 10^19 is the largest power of ten below 2^64
+#define FORMAT_MAX_POWER 19
+
+// scientific notation, the mantissa gets the digits left after
+// the exponent and the blank tube in front of it
+#define FORMAT_EXPONENT_DIGITS 2
+#define FORMAT_MAX_EXPONENT 99
+#define FORMAT_EXPONENT_MARK 'e'
+
+class NumberFormatter
+{
+public:
+  // writes the number to buffer with at most digitCount digits,
+  // returns the length without the terminator, 0 and nothing written
+  // if it would need an exponent above FORMAT_MAX_EXPONENT
+  // the value is rounded half up, like the decimal arithmetic,
+  // from the exact result of the last operation, not its 18 digits
+  static uint8_t format(const DecimalNumber &number, uint8_t digitCount, char *buffer, uint8_t size);
+
+  // the exact binary value is rounded half to even, like printf does
+  static uint8_t format(double number, uint8_t digitCount, char *buffer, uint8_t size);
+
+private:
+  // writes value / 10^decimals and removes trailing zeros
+  // true if remainder / divisor rounds up
+  static bool isRoundingUp(const DecimalNumber &number, uint64_t remainder, uint64_t divisor);
+  static uint8_t compose(bool negative, uint64_t value, uint8_t decimals, char *buffer, uint8_t size);
+  // writes mantissa / 10^(mantissaDigits - 1) * 10^exponent
+  static uint8_t composeScientific(bool negative, uint64_t mantissa, uint8_t mantissaDigits, int exponent, char *buffer, uint8_t size);
+  // true if fixed notation shows all significant digits of the rounded mantissa
+  static bool fitsFixed(uint64_t mantissa, uint8_t mantissaDigits, int exponent, uint8_t digitCount);
+  static uint8_t getMantissaDigits(uint8_t digitCount);
+  static uint8_t countDigits(uint64_t value);
+  static uint8_t getDecimals(uint8_t integerDigits, uint8_t digitCount);
+  static uint64_t getPowerOfTen(uint8_t exponent);
+};
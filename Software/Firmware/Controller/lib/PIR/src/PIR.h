@@ -9,6 +9,7 @@
 
 #include <Arduino.h>
 #include <Settings.h>
+#include <Events.h>
 
 class PIR
 {
@@ -64,6 +65,7 @@ private:
   static void setPIRTimeout()
   {
     _instance->handlePIRTimeout();
+    Events::signalFromISR(EVENT_PIR);
   };
 };
 
@@ -58,7 +58,8 @@ namespace setting_id
     stddow,          // Standard time change, day of week
     stdmonth,        // Standard time change, month
     stdhour,         // Standard time change, hour
-    stdoffset        // Standard time change, offset to UTC in minutes
+    stdoffset,       // Standard time change, offset to UTC in minutes
+    entrymode        // Algebraic entry or RPN with a 4 or 8 level stack in calculator mode
   };
 }
 
@@ -242,6 +243,16 @@ namespace flicker_mode
   };
 }
 
+namespace entry_mode
+{
+  enum entry_mode
+  {
+    algebraic,
+    rpn4,
+    rpn8
+  };
+}
+
 namespace acp_force_on
 {
   enum acp_force_on
@@ -69,6 +69,7 @@ public:
     _settings[setting_id::stdmonth] = new Setting(setting_id::stdmonth, setting_type::numeric, month_t::Oct, month_t::Jan, month_t::Dec);
     _settings[setting_id::stdhour] = new Setting(setting_id::stdhour, setting_type::numeric, 3, 0, 23);
     _settings[setting_id::stdoffset] = new Setting(setting_id::stdoffset, setting_type::numeric, 60, -720, 840);
+    _settings[setting_id::entrymode] = new Setting(setting_id::entrymode, setting_type::numeric, entry_mode::algebraic, entry_mode::algebraic, entry_mode::rpn8);
   }
 
   virtual ~Settings()
@@ -0,0 +1,152 @@
+// Stopwatch.h
+
+// stopwatch on the ESP32 timer, start, stop and laps take the time
+// the key was pressed, not the time the main loop got to it,
+// the last laps are kept in a ring buffer
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// laps kept, the older ones are overwritten
+#define STOPWATCH_LAPS 16
+
+enum class stopwatch_mode : uint8_t
+{
+  zero,
+  stopped,
+  running
+};
+
+typedef struct
+{
+  uint16_t number; // counts from 1, also for the overwritten ones
+  int64_t split;   // us since the start
+  int64_t lap;     // us since the lap before
+} STOPWATCH_LAP;
+
+class Stopwatch
+{
+public:
+  Stopwatch()
+  {
+    reset();
+  }
+
+  // back to zero, the laps are gone
+  void reset()
+  {
+    _mode = stopwatch_mode::zero;
+    _startMicros = 0;
+    _elapsed = 0;
+    _lapCount = 0;
+    _first = 0;
+    _lapTotal = 0;
+  }
+
+  // micros is the ESP32 timer when the key was pressed,
+  // a stopped stopwatch goes on from where it stopped
+  void start(int64_t micros)
+  {
+    if (_mode != stopwatch_mode::running)
+    {
+      _startMicros = micros - _elapsed;
+      _mode = stopwatch_mode::running;
+    }
+  }
+
+  void stop(int64_t micros)
+  {
+    if (_mode == stopwatch_mode::running)
+    {
+      _elapsed = getElapsed(micros);
+      _mode = stopwatch_mode::stopped;
+    }
+  }
+
+  // takes a lap while running, returns its number, 0 if none was taken
+  uint16_t lap(int64_t micros)
+  {
+    if ((_mode != stopwatch_mode::running) || (_lapTotal == UINT16_MAX))
+    {
+      return (0);
+    }
+    STOPWATCH_LAP lap;
+    lap.number = _lapTotal + 1;
+    lap.split = getElapsed(micros);
+    lap.lap = lap.split - (_lapCount ? getLapAt(_lapCount - 1).split : 0);
+    if (_lapCount < STOPWATCH_LAPS)
+    {
+      getLapAt(_lapCount) = lap;
+      _lapCount++;
+    }
+    else
+    {
+      _laps[_first] = lap;
+      _first = (_first + 1) % STOPWATCH_LAPS;
+    }
+    _lapTotal++;
+    return (lap.number);
+  }
+
+  stopwatch_mode getMode()
+  {
+    return (_mode);
+  }
+
+  // us at the ESP32 timer micros
+  int64_t getElapsed(int64_t micros)
+  {
+    if (_mode == stopwatch_mode::running)
+    {
+      // a key pressed just before the loop looked at the timer
+      return ((micros > _startMicros) ? micros - _startMicros : 0);
+    }
+    return (_elapsed);
+  }
+
+  int64_t getElapsed()
+  {
+    return (getElapsed(esp_timer_get_time()));
+  }
+
+  // numbers of the oldest and the newest lap kept, 0 if there is none
+  uint16_t getFirstLap()
+  {
+    return (_lapCount ? (_lapTotal - _lapCount) + 1 : 0);
+  }
+
+  uint16_t getLastLap()
+  {
+    return (_lapTotal);
+  }
+
+  // nullptr if the lap was not taken or is overwritten
+  const STOPWATCH_LAP *getLap(uint16_t number)
+  {
+    if ((number == 0) || (number < getFirstLap()) || (number > _lapTotal))
+    {
+      return (nullptr);
+    }
+    return (&getLapAt(number - getFirstLap()));
+  }
+
+private:
+  STOPWATCH_LAP _laps[STOPWATCH_LAPS];
+  stopwatch_mode _mode;
+  int64_t _startMicros;
+  int64_t _elapsed;
+  uint8_t _lapCount;
+  uint8_t _first;
+  uint16_t _lapTotal;
+
+  // index 0 is the oldest lap kept
+  STOPWATCH_LAP &getLapAt(uint8_t index)
+  {
+    return (_laps[(_first + index) % STOPWATCH_LAPS]);
+  }
+};
@@ -0,0 +1,254 @@
+// TimeDiscipline.h
+
+// disciplines the DS3232 to GPS time, every GPS sample gives the offset
+// of the RTC and of the ESP32 timer to GPS, a least squares fit over
+// the samples of the last hours estimates the drift of the free running
+// RTC, the aging offset register trims the RTC by the drift and slews
+// the phase offset out, only large offsets are stepped, the steps and the
+// aging offset are taken out of the samples, the fit goes on over them
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+
+// the fit keeps the samples of about the last 8 hours, 30 minutes apart,
+// the newest sample is replaced until it is that far from the one before
+#define DISCIPLINE_SAMPLES 16
+#define DISCIPLINE_SAMPLE_SPACING 1800 // s
+// the drift is estimated once the samples cover 2 hours
+#define DISCIPLINE_MIN_SPAN 7200 // s
+// larger offsets set the RTC at the next GPS second
+#define DISCIPLINE_STEP_THRESHOLD 128000 // us
+// smaller ones are slewed out with this time constant
+#define DISCIPLINE_TIME_CONSTANT 14400 // s
+
+// the aging offset register of the DS3232, about 0.1 ppm per LSB at 25 °C,
+// positive values slow the oscillator down, it takes effect with the
+// next temperature conversion, within 64 seconds
+#define DS3232_AGING_REGISTER 0x10
+#define DS3232_AGING_PPM 0.1
+#define DS3232_AGING_LIMIT 127
+
+enum class discipline_action : uint8_t
+{
+  none,
+  slew, // write the new aging offset
+  step  // write it too and set the RTC at the next GPS second
+};
+
+typedef struct
+{
+  double time;      // s of GPS time since the first sample
+  double rtcOffset; // us, the free running RTC ahead of GPS
+  double espOffset; // us, the ESP32 timer ahead of GPS
+} DISCIPLINE_SAMPLE;
+
+class TimeDiscipline
+{
+public:
+  TimeDiscipline()
+  {
+    _aging = 0;
+    _rtcDrift = 0;
+    _espDrift = 0;
+    _driftValid = false;
+    _sampleCount = 0;
+    _stepCount = 0;
+    _offset = 0;
+    reset();
+  }
+
+  // forgets the samples after the time was set by someone else,
+  // the drift estimate and the aging offset stay
+  void reset()
+  {
+    _count = 0;
+    _first = 0;
+    _baseTime = 0;
+    _baseESPTime = 0;
+    _lastTime = 0;
+    _correction = 0;
+    _phase = 0;
+  }
+
+  // the aging offset of the RTC at power on
+  void setAging(int8_t aging)
+  {
+    _aging = aging;
+  }
+
+  int8_t getAging()
+  {
+    return (_aging);
+  }
+
+  // gpsTime in us since 1970, rtcOffset is how far the RTC is ahead
+  // of GPS at gpsTime in us, espTime is the ESP32 timer at gpsTime
+  discipline_action addSample(int64_t gpsTime, int64_t rtcOffset, int64_t espTime)
+  {
+    _sampleCount++;
+    _offset = rtcOffset;
+    if (_count == 0)
+    {
+      _baseTime = gpsTime;
+      _baseESPTime = espTime;
+    }
+    double time = (double)(gpsTime - _baseTime) / 1e6;
+    // the aging offset took this many us from the RTC since the last sample
+    _correction += _aging * DS3232_AGING_PPM * (time - _lastTime);
+    _lastTime = time;
+
+    DISCIPLINE_SAMPLE sample;
+    sample.time = time;
+    sample.rtcOffset = (double)rtcOffset + _correction;
+    sample.espOffset = (double)((espTime - _baseESPTime) - (gpsTime - _baseTime));
+    storeSample(sample);
+    estimate(time);
+
+    bool step = (llabs(rtcOffset) > DISCIPLINE_STEP_THRESHOLD);
+    if (step)
+    {
+      // setting the RTC to GPS time takes the offset out
+      _correction += (double)rtcOffset;
+      _phase -= (double)rtcOffset;
+      _stepCount++;
+    }
+    // drift and phase in ppm
+    long aging = lround((_rtcDrift + _phase / DISCIPLINE_TIME_CONSTANT) / DS3232_AGING_PPM);
+    if (aging > DS3232_AGING_LIMIT)
+    {
+      aging = DS3232_AGING_LIMIT;
+    }
+    else if (aging < -DS3232_AGING_LIMIT)
+    {
+      aging = -DS3232_AGING_LIMIT;
+    }
+    if (aging != _aging)
+    {
+      _aging = (int8_t)aging;
+      return (step ? discipline_action::step : discipline_action::slew);
+    }
+    return (step ? discipline_action::step : discipline_action::none);
+  }
+
+  // the RTC ahead of GPS at the last sample, us
+  int64_t getOffset()
+  {
+    return (_offset);
+  }
+
+  // drift of the free running RTC, ppm, positive if it runs fast
+  double getRTCDrift()
+  {
+    return (_rtcDrift);
+  }
+
+  // drift of the ESP32 timer, ppm, positive if it runs fast
+  double getESPDrift()
+  {
+    return (_espDrift);
+  }
+
+  bool isDriftValid()
+  {
+    return (_driftValid);
+  }
+
+  void dump(Print &out)
+  {
+    out.printf("gps time sync, %u samples, %u steps\r\n", _sampleCount, _stepCount);
+    out.printf("rtc offset: %+lld us, phase %+.0f us\r\n", (long long)_offset, _phase);
+    out.printf("rtc drift: %+.3f ppm%s, aging offset %d\r\n", _rtcDrift,
+               _driftValid ? "" : " (not estimated yet)", _aging);
+    out.printf("esp32 timer drift: %+.3f ppm\r\n", _espDrift);
+    if (_count)
+    {
+      out.printf("fit: %u samples over %.0f s\r\n", _count, getSample(_count - 1).time - getSample(0).time);
+    }
+  }
+
+private:
+  DISCIPLINE_SAMPLE _samples[DISCIPLINE_SAMPLES];
+  uint8_t _count;
+  uint8_t _first;
+  int64_t _baseTime;
+  int64_t _baseESPTime;
+  double _lastTime;
+  // phase the aging offset took from the RTC since the first sample, us
+  double _correction;
+  // fitted offset of the RTC at the last sample, us
+  double _phase;
+  double _rtcDrift;
+  double _espDrift;
+  bool _driftValid;
+  int8_t _aging;
+  int64_t _offset;
+  uint32_t _sampleCount;
+  uint32_t _stepCount;
+
+  DISCIPLINE_SAMPLE &getSample(uint8_t index)
+  {
+    return (_samples[(_first + index) % DISCIPLINE_SAMPLES]);
+  }
+
+  void storeSample(const DISCIPLINE_SAMPLE &sample)
+  {
+    if ((_count >= 2) && (sample.time - getSample(_count - 2).time < DISCIPLINE_SAMPLE_SPACING))
+    {
+      getSample(_count - 1) = sample;
+    }
+    else if (_count < DISCIPLINE_SAMPLES)
+    {
+      getSample(_count) = sample;
+      _count++;
+    }
+    else
+    {
+      _samples[_first] = sample;
+      _first = (_first + 1) % DISCIPLINE_SAMPLES;
+    }
+  }
+
+  // fits both offsets over the samples if they cover enough time,
+  // before that the last offset is taken as it is
+  void estimate(double time)
+  {
+    double span = getSample(_count - 1).time - getSample(0).time;
+
+    _phase = (double)_offset;
+    if ((_count < 3) || (span < DISCIPLINE_MIN_SPAN))
+    {
+      return;
+    }
+    double meanTime = 0;
+    double meanRTC = 0;
+    double meanESP = 0;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+      meanTime += getSample(i).time;
+      meanRTC += getSample(i).rtcOffset;
+      meanESP += getSample(i).espOffset;
+    }
+    meanTime /= _count;
+    meanRTC /= _count;
+    meanESP /= _count;
+    double sxx = 0;
+    double sxr = 0;
+    double sxe = 0;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+      double dx = getSample(i).time - meanTime;
+      sxx += dx * dx;
+      sxr += dx * (getSample(i).rtcOffset - meanRTC);
+      sxe += dx * (getSample(i).espOffset - meanESP);
+    }
+    // us per s are ppm
+    _rtcDrift = sxr / sxx;
+    _espDrift = sxe / sxx;
+    _driftValid = true;
+    _phase = meanRTC + _rtcDrift * (time - meanTime) - _correction;
+  }
+};
@@ -0,0 +1,129 @@
+// TimeZoneCache.h
+
+// caches the offset of a Timezone together with the UTC interval
+// it is valid for, the interval ends at the next change of DST or
+// at the start of the next UTC year, where the library computes
+// the changes again, a conversion inside it is a compare and an add
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <TimeLib.h>
+#include <Timezone.h> // https://github.com/JChristensen/Timezone
+
+class TimeZoneCache
+{
+public:
+  TimeZoneCache()
+      : _timeZone(nullptr),
+        _offset(0),
+        _validFrom(0),
+        _validUntil(0)
+  {
+  }
+
+  // call it every time the rules of the time zone are set
+  void setTimeZone(Timezone *timeZone, const TimeChangeRule &dstRule, const TimeChangeRule &stdRule)
+  {
+    _timeZone = timeZone;
+    _dstRule = dstRule;
+    _stdRule = stdRule;
+    invalidate();
+  }
+
+  void invalidate()
+  {
+    _validFrom = 0;
+    _validUntil = 0;
+  }
+
+  time_t toLocal(time_t utc)
+  {
+    if ((utc < _validFrom) || (utc >= _validUntil))
+    {
+      update(utc);
+    }
+    return (utc + _offset);
+  }
+
+private:
+  Timezone *_timeZone;
+  TimeChangeRule _dstRule;
+  TimeChangeRule _stdRule;
+  time_t _offset;
+  time_t _validFrom;
+  time_t _validUntil;
+
+  // takes the offset from the library and limits its interval
+  // with the changes the library uses for the year of utc
+  void update(time_t utc)
+  {
+    tmElements_t tm;
+    int yr = year(utc);
+
+    tm.Second = 0;
+    tm.Minute = 0;
+    tm.Hour = 0;
+    tm.Day = 1;
+    tm.Month = 1;
+    tm.Year = CalendarYrToTm(yr);
+    _validFrom = makeTime(tm);
+    tm.Year++;
+    _validUntil = makeTime(tm);
+
+    // no changes if DST is not observed
+    if (_dstRule.offset != _stdRule.offset)
+    {
+      time_t changes[2];
+      changes[0] = getChangeTime(_dstRule, yr) - _stdRule.offset * SECS_PER_MIN;
+      changes[1] = getChangeTime(_stdRule, yr) - _dstRule.offset * SECS_PER_MIN;
+      for (uint8_t i = 0; i < 2; i++)
+      {
+        if ((changes[i] <= utc) && (changes[i] > _validFrom))
+        {
+          _validFrom = changes[i];
+        }
+        else if ((changes[i] > utc) && (changes[i] < _validUntil))
+        {
+          _validUntil = changes[i];
+        }
+      }
+    }
+    _offset = _timeZone->toLocal(utc) - utc;
+  }
+
+  // local time of a change in the given year, the same way the library does
+  static time_t getChangeTime(const TimeChangeRule &rule, int yr)
+  {
+    uint8_t month = rule.month;
+    uint8_t week = rule.week;
+
+    // the last week is one week before the first one of the next month
+    if (week == Last)
+    {
+      if (++month > 12)
+      {
+        month = 1;
+        yr++;
+      }
+      week = First;
+    }
+    tmElements_t tm;
+    tm.Second = 0;
+    tm.Minute = 0;
+    tm.Hour = rule.hour;
+    tm.Day = 1;
+    tm.Month = month;
+    tm.Year = CalendarYrToTm(yr);
+    time_t t = makeTime(tm);
+    t += ((rule.dow - weekday(t) + 7) % 7 + (week - 1) * 7) * SECS_PER_DAY;
+    if (rule.week == Last)
+    {
+      t -= 7 * SECS_PER_DAY;
+    }
+    return (t);
+  }
+};
@@ -61,7 +61,7 @@ void ubGPSTime::initialize(bool wait)
 // reads from serial port
 void ubGPSTime::process()
 {
-  char c = 0;
+  uint8_t c = 0;
 
   if (_serialPort)
   {
@@ -558,6 +558,9 @@ void ubGPSTime::onVersion(UBXMESSAGE *message)
       _moduleVersion.extensions[i] = "N/A";
     }
   }
+  // a module answering the version poll is a u-blox module,
+  // also when initialize() didn't wait for the answer
+  _initialized = true;
   _pending = pending::none;
   if (_verbose)
   {
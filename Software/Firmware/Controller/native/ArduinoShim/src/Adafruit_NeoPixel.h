@@ -0,0 +1,80 @@
+// Adafruit_NeoPixel.h
+
+// host shim for the native environment, the pixel colors are kept in memory
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+
+#define NEO_RGB 0x06
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel
+{
+public:
+  Adafruit_NeoPixel(uint16_t count, int16_t pin, uint16_t type = NEO_GRB + NEO_KHZ800)
+      : _pixels(count, 0), _shown(count, 0)
+  {
+  }
+
+  void begin()
+  {
+  }
+
+  void show()
+  {
+    _shown = _pixels;
+  }
+
+  void clear()
+  {
+    std::fill(_pixels.begin(), _pixels.end(), 0);
+  }
+
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+  {
+    setPixelColor(n, Color(r, g, b));
+  }
+
+  void setPixelColor(uint16_t n, uint32_t c)
+  {
+    if (n < _pixels.size())
+    {
+      _pixels[n] = c;
+    }
+  }
+
+  uint32_t getPixelColor(uint16_t n) const
+  {
+    return ((n < _pixels.size()) ? _pixels[n] : 0);
+  }
+
+  // color of the pixel after the last show()
+  uint32_t getShownColor(uint16_t n) const
+  {
+    return ((n < _shown.size()) ? _shown[n] : 0);
+  }
+
+  uint16_t numPixels() const
+  {
+    return (_pixels.size());
+  }
+
+  void setBrightness(uint8_t brightness)
+  {
+  }
+
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b)
+  {
+    return (((uint32_t)r << 16) | ((uint32_t)g << 8) | b);
+  }
+
+private:
+  std::vector<uint32_t> _pixels;
+  std::vector<uint32_t> _shown;
+};
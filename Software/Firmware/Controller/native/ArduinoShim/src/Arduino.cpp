@@ -0,0 +1,101 @@
+// Arduino.cpp
+
+// host shim of the Arduino/ESP32 core for the native environment
+// provides just enough of the API for the controller libraries
+// to compile and run on a PC
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <Arduino.h>
+#include <HostRuntime.h>
+#include <thread>
+
+HostSerial Serial;
+
+static uint8_t pinStates[SHIM_PIN_COUNT];
+static void (*pinInterrupts[SHIM_PIN_COUNT])();
+static int pinInterruptModes[SHIM_PIN_COUNT];
+
+unsigned long millis()
+{
+  return ((unsigned long)(HostRuntime::getTime() / 1000));
+}
+
+unsigned long micros()
+{
+  return ((unsigned long)HostRuntime::getTime());
+}
+
+void delay(unsigned long ms)
+{
+  HostRuntime::waitUntil(HostRuntime::getTime() + (uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+  HostRuntime::waitUntil(HostRuntime::getTime() + us);
+}
+
+void yield()
+{
+  std::this_thread::yield();
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if ((pin < SHIM_PIN_COUNT) && (mode == INPUT_PULLUP))
+  {
+    pinStates[pin] = HIGH;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (pin < SHIM_PIN_COUNT)
+  {
+    pinStates[pin] = value ? HIGH : LOW;
+  }
+  HostRuntime::writePin(pin, value ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin)
+{
+  return ((pin < SHIM_PIN_COUNT) ? pinStates[pin] : LOW);
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode)
+{
+  if (pin < SHIM_PIN_COUNT)
+  {
+    pinInterrupts[pin] = isr;
+    pinInterruptModes[pin] = mode;
+  }
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  if (pin < SHIM_PIN_COUNT)
+  {
+    pinInterrupts[pin] = nullptr;
+  }
+}
+
+void setPinLevel(uint8_t pin, uint8_t value)
+{
+  if (pin >= SHIM_PIN_COUNT)
+  {
+    return;
+  }
+  uint8_t previous = pinStates[pin];
+  pinStates[pin] = value ? HIGH : LOW;
+  if (pinInterrupts[pin] && (previous != pinStates[pin]))
+  {
+    int mode = pinInterruptModes[pin];
+    if ((mode == CHANGE) || ((mode == RISING) && (pinStates[pin] == HIGH)) ||
+        ((mode == FALLING) && (pinStates[pin] == LOW)))
+    {
+      pinInterrupts[pin]();
+    }
+  }
+}
@@ -0,0 +1,425 @@
+// Arduino.h
+
+// host shim of the Arduino/ESP32 core for the native environment
+// provides just enough of the API for the controller libraries
+// to compile and run on a PC
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <cstdarg>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <functional>
+
+using std::isfinite;
+using std::isinf;
+using std::isnan;
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PI 3.1415926535897932384626433832795
+#define EULER 2.718281828459045235360287471352
+
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+#define F(s) (s)
+#define digitalPinToInterrupt(p) (p)
+
+// number of simulated GPIOs, like the ESP32
+#define SHIM_PIN_COUNT 40
+
+// time since the start of the program
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// pins are kept in memory, writes also go to the HostRuntime pin handler
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+// host side, an input pin driven from outside, runs the interrupt
+// of the pin on a matching edge
+void setPinLevel(uint8_t pin, uint8_t value);
+
+// Arduino String on top of std::string
+class String : public std::string
+{
+public:
+  String() {}
+  String(const char *s) : std::string(s ? s : "") {}
+  String(const std::string &s) : std::string(s) {}
+  String(char c) : std::string(1, c) {}
+  String(int value, uint8_t base = DEC) : std::string(toText(value, base)) {}
+  String(unsigned int value, uint8_t base = DEC) : std::string(toText(value, base)) {}
+  String(long value, uint8_t base = DEC) : std::string(toText(value, base)) {}
+  String(unsigned long value, uint8_t base = DEC) : std::string(toText(value, base)) {}
+  String(double value, uint8_t decimals = 2) : std::string(toText(value, decimals)) {}
+
+  using std::string::operator+=;
+  String &operator+=(int value)
+  {
+    append(toText(value, DEC));
+    return (*this);
+  }
+  String &operator+=(unsigned int value)
+  {
+    append(toText(value, DEC));
+    return (*this);
+  }
+  String &operator+=(long value)
+  {
+    append(toText(value, DEC));
+    return (*this);
+  }
+  String &operator+=(unsigned long value)
+  {
+    append(toText(value, DEC));
+    return (*this);
+  }
+  String &operator+=(double value)
+  {
+    append(toText(value, 2));
+    return (*this);
+  }
+
+  template <typename T>
+  bool concat(T value)
+  {
+    *this += value;
+    return (true);
+  }
+
+  char charAt(unsigned int index) const
+  {
+    return ((index < length()) ? (*this)[index] : 0);
+  }
+
+  void setCharAt(unsigned int index, char c)
+  {
+    if (index < length())
+    {
+      (*this)[index] = c;
+    }
+  }
+
+  int indexOf(char c, unsigned int from = 0) const
+  {
+    size_t position = find(c, from);
+    return ((position == npos) ? -1 : (int)position);
+  }
+
+  int indexOf(const char *s, unsigned int from = 0) const
+  {
+    size_t position = find(s, from);
+    return ((position == npos) ? -1 : (int)position);
+  }
+
+  int lastIndexOf(char c) const
+  {
+    size_t position = rfind(c);
+    return ((position == npos) ? -1 : (int)position);
+  }
+
+  void remove(unsigned int index)
+  {
+    if (index < length())
+    {
+      erase(index);
+    }
+  }
+
+  void remove(unsigned int index, unsigned int count)
+  {
+    if (index < length())
+    {
+      erase(index, count);
+    }
+  }
+
+  String substring(unsigned int from) const
+  {
+    return ((from < length()) ? String(substr(from)) : String());
+  }
+
+  String substring(unsigned int from, unsigned int to) const
+  {
+    if (from > to)
+    {
+      std::swap(from, to);
+    }
+    return ((from < length()) ? String(substr(from, to - from)) : String());
+  }
+
+  bool equals(const char *s) const
+  {
+    return (compare(s) == 0);
+  }
+
+  bool equalsIgnoreCase(const char *s) const
+  {
+    return (strcasecmp(c_str(), s) == 0);
+  }
+
+  bool startsWith(const char *s) const
+  {
+    return (rfind(s, 0) == 0);
+  }
+
+  bool endsWith(const char *s) const
+  {
+    size_t n = strlen(s);
+    return ((n <= length()) && (compare(length() - n, n, s) == 0));
+  }
+
+  void trim()
+  {
+    size_t first = find_first_not_of(" \t\r\n");
+    size_t last = find_last_not_of(" \t\r\n");
+    *this = (first == npos) ? String() : String(substr(first, last - first + 1));
+  }
+
+  void toUpperCase()
+  {
+    std::transform(begin(), end(), begin(), ::toupper);
+  }
+
+  void toLowerCase()
+  {
+    std::transform(begin(), end(), begin(), ::tolower);
+  }
+
+  long toInt() const
+  {
+    return (atol(c_str()));
+  }
+
+  float toFloat() const
+  {
+    return ((float)atof(c_str()));
+  }
+
+  double toDouble() const
+  {
+    return (atof(c_str()));
+  }
+
+private:
+  static std::string toText(long long value, uint8_t base)
+  {
+    if ((value < 0) && (base == DEC))
+    {
+      return ("-" + toText((unsigned long long)(-value), base));
+    }
+    return (toText((unsigned long long)value, base));
+  }
+
+  static std::string toText(unsigned long long value, uint8_t base)
+  {
+    char buffer[72];
+    char *p = buffer + sizeof(buffer) - 1;
+    *p = 0;
+    do
+    {
+      uint8_t digit = value % base;
+      *--p = (digit < 10) ? ('0' + digit) : ('A' + digit - 10);
+      value /= base;
+    } while (value != 0);
+    return (std::string(p));
+  }
+
+  static std::string toText(int value, uint8_t base) { return (toText((long long)value, base)); }
+  static std::string toText(unsigned int value, uint8_t base) { return (toText((unsigned long long)value, base)); }
+  static std::string toText(long value, uint8_t base) { return (toText((long long)value, base)); }
+  static std::string toText(unsigned long value, uint8_t base) { return (toText((unsigned long long)value, base)); }
+
+  static std::string toText(double value, uint8_t decimals)
+  {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    return (std::string(buffer));
+  }
+};
+
+class Print
+{
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+
+  virtual size_t write(const uint8_t *buffer, size_t size)
+  {
+    size_t n = 0;
+    while (size--)
+    {
+      n += write(*buffer++);
+    }
+    return (n);
+  }
+
+  size_t write(const char *s)
+  {
+    return (write((const uint8_t *)s, strlen(s)));
+  }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+  {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return (write((const uint8_t *)buffer, std::min((size_t)std::max(n, 0), sizeof(buffer) - 1)));
+  }
+
+  size_t print(const char *s) { return (write(s)); }
+  size_t print(const String &s) { return (write(s.c_str())); }
+  size_t print(char c) { return (write((uint8_t)c)); }
+  size_t print(int value, int base = DEC) { return (print(String(value, base))); }
+  size_t print(unsigned int value, int base = DEC) { return (print(String(value, base))); }
+  size_t print(long value, int base = DEC) { return (print(String(value, base))); }
+  size_t print(unsigned long value, int base = DEC) { return (print(String(value, base))); }
+  size_t print(unsigned char value, int base = DEC) { return (print(String((unsigned int)value, base))); }
+  size_t print(double value, int decimals = 2) { return (print(String(value, decimals))); }
+
+  size_t println() { return (write("\r\n")); }
+
+  template <typename T>
+  size_t println(T value)
+  {
+    return (print(value) + println());
+  }
+
+  template <typename T>
+  size_t println(T value, int format)
+  {
+    return (print(value, format) + println());
+  }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout)
+  {
+    _timeout = timeout;
+  }
+
+  size_t readBytes(uint8_t *buffer, size_t length)
+  {
+    size_t n = 0;
+    while ((n < length) && (available() > 0))
+    {
+      buffer[n++] = read();
+    }
+    return (n);
+  }
+
+  size_t readBytes(char *buffer, size_t length)
+  {
+    return (readBytes((uint8_t *)buffer, length));
+  }
+
+protected:
+  unsigned long _timeout = 1000;
+};
+
+// the console, output goes to stdout,
+// input is whatever the host program feeds in
+class HostSerial : public Stream
+{
+public:
+  void begin(unsigned long baud)
+  {
+  }
+
+  size_t write(uint8_t c) override
+  {
+    return ((fputc(c, stdout) != EOF) ? 1 : 0);
+  }
+
+  using Print::write;
+
+  int available() override
+  {
+    return (_input.length() - _position);
+  }
+
+  int read() override
+  {
+    return ((_position < _input.length()) ? (uint8_t)_input[_position++] : -1);
+  }
+
+  int peek() override
+  {
+    return ((_position < _input.length()) ? (uint8_t)_input[_position] : -1);
+  }
+
+  void flush()
+  {
+    fflush(stdout);
+  }
+
+  void onReceive(std::function<void()> callback)
+  {
+    _onReceive = callback;
+  }
+
+  // host side
+  void feed(const char *s)
+  {
+    _input.erase(0, _position);
+    _position = 0;
+    _input += s;
+    if (_onReceive)
+    {
+      _onReceive();
+    }
+  }
+
+private:
+  std::string _input;
+  size_t _position = 0;
+  std::function<void()> _onReceive;
+};
+
+extern HostSerial Serial;
@@ -0,0 +1,194 @@
+// DS3232RTC.h
+
+// host shim for the native environment, the API of the DS3232RTC library,
+// https://github.com/JChristensen/DS3232RTC, the RTC runs on the
+// host clock with an optional drift, trimmed by the aging offset register,
+// the 1 Hz square wave drives a GPIO when the host connects one,
+// I2C transactions are counted
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <TimeLib.h>
+#include <HostRuntime.h>
+
+class DS3232RTC
+{
+public:
+  enum SQWAVE_FREQS_t
+  {
+    SQWAVE_1_HZ,
+    SQWAVE_1024_HZ,
+    SQWAVE_4096_HZ,
+    SQWAVE_8192_HZ,
+    SQWAVE_NONE
+  };
+
+  void begin()
+  {
+  }
+
+  static time_t get()
+  {
+    _transactions++;
+    return ((time_t)floor(getExactTime()));
+  }
+
+  // writing the seconds restarts the countdown chain, like the chip
+  static uint8_t set(time_t t)
+  {
+    _transactions++;
+    _setTime = t;
+    _setMicros = HostRuntime::getTime();
+    scheduleSquareWave();
+    return (0);
+  }
+
+  // only the aging offset register is simulated, it applies at once
+  static uint8_t readRTC(uint8_t addr)
+  {
+    _transactions++;
+    return ((addr == RTC_AGING) ? (uint8_t)_aging : 0);
+  }
+
+  static uint8_t writeRTC(uint8_t addr, uint8_t value)
+  {
+    _transactions++;
+    if (addr == RTC_AGING)
+    {
+      rebase();
+      _aging = (int8_t)value;
+      scheduleSquareWave();
+    }
+    return (0);
+  }
+
+  // in units of 0.25 degrees celsius
+  static int16_t temperature()
+  {
+    _transactions++;
+    return ((int16_t)(_temperature * 4));
+  }
+
+  // only 1 Hz is simulated, the falling edge starts the second
+  static void squareWave(SQWAVE_FREQS_t freq)
+  {
+    _transactions++;
+    _squareWave = (freq == SQWAVE_1_HZ);
+    scheduleSquareWave();
+  }
+
+  // host side, the GPIO the INT/SQW output is wired to
+  static void setSquareWavePin(uint8_t pin)
+  {
+    _squareWavePin = pin;
+    scheduleSquareWave();
+  }
+
+  static uint32_t getTransactions()
+  {
+    return (_transactions);
+  }
+
+  // host side, positive values make the RTC run fast
+  static void setDrift(double ppm)
+  {
+    rebase();
+    _drift = ppm;
+    scheduleSquareWave();
+  }
+
+  // host side, moves the RTC by us without restarting its second
+  static void shift(int64_t us)
+  {
+    _setTime += (double)us / 1e6;
+    scheduleSquareWave();
+  }
+
+  // host side, the time of the RTC with the fraction of the second
+  static double getExactTime()
+  {
+    return (_setTime + (double)(HostRuntime::getTime() - _setMicros) * getRate() / 1e6);
+  }
+
+  static double getDrift()
+  {
+    return (_drift);
+  }
+
+  static int8_t getAging()
+  {
+    return (_aging);
+  }
+
+  static void setTemperature(float temperature)
+  {
+    _temperature = temperature;
+  }
+
+private:
+  static const uint8_t RTC_AGING = 0x10;
+  // the time at _setMicros, fractional after a rate change
+  inline static double _setTime = 0;
+  inline static uint64_t _setMicros = 0;
+  inline static double _drift = 0;
+  // 0.1 ppm per LSB, positive values slow the oscillator down
+  inline static int8_t _aging = 0;
+  inline static float _temperature = 25.0f;
+  inline static bool _squareWave = false;
+  inline static int _squareWavePin = -1;
+  inline static uint64_t _squareWaveEvent = 0;
+  inline static uint64_t _squareWaveSeconds = 0;
+  inline static uint32_t _transactions = 0;
+
+  static double getRate()
+  {
+    return (1.0 + (_drift - _aging * 0.1) * 1e-6);
+  }
+
+  // a new rate applies from now on
+  static void rebase()
+  {
+    _setTime = getExactTime();
+    _setMicros = HostRuntime::getTime();
+  }
+
+  // host time of the start of an RTC second
+  static uint64_t getSecondStart(uint64_t second)
+  {
+    return (_setMicros + (int64_t)ceil(((double)second - _setTime) * 1e6 / getRate()));
+  }
+
+  static void scheduleSquareWave()
+  {
+    if (_squareWaveEvent)
+    {
+      HostRuntime::cancel(_squareWaveEvent);
+      _squareWaveEvent = 0;
+    }
+    if (_squareWave && (_squareWavePin >= 0))
+    {
+      setPinLevel(_squareWavePin, HIGH);
+      uint64_t now = HostRuntime::getTime();
+      _squareWaveSeconds = (uint64_t)floor(getExactTime()) + 1;
+      while (getSecondStart(_squareWaveSeconds) <= now)
+      {
+        _squareWaveSeconds++;
+      }
+      _squareWaveEvent = HostRuntime::schedule(getSecondStart(_squareWaveSeconds), onSecond);
+    }
+  }
+
+  // low for the first half of the second
+  static void onSecond()
+  {
+    setPinLevel(_squareWavePin, LOW);
+    HostRuntime::schedule((getSecondStart(_squareWaveSeconds) + getSecondStart(_squareWaveSeconds + 1)) / 2, []()
+                          { setPinLevel(_squareWavePin, HIGH); });
+    _squareWaveSeconds++;
+    _squareWaveEvent = HostRuntime::schedule(getSecondStart(_squareWaveSeconds), onSecond);
+  }
+};
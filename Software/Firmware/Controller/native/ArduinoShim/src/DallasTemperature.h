@@ -0,0 +1,56 @@
+// DallasTemperature.h
+
+// host shim for the native environment, a DS18B20 reading
+// whatever temperature the host program sets
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+class DallasTemperature
+{
+public:
+  DallasTemperature(OneWire *oneWire) : _oneWire(oneWire)
+  {
+  }
+
+  void begin()
+  {
+  }
+
+  void setResolution(uint8_t resolution)
+  {
+  }
+
+  void setWaitForConversion(bool wait)
+  {
+  }
+
+  void requestTemperatures()
+  {
+  }
+
+  float getTempCByIndex(uint8_t index)
+  {
+    return (_temperature);
+  }
+
+  float getTempFByIndex(uint8_t index)
+  {
+    return (_temperature * 1.8f + 32.0f);
+  }
+
+  // host side, in celsius
+  static void setTemperature(float temperature)
+  {
+    _temperature = temperature;
+  }
+
+private:
+  inline static float _temperature = 21.5f;
+  OneWire *_oneWire;
+};
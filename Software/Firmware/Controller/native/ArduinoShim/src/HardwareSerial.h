@@ -0,0 +1,129 @@
+// HardwareSerial.h
+
+// host shim for the native environment, the UARTs of the ESP32,
+// what the firmware writes goes to the attached device model,
+// what the device sends arrives through receive()
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+
+#define SERIAL_8N1 0x800001c
+#define HOST_UART_COUNT 3
+
+class HardwareSerial : public Stream
+{
+public:
+  using TransmitHandler = void (*)(void *obj, uint8_t c);
+
+  HardwareSerial(int uart) : _uart(uart)
+  {
+    if ((uart >= 0) && (uart < HOST_UART_COUNT))
+    {
+      _ports[uart] = this;
+    }
+  }
+
+  virtual ~HardwareSerial()
+  {
+    if ((_uart >= 0) && (_uart < HOST_UART_COUNT) && (_ports[_uart] == this))
+    {
+      _ports[_uart] = nullptr;
+    }
+  }
+
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1)
+  {
+    _baud = baud;
+    _started = true;
+  }
+
+  void end()
+  {
+    _started = false;
+    _input.clear();
+    _position = 0;
+  }
+
+  void onReceive(std::function<void()> callback)
+  {
+    _onReceive = callback;
+  }
+
+  size_t write(uint8_t c) override
+  {
+    if (_started && _transmit)
+    {
+      _transmit(_transmitObj, c);
+    }
+    return (1);
+  }
+
+  using Print::write;
+
+  int available() override
+  {
+    return (_input.length() - _position);
+  }
+
+  int read() override
+  {
+    return ((_position < _input.length()) ? (uint8_t)_input[_position++] : -1);
+  }
+
+  int peek() override
+  {
+    return ((_position < _input.length()) ? (uint8_t)_input[_position] : -1);
+  }
+
+  void flush()
+  {
+  }
+
+  // host side
+  static HardwareSerial *getPort(int uart)
+  {
+    return (((uart >= 0) && (uart < HOST_UART_COUNT)) ? _ports[uart] : nullptr);
+  }
+
+  unsigned long getBaudRate()
+  {
+    return (_baud);
+  }
+
+  // data sent by the device, lost when the port isn't open
+  void receive(const uint8_t *data, size_t length)
+  {
+    if (_started)
+    {
+      _input.erase(0, _position);
+      _position = 0;
+      _input.append((const char *)data, length);
+      if (_onReceive)
+      {
+        _onReceive();
+      }
+    }
+  }
+
+  // the device gets what the firmware writes
+  void attachTransmit(void *obj, TransmitHandler handler)
+  {
+    _transmitObj = obj;
+    _transmit = handler;
+  }
+
+private:
+  inline static HardwareSerial *_ports[HOST_UART_COUNT] = {};
+  int _uart;
+  unsigned long _baud = 0;
+  bool _started = false;
+  std::string _input;
+  size_t _position = 0;
+  std::function<void()> _onReceive;
+  void *_transmitObj = nullptr;
+  TransmitHandler _transmit = nullptr;
+};
@@ -0,0 +1,193 @@
+// HostRuntime.cpp
+
+// host shim for the native environment, the clock and the event queue
+// behind millis(), delay(), task notifications, esp_timer and the UARTs
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <HostRuntime.h>
+#include <chrono>
+#include <thread>
+#include <queue>
+#include <vector>
+#include <unordered_map>
+
+typedef struct
+{
+  uint64_t time;
+  uint64_t id;
+} SCHEDULED_EVENT;
+
+struct LaterEvent
+{
+  bool operator()(const SCHEDULED_EVENT &a, const SCHEDULED_EVENT &b) const
+  {
+    // same time, first come first served
+    return ((a.time > b.time) || ((a.time == b.time) && (a.id > b.id)));
+  }
+};
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static bool virtualTime = false;
+static uint64_t virtualNow = 0;
+static uint64_t nextId = 1;
+static bool runningEvent = false;
+static std::priority_queue<SCHEDULED_EVENT, std::vector<SCHEDULED_EVENT>, LaterEvent> timeline;
+// cancelled events are dropped when they come up
+static std::unordered_map<uint64_t, HostRuntime::Event> events;
+
+static uint32_t notificationValue = 0;
+static bool notificationPending = false;
+
+static void *pinObj = nullptr;
+static HostRuntime::PinHandler pinHandler = nullptr;
+
+void HostRuntime::setVirtualTime(bool enabled)
+{
+  virtualTime = enabled;
+}
+
+bool HostRuntime::isVirtualTime()
+{
+  return (virtualTime);
+}
+
+uint64_t HostRuntime::getTime()
+{
+  if (virtualTime)
+  {
+    virtualNow += HOST_CLOCK_READ_COST;
+    return (virtualNow);
+  }
+  return ((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count());
+}
+
+uint64_t HostRuntime::schedule(uint64_t time, Event event)
+{
+  uint64_t id = nextId++;
+  events.emplace(id, std::move(event));
+  timeline.push({time, id});
+  return (id);
+}
+
+void HostRuntime::cancel(uint64_t id)
+{
+  events.erase(id);
+}
+
+uint32_t HostRuntime::getPendingEvents()
+{
+  return ((uint32_t)events.size());
+}
+
+void HostRuntime::waitUntil(uint64_t time)
+{
+  while (runNext(time))
+  {
+  }
+  advanceTo(time);
+}
+
+void HostRuntime::notify(uint32_t value, bool overwrite)
+{
+  if (overwrite)
+  {
+    notificationValue = value;
+  }
+  else
+  {
+    notificationValue |= value;
+  }
+  notificationPending = true;
+}
+
+bool HostRuntime::waitForNotification(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *value, uint64_t timeout)
+{
+  bool notified = false;
+
+  if (!notificationPending)
+  {
+    notificationValue &= ~clearOnEntry;
+  }
+  uint64_t deadline = (timeout == HOST_WAIT_FOREVER) ? HOST_WAIT_FOREVER : getTime() + timeout;
+  while (!notificationPending)
+  {
+    if (!runNext(deadline))
+    {
+      // nothing can wake us up anymore
+      if (deadline != HOST_WAIT_FOREVER)
+      {
+        advanceTo(deadline);
+      }
+      break;
+    }
+  }
+  if (value)
+  {
+    *value = notificationValue;
+  }
+  if (notificationPending)
+  {
+    notificationValue &= ~clearOnExit;
+    notificationPending = false;
+    notified = true;
+  }
+  return (notified);
+}
+
+void HostRuntime::attachPins(void *obj, PinHandler handler)
+{
+  pinObj = obj;
+  pinHandler = handler;
+}
+
+void HostRuntime::writePin(uint8_t pin, uint8_t value)
+{
+  if (pinHandler)
+  {
+    pinHandler(pinObj, pin, value);
+  }
+}
+
+void HostRuntime::advanceTo(uint64_t time)
+{
+  if (virtualTime)
+  {
+    if (time > virtualNow)
+    {
+      virtualNow = time;
+    }
+  }
+  else
+  {
+    std::this_thread::sleep_until(startTime + std::chrono::microseconds(time));
+  }
+}
+
+// runs the next event due at the deadline,
+// events don't run from within events, an event waiting only moves the clock
+bool HostRuntime::runNext(uint64_t deadline)
+{
+  if (runningEvent)
+  {
+    return (false);
+  }
+  while (!timeline.empty() && (timeline.top().time <= deadline))
+  {
+    SCHEDULED_EVENT next = timeline.top();
+    timeline.pop();
+    auto it = events.find(next.id);
+    if (it != events.end())
+    {
+      Event event = std::move(it->second);
+      events.erase(it);
+      advanceTo(next.time);
+      runningEvent = true;
+      event();
+      runningEvent = false;
+      return (true);
+    }
+  }
+  return (false);
+}
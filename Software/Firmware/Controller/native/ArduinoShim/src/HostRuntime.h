@@ -0,0 +1,57 @@
+// HostRuntime.h
+
+// host shim for the native environment, the clock and the event queue
+// behind millis(), delay(), task notifications, esp_timer and the UARTs
+
+// in real time mode the clock follows the PC clock,
+// in virtual time mode it only moves when the program waits
+// (and a little on every clock read, busy loops make progress),
+// a day of firmware time replays in seconds
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// virtual time every clock read costs, in microseconds
+#define HOST_CLOCK_READ_COST 1
+#define HOST_WAIT_FOREVER UINT64_MAX
+
+class HostRuntime
+{
+public:
+  using Event = std::function<void()>;
+  using PinHandler = void (*)(void *obj, uint8_t pin, uint8_t value);
+
+  // before anything reads the clock
+  static void setVirtualTime(bool enabled);
+  static bool isVirtualTime();
+
+  // microseconds since the start of the program
+  static uint64_t getTime();
+
+  // events run while the program waits, in time order,
+  // returns an id for cancel()
+  static uint64_t schedule(uint64_t time, Event event);
+  static void cancel(uint64_t id);
+  static uint32_t getPendingEvents();
+
+  // runs the due events until the given time
+  static void waitUntil(uint64_t time);
+
+  // notification value of the (only) task
+  static void notify(uint32_t value, bool overwrite);
+  // waits at most timeout us, returns false on timeout
+  static bool waitForNotification(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *value, uint64_t timeout);
+
+  // gets every GPIO write
+  static void attachPins(void *obj, PinHandler handler);
+  static void writePin(uint8_t pin, uint8_t value);
+
+private:
+  static void advanceTo(uint64_t time);
+  static bool runNext(uint64_t deadline);
+};
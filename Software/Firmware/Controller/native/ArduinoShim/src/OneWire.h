@@ -0,0 +1,22 @@
+// OneWire.h
+
+// host shim for the native environment, the bus itself is not simulated,
+// DallasTemperature answers for the sensor
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+
+class OneWire
+{
+public:
+  OneWire(uint8_t pin) : _pin(pin)
+  {
+  }
+
+private:
+  uint8_t _pin;
+};
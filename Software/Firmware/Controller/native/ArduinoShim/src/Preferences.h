@@ -0,0 +1,168 @@
+// Preferences.h
+
+// host shim for the native environment, values are kept in memory
+// for the lifetime of the program, shared by all instances
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+class Preferences
+{
+public:
+  bool begin(const char *name, bool readOnly = false)
+  {
+    _namespace = name;
+    _readOnly = readOnly;
+    return (true);
+  }
+
+  void end()
+  {
+    _namespace.clear();
+  }
+
+  bool clear()
+  {
+    auto &values = getValues();
+    for (auto it = values.begin(); it != values.end();)
+    {
+      it = (it->first.compare(0, _namespace.length() + 1, _namespace + "/") == 0) ? values.erase(it) : std::next(it);
+    }
+    auto &blobs = getBlobs();
+    for (auto it = blobs.begin(); it != blobs.end();)
+    {
+      it = (it->first.compare(0, _namespace.length() + 1, _namespace + "/") == 0) ? blobs.erase(it) : std::next(it);
+    }
+    return (!_readOnly);
+  }
+
+  bool remove(const char *key)
+  {
+    return ((getValues().erase(getKey(key)) + getBlobs().erase(getKey(key))) > 0);
+  }
+
+  bool isKey(const char *key)
+  {
+    return ((getValues().count(getKey(key)) + getBlobs().count(getKey(key))) > 0);
+  }
+
+  size_t putInt(const char *key, int32_t value)
+  {
+    return (put(key, value, sizeof(value)));
+  }
+
+  size_t putUInt(const char *key, uint32_t value)
+  {
+    return (put(key, value, sizeof(value)));
+  }
+
+  size_t putUChar(const char *key, uint8_t value)
+  {
+    return (put(key, value, sizeof(value)));
+  }
+
+  size_t putBool(const char *key, bool value)
+  {
+    return (put(key, value, sizeof(value)));
+  }
+
+  int32_t getInt(const char *key, int32_t defaultValue = 0)
+  {
+    return ((int32_t)get(key, defaultValue));
+  }
+
+  uint32_t getUInt(const char *key, uint32_t defaultValue = 0)
+  {
+    return ((uint32_t)get(key, defaultValue));
+  }
+
+  uint8_t getUChar(const char *key, uint8_t defaultValue = 0)
+  {
+    return ((uint8_t)get(key, defaultValue));
+  }
+
+  bool getBool(const char *key, bool defaultValue = false)
+  {
+    return (get(key, defaultValue) != 0);
+  }
+
+  size_t putBytes(const char *key, const void *value, size_t length)
+  {
+    if (_readOnly || _namespace.empty())
+    {
+      return (0);
+    }
+    getBlobs()[getKey(key)].assign((const char *)value, length);
+    _blobWrites++;
+    return (length);
+  }
+
+  size_t getBytesLength(const char *key)
+  {
+    auto it = getBlobs().find(getKey(key));
+    return ((it != getBlobs().end()) ? it->second.length() : 0);
+  }
+
+  // 0 if the blob doesn't fit into the buffer, like on the ESP32
+  size_t getBytes(const char *key, void *buffer, size_t length)
+  {
+    auto it = getBlobs().find(getKey(key));
+    if ((it == getBlobs().end()) || (it->second.length() > length))
+    {
+      return (0);
+    }
+    memcpy(buffer, it->second.data(), it->second.length());
+    return (it->second.length());
+  }
+
+  // host side, blob writes of all instances, stands for flash wear
+  static uint32_t getBlobWrites()
+  {
+    return (_blobWrites);
+  }
+
+private:
+  std::string _namespace;
+  bool _readOnly = false;
+
+  inline static uint32_t _blobWrites = 0;
+
+  static std::map<std::string, int64_t> &getValues()
+  {
+    static std::map<std::string, int64_t> values;
+    return (values);
+  }
+
+  static std::map<std::string, std::string> &getBlobs()
+  {
+    static std::map<std::string, std::string> blobs;
+    return (blobs);
+  }
+
+  std::string getKey(const char *key)
+  {
+    return (_namespace + "/" + key);
+  }
+
+  size_t put(const char *key, int64_t value, size_t size)
+  {
+    if (_readOnly || _namespace.empty())
+    {
+      return (0);
+    }
+    getValues()[getKey(key)] = value;
+    return (size);
+  }
+
+  int64_t get(const char *key, int64_t defaultValue)
+  {
+    auto it = getValues().find(getKey(key));
+    return ((it != getValues().end()) ? it->second : defaultValue);
+  }
+};
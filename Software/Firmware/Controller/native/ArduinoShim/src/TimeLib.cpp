@@ -0,0 +1,183 @@
+// TimeLib.cpp
+
+// host shim for the native environment, the API of the Time library,
+// https://github.com/PaulStoffregen/Time, the system time
+// counts seconds on top of millis() and syncs with a provider
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <TimeLib.h>
+
+static time_t sysTime = 0;
+static unsigned long prevMillis = 0;
+static time_t nextSyncTime = 0;
+static time_t syncInterval = 300;
+static timeStatus_t status = timeNotSet;
+static getExternalTime getTimePtr = nullptr;
+
+// days since 1970-01-01 of a date
+static int64_t daysFromCivil(int64_t y, unsigned m, unsigned d)
+{
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  unsigned yoe = (unsigned)(y - era * 400);
+  unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return (era * 146097 + (int64_t)doe - 719468);
+}
+
+static void civilFromDays(int64_t z, int *y, unsigned *m, unsigned *d)
+{
+  z += 719468;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  unsigned doe = (unsigned)(z - era * 146097);
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp + (mp < 10 ? 3 : -9);
+  *y = (int)(yoe + era * 400 + (*m <= 2));
+}
+
+void breakTime(time_t time, tmElements_t &tm)
+{
+  int64_t days = (int64_t)time / SECS_PER_DAY;
+  int64_t seconds = (int64_t)time % SECS_PER_DAY;
+  if (seconds < 0)
+  {
+    seconds += SECS_PER_DAY;
+    days--;
+  }
+  int y;
+  unsigned m, d;
+  civilFromDays(days, &y, &m, &d);
+  tm.Second = seconds % 60;
+  tm.Minute = (seconds / 60) % 60;
+  tm.Hour = seconds / 3600;
+  // 1970-01-01 was a thursday
+  tm.Wday = ((days % 7 + 7 + 4) % 7) + 1;
+  tm.Day = d;
+  tm.Month = m;
+  tm.Year = y - 1970;
+}
+
+time_t makeTime(const tmElements_t &tm)
+{
+  int64_t days = daysFromCivil(tm.Year + 1970, tm.Month, tm.Day);
+  return ((time_t)(days * SECS_PER_DAY + tm.Hour * SECS_PER_HOUR + tm.Minute * SECS_PER_MIN + tm.Second));
+}
+
+time_t now()
+{
+  unsigned long elapsed = (millis() - prevMillis) / 1000;
+  sysTime += elapsed;
+  prevMillis += elapsed * 1000;
+  if ((nextSyncTime <= sysTime) && getTimePtr)
+  {
+    time_t t = getTimePtr();
+    if (t != 0)
+    {
+      setTime(t);
+    }
+    else
+    {
+      nextSyncTime = sysTime + syncInterval;
+      status = (status == timeNotSet) ? timeNotSet : timeNeedsSync;
+    }
+  }
+  return (sysTime);
+}
+
+void setTime(time_t t)
+{
+  sysTime = t;
+  nextSyncTime = t + syncInterval;
+  status = timeSet;
+  prevMillis = millis();
+}
+
+void setTime(int hr, int min, int sec, int day, int month, int yr)
+{
+  tmElements_t tm;
+  tm.Year = (yr > 99) ? yr - 1970 : yr + 30;
+  tm.Month = month;
+  tm.Day = day;
+  tm.Hour = hr;
+  tm.Minute = min;
+  tm.Second = sec;
+  setTime(makeTime(tm));
+}
+
+void adjustTime(long adjustment)
+{
+  sysTime += adjustment;
+}
+
+int hour(time_t t)
+{
+  tmElements_t tm;
+  breakTime(t, tm);
+  return (tm.Hour);
+}
+
+int minute(time_t t)
+{
+  tmElements_t tm;
+  breakTime(t, tm);
+  return (tm.Minute);
+}
+
+int second(time_t t)
+{
+  tmElements_t tm;
+  breakTime(t, tm);
+  return (tm.Second);
+}
+
+int day(time_t t)
+{
+  tmElements_t tm;
+  breakTime(t, tm);
+  return (tm.Day);
+}
+
+int weekday(time_t t)
+{
+  tmElements_t tm;
+  breakTime(t, tm);
+  return (tm.Wday);
+}
+
+int month(time_t t)
+{
+  tmElements_t tm;
+  breakTime(t, tm);
+  return (tm.Month);
+}
+
+int year(time_t t)
+{
+  tmElements_t tm;
+  breakTime(t, tm);
+  return (tmYearToCalendar(tm.Year));
+}
+
+timeStatus_t timeStatus()
+{
+  now();
+  return (status);
+}
+
+void setSyncProvider(getExternalTime getTimeFunction)
+{
+  getTimePtr = getTimeFunction;
+  nextSyncTime = sysTime;
+  now();
+}
+
+void setSyncInterval(time_t interval)
+{
+  syncInterval = interval;
+  nextSyncTime = sysTime + syncInterval;
+}
@@ -0,0 +1,63 @@
+// TimeLib.h
+
+// host shim for the native environment, the API of the Time library,
+// https://github.com/PaulStoffregen/Time, the system time
+// counts seconds on top of millis() and syncs with a provider
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+
+#define SECS_PER_MIN ((time_t)60)
+#define SECS_PER_HOUR ((time_t)3600)
+#define SECS_PER_DAY ((time_t)86400)
+#define DAYS_PER_WEEK ((time_t)7)
+#define SECS_PER_WEEK ((time_t)(SECS_PER_DAY * DAYS_PER_WEEK))
+
+#define tmYearToCalendar(Y) ((Y) + 1970)
+#define CalendarYrToTm(Y) ((Y)-1970)
+
+typedef enum
+{
+  timeNotSet,
+  timeNeedsSync,
+  timeSet
+} timeStatus_t;
+
+// Year is offset from 1970, Wday 1 is Sunday
+typedef struct
+{
+  uint8_t Second;
+  uint8_t Minute;
+  uint8_t Hour;
+  uint8_t Wday;
+  uint8_t Day;
+  uint8_t Month;
+  uint8_t Year;
+} tmElements_t, TimeElements, *tmElementsPtr_t;
+
+typedef time_t (*getExternalTime)();
+
+time_t now();
+void setTime(time_t t);
+void setTime(int hr, int min, int sec, int day, int month, int yr);
+void adjustTime(long adjustment);
+
+int hour(time_t t);
+int minute(time_t t);
+int second(time_t t);
+int day(time_t t);
+int weekday(time_t t);
+int month(time_t t);
+int year(time_t t);
+
+timeStatus_t timeStatus();
+void setSyncProvider(getExternalTime getTimeFunction);
+void setSyncInterval(time_t interval);
+
+void breakTime(time_t time, tmElements_t &tm);
+time_t makeTime(const tmElements_t &tm);
@@ -0,0 +1,126 @@
+// Timezone.cpp
+
+// host shim for the native environment, the API of the Timezone library,
+// https://github.com/JChristensen/Timezone, rules are given in local time
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <Timezone.h>
+
+Timezone::Timezone(TimeChangeRule dstStart, TimeChangeRule stdStart)
+{
+  setRules(dstStart, stdStart);
+}
+
+Timezone::Timezone(TimeChangeRule stdTime)
+{
+  setRules(stdTime, stdTime);
+}
+
+void Timezone::setRules(TimeChangeRule dstStart, TimeChangeRule stdStart)
+{
+  _dst = dstStart;
+  _std = stdStart;
+  // force calcTimeChanges() on the next conversion
+  _dstUTC = 0;
+  _stdUTC = 0;
+  _dstLoc = 0;
+  _stdLoc = 0;
+}
+
+time_t Timezone::toLocal(time_t utc)
+{
+  return (utc + (utcIsDST(utc) ? _dst.offset : _std.offset) * SECS_PER_MIN);
+}
+
+time_t Timezone::toLocal(time_t utc, TimeChangeRule **tcr)
+{
+  bool dst = utcIsDST(utc);
+  if (tcr)
+  {
+    *tcr = dst ? &_dst : &_std;
+  }
+  return (utc + (dst ? _dst.offset : _std.offset) * SECS_PER_MIN);
+}
+
+// local times in the hour repeated at the end of DST are taken as standard time
+time_t Timezone::toUTC(time_t local)
+{
+  return (local - (locIsDST(local) ? _dst.offset : _std.offset) * SECS_PER_MIN);
+}
+
+bool Timezone::utcIsDST(time_t utc)
+{
+  if (_dst.offset == _std.offset)
+  {
+    return (false);
+  }
+  if (year(utc) != year(_dstUTC))
+  {
+    calcTimeChanges(year(utc));
+  }
+  if (_stdUTC > _dstUTC)
+  {
+    // northern hemisphere
+    return ((utc >= _dstUTC) && (utc < _stdUTC));
+  }
+  // southern hemisphere
+  return (!((utc >= _stdUTC) && (utc < _dstUTC)));
+}
+
+bool Timezone::locIsDST(time_t local)
+{
+  if (_dst.offset == _std.offset)
+  {
+    return (false);
+  }
+  if (year(local) != year(_dstLoc))
+  {
+    calcTimeChanges(year(local));
+  }
+  if (_stdUTC > _dstUTC)
+  {
+    return ((local >= _dstLoc) && (local < _stdLoc));
+  }
+  return (!((local >= _stdLoc) && (local < _dstLoc)));
+}
+
+void Timezone::calcTimeChanges(int yr)
+{
+  _dstLoc = toTime_t(_dst, yr);
+  _stdLoc = toTime_t(_std, yr);
+  _dstUTC = _dstLoc - _std.offset * SECS_PER_MIN;
+  _stdUTC = _stdLoc - _dst.offset * SECS_PER_MIN;
+}
+
+// local time of a change in the given year
+time_t Timezone::toTime_t(TimeChangeRule r, int yr)
+{
+  uint8_t m = r.month;
+  uint8_t w = r.week;
+  // the last week is one week before the first one of the next month
+  if (w == Last)
+  {
+    if (++m > 12)
+    {
+      m = 1;
+      yr++;
+    }
+    w = First;
+  }
+  tmElements_t tm;
+  tm.Hour = r.hour;
+  tm.Minute = 0;
+  tm.Second = 0;
+  tm.Day = 1;
+  tm.Month = m;
+  tm.Year = yr - 1970;
+  time_t t = makeTime(tm);
+  t += ((r.dow - weekday(t) + 7) % 7 + (w - 1) * 7) * SECS_PER_DAY;
+  if (r.week == Last)
+  {
+    t -= 7 * SECS_PER_DAY;
+  }
+  return (t);
+}
@@ -0,0 +1,84 @@
+// Timezone.h
+
+// host shim for the native environment, the API of the Timezone library,
+// https://github.com/JChristensen/Timezone, rules are given in local time
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <TimeLib.h>
+
+enum week_t
+{
+  Last,
+  First,
+  Second,
+  Third,
+  Fourth
+};
+
+enum dow_t
+{
+  Sun = 1,
+  Mon,
+  Tue,
+  Wed,
+  Thu,
+  Fri,
+  Sat
+};
+
+enum month_t
+{
+  Jan = 1,
+  Feb,
+  Mar,
+  Apr,
+  May,
+  Jun,
+  Jul,
+  Aug,
+  Sep,
+  Oct,
+  Nov,
+  Dec
+};
+
+struct TimeChangeRule
+{
+  char abbrev[6];
+  uint8_t week;
+  uint8_t dow;
+  uint8_t month;
+  uint8_t hour;
+  int offset;
+};
+
+class Timezone
+{
+public:
+  Timezone(TimeChangeRule dstStart, TimeChangeRule stdStart);
+  Timezone(TimeChangeRule stdTime);
+
+  time_t toLocal(time_t utc);
+  time_t toLocal(time_t utc, TimeChangeRule **tcr);
+  time_t toUTC(time_t local);
+  bool utcIsDST(time_t utc);
+  bool locIsDST(time_t local);
+  void setRules(TimeChangeRule dstStart, TimeChangeRule stdStart);
+
+private:
+  TimeChangeRule _dst;
+  TimeChangeRule _std;
+  // the changes of the last year asked for
+  time_t _dstUTC;
+  time_t _stdUTC;
+  time_t _dstLoc;
+  time_t _stdLoc;
+
+  void calcTimeChanges(int yr);
+  time_t toTime_t(TimeChangeRule r, int yr);
+};
@@ -0,0 +1,59 @@
+// Wire.h
+
+// host shim for the native environment, there is no I2C device on the bus,
+// every transmission fails with a NACK
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+
+class TwoWire : public Stream
+{
+public:
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0)
+  {
+    return (true);
+  }
+
+  void beginTransmission(uint8_t address)
+  {
+  }
+
+  // 2: address not acknowledged
+  uint8_t endTransmission(bool sendStop = true)
+  {
+    return (2);
+  }
+
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true)
+  {
+    return (0);
+  }
+
+  size_t write(uint8_t c) override
+  {
+    return (1);
+  }
+
+  using Print::write;
+
+  int available() override
+  {
+    return (0);
+  }
+
+  int read() override
+  {
+    return (-1);
+  }
+
+  int peek() override
+  {
+    return (-1);
+  }
+};
+
+inline TwoWire Wire;
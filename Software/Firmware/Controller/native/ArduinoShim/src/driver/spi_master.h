@@ -0,0 +1,90 @@
+// driver/spi_master.h
+
+// host shim for the native environment, there is no SPI bus,
+// the display driver falls back to shifting out with digitalWrite
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+
+#define SPI2_HOST 1
+#define SPI3_HOST 2
+#define SPI_DMA_CH_AUTO 3
+
+typedef int spi_host_device_t;
+typedef int gpio_num_t;
+
+typedef struct spi_transaction_t
+{
+  uint32_t flags;
+  size_t length;
+  size_t rxlength;
+  void *user;
+  const void *tx_buffer;
+  void *rx_buffer;
+} spi_transaction_t;
+
+typedef struct
+{
+  int mosi_io_num;
+  int miso_io_num;
+  int sclk_io_num;
+  int quadwp_io_num;
+  int quadhd_io_num;
+  int max_transfer_sz;
+} spi_bus_config_t;
+
+typedef void (*transaction_cb_t)(spi_transaction_t *transaction);
+
+typedef struct
+{
+  uint8_t mode;
+  int clock_speed_hz;
+  int spics_io_num;
+  int queue_size;
+  transaction_cb_t pre_cb;
+  transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+typedef struct spi_device_t *spi_device_handle_t;
+
+inline esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, int dmaChannel)
+{
+  return (ESP_FAIL);
+}
+
+inline esp_err_t spi_bus_free(spi_host_device_t host)
+{
+  return (ESP_OK);
+}
+
+inline esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config, spi_device_handle_t *handle)
+{
+  return (ESP_FAIL);
+}
+
+inline esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+  return (ESP_OK);
+}
+
+inline esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *transaction, TickType_t wait)
+{
+  return (ESP_FAIL);
+}
+
+inline esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **transaction, TickType_t wait)
+{
+  return (ESP_FAIL);
+}
+
+inline esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+  digitalWrite(pin, level);
+  return (ESP_OK);
+}
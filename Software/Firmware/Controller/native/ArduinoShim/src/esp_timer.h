@@ -0,0 +1,123 @@
+// esp_timer.h
+
+// host shim for the native environment, the microsecond clock
+// and the high resolution timers of the ESP-IDF,
+// the callbacks run from the HostRuntime event queue
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_err.h>
+#include <HostRuntime.h>
+
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef enum
+{
+  ESP_TIMER_TASK
+} esp_timer_dispatch_t;
+
+typedef struct
+{
+  esp_timer_cb_t callback;
+  void *arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char *name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+struct esp_timer
+{
+  esp_timer_cb_t callback;
+  void *arg;
+  uint64_t period;
+  uint64_t due;
+  uint64_t event;
+};
+
+typedef struct esp_timer *esp_timer_handle_t;
+
+inline int64_t esp_timer_get_time()
+{
+  return ((int64_t)HostRuntime::getTime());
+}
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+  if (!args || !args->callback || !handle)
+  {
+    return (ESP_ERR_INVALID_ARG);
+  }
+  *handle = new esp_timer{args->callback, args->arg, 0, 0, 0};
+  return (ESP_OK);
+}
+
+// periodic timers don't drift, the next period starts when the last one was due
+inline void hostArmTimer(esp_timer_handle_t timer, uint64_t due)
+{
+  timer->due = due;
+  timer->event = HostRuntime::schedule(due, [timer]()
+                                       {
+                                         timer->event = 0;
+                                         if (timer->period)
+                                         {
+                                           hostArmTimer(timer, timer->due + timer->period);
+                                         }
+                                         timer->callback(timer->arg); });
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout)
+{
+  if (!timer || timer->event)
+  {
+    return (ESP_ERR_INVALID_STATE);
+  }
+  timer->period = 0;
+  hostArmTimer(timer, HostRuntime::getTime() + timeout);
+  return (ESP_OK);
+}
+
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+  if (!timer || timer->event)
+  {
+    return (ESP_ERR_INVALID_STATE);
+  }
+  timer->period = period;
+  hostArmTimer(timer, HostRuntime::getTime() + period);
+  return (ESP_OK);
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+  if (!timer || !timer->event)
+  {
+    return (ESP_ERR_INVALID_STATE);
+  }
+  HostRuntime::cancel(timer->event);
+  timer->event = 0;
+  timer->period = 0;
+  return (ESP_OK);
+}
+
+inline bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+  return (timer && timer->event);
+}
+
+inline esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+  if (!timer)
+  {
+    return (ESP_ERR_INVALID_ARG);
+  }
+  if (timer->event)
+  {
+    return (ESP_ERR_INVALID_STATE);
+  }
+  delete timer;
+  return (ESP_OK);
+}
@@ -0,0 +1,97 @@
+// freertos/task.h
+
+// host shim for the native environment, tasks can't be created,
+// the libraries fall back to doing the work in the caller,
+// notifications go to the one and only task
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <HostRuntime.h>
+
+typedef void (*TaskFunction_t)(void *parameters);
+
+typedef enum
+{
+  eNoAction,
+  eSetBits,
+  eIncrement,
+  eSetValueWithOverwrite,
+  eSetValueWithoutOverwrite
+} eNotifyAction;
+
+#define portYIELD_FROM_ISR()
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackSize,
+                                          void *parameters, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+  return (pdFAIL);
+}
+
+inline void vTaskDelete(TaskHandle_t task)
+{
+}
+
+inline TickType_t xTaskGetTickCount()
+{
+  return ((TickType_t)millis());
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+  delay(ticks);
+}
+
+inline void vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment)
+{
+  *previousWakeTime += increment;
+  long remaining = (long)(*previousWakeTime - xTaskGetTickCount());
+  if (remaining > 0)
+  {
+    delay(remaining);
+  }
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+  static uint8_t loopTask;
+  return ((TaskHandle_t)&loopTask);
+}
+
+inline BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+  switch (action)
+  {
+  case eSetBits:
+    HostRuntime::notify(value, false);
+    break;
+
+  case eSetValueWithOverwrite:
+  case eSetValueWithoutOverwrite:
+    HostRuntime::notify(value, true);
+    break;
+
+  default:
+    HostRuntime::notify(0, false);
+    break;
+  }
+  return (pdPASS);
+}
+
+inline BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *higherPriorityTaskWoken)
+{
+  if (higherPriorityTaskWoken)
+  {
+    *higherPriorityTaskWoken = pdFALSE;
+  }
+  return (xTaskNotify(task, value, action));
+}
+
+inline BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *value, TickType_t ticks)
+{
+  uint64_t timeout = (ticks == portMAX_DELAY) ? HOST_WAIT_FOREVER : (uint64_t)ticks * portTICK_PERIOD_MS * 1000;
+  return (HostRuntime::waitForNotification(clearOnEntry, clearOnExit, value, timeout) ? pdTRUE : pdFALSE);
+}
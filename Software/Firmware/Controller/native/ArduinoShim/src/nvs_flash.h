@@ -0,0 +1,20 @@
+// nvs_flash.h
+
+// host shim for the native environment, the flash is always ready
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <esp_err.h>
+
+inline esp_err_t nvs_flash_init()
+{
+  return (ESP_OK);
+}
+
+inline esp_err_t nvs_flash_erase()
+{
+  return (ESP_OK);
+}
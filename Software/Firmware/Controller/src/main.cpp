@@ -31,6 +31,6 @@ void loop()
 {
   controller.process();
 
-  // relax
-  delay(10);
+  // sleep until something happens
+  controller.waitForEvents();
 }
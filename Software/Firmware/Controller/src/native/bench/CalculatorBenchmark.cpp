@@ -0,0 +1,122 @@
+// CalculatorBenchmark.cpp
+
+// host benchmark of the calculator, feeds a fixed pseudo random
+// key sequence through Calculator::onKeyboardEvent and reports
+// keystrokes per second, with and without the display encoding,
+// and the same amount of tape entries through NixieCalc::runTape
+// run with: pio run -e native -t exec
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <Arduino.h>
+#include <Settings.h>
+#include <Calculator.h>
+#include <CalcTape.h>
+#include <DisplayHandler.h>
+#include <vector>
+
+#define BENCHMARK_KEYS 1000000
+#define BENCHMARK_SEED 0x4E495849
+
+// the keys of the calculator, more digits than operations like a real user
+static const uint8_t benchmarkKeys[] = {
+    KEY_0, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9,
+    KEY_0, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9,
+    KEY_DOT, KEY_00, KEY_PLUS, KEY_MINUS, KEY_MUL, KEY_DIV, KEY_EQUALS, KEY_EQUALS,
+    KEY_PERCENT, KEY_SQUAREROOT, KEY_PLUSMINUS, KEY_C, KEY_AC,
+    KEY_MC, KEY_MR, KEY_MS, KEY_MPLUS, KEY_MMINUS,
+    KEY_SIN, KEY_COS, KEY_TAN, KEY_LOG, KEY_LN, KEY_INV, KEY_POW};
+
+// numbers for the tape, as typed
+static const char *benchmarkNumbers[] = {
+    "0", "1", "7", "42", "2.5", "-3", "0.001", "3.14159", "123456789.123", "99999999999999"};
+
+typedef struct
+{
+  uint8_t keyCode;
+  bool functionKeyPressed;
+} BENCHMARK_KEY;
+
+// xorshift, the same sequence on every host
+static uint32_t nextRandom(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return (*state);
+}
+
+static void report(const char *name, unsigned long elapsed, uint32_t keys)
+{
+  double seconds = elapsed / 1000000.0;
+  Serial.printf("%-22s %10.0f keys/s %8.1f ns/key\r\n", name, keys / seconds, elapsed * 1000.0 / keys);
+}
+
+int main()
+{
+  std::vector<BENCHMARK_KEY> keys(BENCHMARK_KEYS);
+  uint32_t state = BENCHMARK_SEED;
+  unsigned long start;
+
+  for (auto &key : keys)
+  {
+    key.keyCode = benchmarkKeys[nextRandom(&state) % sizeof(benchmarkKeys)];
+    key.functionKeyPressed = (nextRandom(&state) % 8) == 0;
+  }
+
+  Settings settings;
+  settings.begin();
+  settings.readSettings();
+
+  DisplayHandler displayHandler(0, 0, 0, 0, 0);
+  displayHandler.begin();
+
+  // the tape is written like on the device
+  static CALC_HISTORY_DATA historyData;
+  Calculator calculator(&settings, &historyData);
+  calculator.begin(displayHandler.getDigitCount(), displayHandler.getDecimalPointCount(), displayHandler.hasPlusSign());
+
+  Serial.printf("engine: %s, display: %u digits, %u keys\r\n",
+                (CALC_ENGINE == calc_engine::decimal) ? "decimal" : "binary",
+                displayHandler.getDigitCount(), BENCHMARK_KEYS);
+
+  start = micros();
+  for (const auto &key : keys)
+  {
+    calculator.onKeyboardEvent(key.keyCode, key_state::pressed, key.functionKeyPressed);
+  }
+  report("calculator", micros() - start, BENCHMARK_KEYS);
+
+  start = micros();
+  for (const auto &key : keys)
+  {
+    calculator.onKeyboardEvent(key.keyCode, key_state::pressed, key.functionKeyPressed);
+    displayHandler.show(calculator.getDisplay(), calculator.getDisplayLength());
+  }
+  report("calculator + display", micros() - start, BENCHMARK_KEYS);
+
+  Serial.printf("display: %lu frames shifted out, %lu skipped\r\n",
+                (unsigned long)displayHandler.getFramesCommitted(), (unsigned long)displayHandler.getFramesSkipped());
+
+  // one third numbers, the rest operations, allclear is part of them
+  std::vector<uint8_t> buffer(BENCHMARK_KEYS * (2 + CALC_TAPE_MAX_NUMBER));
+  CalcTape tape(buffer.data(), buffer.size());
+  for (uint32_t i = 0; i < BENCHMARK_KEYS; i++)
+  {
+    if (nextRandom(&state) % 3 == 0)
+    {
+      tape.addNumber(benchmarkNumbers[nextRandom(&state) % (sizeof(benchmarkNumbers) / sizeof(benchmarkNumbers[0]))]);
+    }
+    else
+    {
+      tape.addOperation((operation)(1 + nextRandom(&state) % (uint8_t)operation::pi));
+    }
+  }
+  NixieCalc engine;
+  start = micros();
+  engine.runTape(tape.getData(), tape.getLength());
+  report("engine tape", micros() - start, BENCHMARK_KEYS);
+  Serial.printf("tape: %lu bytes\r\n", (unsigned long)tape.getLength());
+  return (0);
+}
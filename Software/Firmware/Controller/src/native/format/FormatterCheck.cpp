@@ -0,0 +1,314 @@
+// FormatterCheck.cpp
+
+// NumberFormatter against the previous Calculator::doubleToString(),
+// which is kept here unchanged as the reference, and the speed of both,
+// the double overload must give the same text wherever the old routine
+// could show the number, the DecimalNumber overload the same text as the
+// old routine on the nearest double, except where that double is so
+// close to a rounding tie of the display that its last bit decides,
+// numbers shown in scientific notation must be the ones the old routine
+// showed too wide or with significant digits lost
+// run with: pio run -e native_format -t exec, exits with 1 on any mismatch
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <Arduino.h>
+#include <NumberFormatter.h>
+#include <vector>
+#include <string>
+
+#define FORMAT_DIGITS 14
+#define FORMAT_RANDOM_VALUES 500000
+#define FORMAT_BENCHMARK_ROUNDS 3
+#define FORMAT_SEED 0x464D5421
+// the old routine printed all integer digits into 100 characters
+#define FORMAT_MAX_VALUE 1e80
+
+typedef struct
+{
+  const char *name;
+  uint32_t values;
+  uint32_t fixed;
+  uint32_t scientific;
+  uint32_t ties;
+  uint32_t mismatches;
+} FORMAT_REPORT;
+
+// xorshift, the same sequence on every host
+static uint32_t nextRandom(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return (*state);
+}
+
+static uint64_t nextRandom64(uint32_t *state)
+{
+  uint64_t hi = nextRandom(state);
+  return ((hi << 32) | nextRandom(state));
+}
+
+// the previous formatter of Calculator.h, only _digitCount is a parameter
+static String doubleToString(double number, uint8_t _digitCount)
+{
+  String s;
+  char buffer[100];
+
+  // stupid thing, but avoids displaying negative zero
+  if (number == 0)
+  {
+    number = 0;
+  }
+  // format with maximum number of decimals
+  sprintf(buffer, "%-.*f", _digitCount, number);
+  s = buffer;
+  // get number of digits before the decimal point
+  int index = s.indexOf('.');
+  if (number < 0)
+  {
+    index--;
+  }
+  // get number of decimals to display
+  int decimals = _digitCount - index;
+  // format again with the correct mumber of decimals
+  sprintf(buffer, "%-.*f", decimals, number);
+  s = buffer;
+  index = s.indexOf('.');
+
+  if (index != -1)
+  {
+    // remove trailing zeroes after decimal point
+    while (s[s.length() - 1] == '0')
+    {
+      s.remove(s.length() - 1);
+    }
+    // remove decimal point if no decimals left
+    if (s[s.length() - 1] == '.')
+    {
+      s.remove(s.length() - 1);
+    }
+  }
+  return (s);
+}
+
+// coefficient * 10^exponent without an exponent, as typed on the keys
+static std::string toText(bool negative, uint64_t coefficient, int exponent)
+{
+  std::string digits = std::to_string(coefficient);
+  if (exponent >= 0)
+  {
+    digits.append(exponent, '0');
+  }
+  else
+  {
+    if ((int)digits.size() <= -exponent)
+    {
+      digits.insert(0, -exponent - digits.size() + 1, '0');
+    }
+    digits.insert(digits.size() + exponent, ".");
+  }
+  return ((negative ? "-" : "") + digits);
+}
+
+// the old routine showed "-0" for negative numbers rounded to zero
+static std::string reference(double number)
+{
+  std::string s = doubleToString(number, FORMAT_DIGITS);
+  return ((s == "-0") ? "0" : s);
+}
+
+static uint8_t countDigits(const std::string &s)
+{
+  uint8_t digits = 0;
+  for (char c : s)
+  {
+    if ((c >= '0') && (c <= '9'))
+    {
+      digits++;
+    }
+  }
+  return (digits);
+}
+
+// a number in scientific notation didn't fit into the old fixed
+// notation or the digits shown there were not the ones of the mantissa
+static bool isScientificValid(const std::string &formatted, const std::string &expected)
+{
+  std::string number = formatted;
+  number.replace(number.find(FORMAT_EXPONENT_MARK), 1, "e");
+  return ((countDigits(expected) > FORMAT_DIGITS) ||
+          (strtod(number.c_str(), nullptr) != strtod(expected.c_str(), nullptr)));
+}
+
+static void check(FORMAT_REPORT *report, const std::string &formatted, const std::string &expected, const char *input)
+{
+  report->values++;
+  if (formatted.find(FORMAT_EXPONENT_MARK) != std::string::npos)
+  {
+    report->scientific++;
+    if (isScientificValid(formatted, expected))
+    {
+      return;
+    }
+  }
+  else
+  {
+    report->fixed++;
+    if (formatted == expected)
+    {
+      return;
+    }
+  }
+  if (report->mismatches < 5)
+  {
+    Serial.printf("  %s: %s instead of %s\r\n", input, formatted.c_str(), expected.c_str());
+  }
+  report->mismatches++;
+}
+
+static void checkDouble(FORMAT_REPORT *report, const std::vector<double> &values)
+{
+  char buffer[32];
+  char input[32];
+  for (double value : values)
+  {
+    NumberFormatter::format(value, FORMAT_DIGITS, buffer, sizeof(buffer));
+    snprintf(input, sizeof(input), "%.17g", value);
+    check(report, buffer, reference(value), input);
+  }
+}
+
+// the text is parsed by both, strtod() gives the nearest double like
+// the double engine did, a tie of the display is decided by the last
+// bit of that double but rounded half up by the decimal formatter
+static void checkDecimal(FORMAT_REPORT *report, const std::vector<std::string> &values)
+{
+  char buffer[32];
+  for (const auto &text : values)
+  {
+    DecimalNumber value = DecimalNumber::fromString(text.c_str());
+    double nearest = strtod(text.c_str(), nullptr);
+    std::string expected = reference(nearest);
+    if ((countDigits(expected) <= FORMAT_DIGITS) &&
+        ((reference(nextafter(nearest, -INFINITY)) != expected) ||
+         (reference(nextafter(nearest, INFINITY)) != expected)))
+    {
+      report->values++;
+      report->ties++;
+      continue;
+    }
+    NumberFormatter::format(value, FORMAT_DIGITS, buffer, sizeof(buffer));
+    check(report, buffer, expected, text.c_str());
+  }
+}
+
+static void print(const FORMAT_REPORT *report)
+{
+  Serial.printf("%-18s %9u %9u %9u %9u %9u\r\n", report->name, report->values, report->fixed,
+                report->scientific, report->ties, report->mismatches);
+}
+
+int main()
+{
+  std::vector<double> shortValues;
+  std::vector<double> binaryTies;
+  std::vector<double> randomBits;
+  std::vector<double> randomMagnitudes;
+  std::vector<std::string> decimalValues;
+  uint32_t state = FORMAT_SEED;
+  char buffer[48];
+
+  // short decimals as typed and their neighbours, the double is
+  // just above or below the decimal value
+  for (int i = -20000; i <= 20000; i++)
+  {
+    for (int exponent = -16; exponent <= 16; exponent += 2)
+    {
+      double value = i * pow(10.0, exponent);
+      shortValues.push_back(value);
+      shortValues.push_back(nextafter(value, -INFINITY));
+      shortValues.push_back(nextafter(value, INFINITY));
+    }
+  }
+  for (uint32_t i = 0; i < FORMAT_RANDOM_VALUES; i++)
+  {
+    // k / 2^n, exact ties of the last display digit for printf
+    binaryTies.push_back(ldexp((double)(int64_t)(nextRandom64(&state) >> 20) - (double)(1LL << 43),
+                               -(int)(nextRandom(&state) % 53)));
+    // any double the old routine can print into its buffer
+    uint64_t bits = nextRandom64(&state);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    randomBits.push_back((fabs(value) < FORMAT_MAX_VALUE) ? value : 0);
+    // up to 17 digits from 1e-20 to 1e20
+    value = (double)(nextRandom64(&state) % 100000000000000000ULL) * pow(10.0, (int)(nextRandom(&state) % 41) - 37);
+    randomMagnitudes.push_back((nextRandom(&state) & 1) ? -value : value);
+    // 1 to 18 digits from 1e-20 to 1e18, exactly as typed
+    uint8_t digits = 1 + nextRandom(&state) % DECIMAL_PRECISION;
+    uint64_t coefficient = nextRandom64(&state) % (uint64_t)pow(10.0, digits);
+    decimalValues.push_back(toText((nextRandom(&state) & 1) != 0, coefficient,
+                                   (int)(nextRandom(&state) % 39) - 20 - digits));
+  }
+
+  Serial.printf("%u display digits, NumberFormatter against doubleToString\r\n", FORMAT_DIGITS);
+  Serial.printf("%-18s %9s %9s %9s %9s %9s\r\n", "values", "count", "fixed", "scientific", "ties", "mismatches");
+  const std::vector<double> *sets[] = {&shortValues, &binaryTies, &randomBits, &randomMagnitudes};
+  const char *setNames[] = {"double short", "double ties", "double bits", "double magnitudes"};
+  uint32_t failed = 0;
+  for (uint8_t s = 0; s < 4; s++)
+  {
+    FORMAT_REPORT report = {};
+    report.name = setNames[s];
+    checkDouble(&report, *sets[s]);
+    print(&report);
+    failed += report.mismatches;
+  }
+  FORMAT_REPORT report = {};
+  report.name = "decimal";
+  checkDecimal(&report, decimalValues);
+  print(&report);
+  failed += report.mismatches;
+
+  // speed on the random magnitudes, one display text per value
+  std::vector<DecimalNumber> decimals;
+  for (double value : randomMagnitudes)
+  {
+    decimals.push_back(DecimalNumber(value));
+  }
+  uint32_t calls = FORMAT_BENCHMARK_ROUNDS * randomMagnitudes.size();
+  uint32_t length = 0;
+  unsigned long start = micros();
+  for (uint8_t round = 0; round < FORMAT_BENCHMARK_ROUNDS; round++)
+  {
+    for (double value : randomMagnitudes)
+    {
+      length += doubleToString(value, FORMAT_DIGITS).length();
+    }
+  }
+  unsigned long oldTime = micros() - start;
+  start = micros();
+  for (uint8_t round = 0; round < FORMAT_BENCHMARK_ROUNDS; round++)
+  {
+    for (double value : randomMagnitudes)
+    {
+      length += NumberFormatter::format(value, FORMAT_DIGITS, buffer, sizeof(buffer));
+    }
+  }
+  unsigned long doubleTime = micros() - start;
+  start = micros();
+  for (uint8_t round = 0; round < FORMAT_BENCHMARK_ROUNDS; round++)
+  {
+    for (const auto &value : decimals)
+    {
+      length += NumberFormatter::format(value, FORMAT_DIGITS, buffer, sizeof(buffer));
+    }
+  }
+  unsigned long decimalTime = micros() - start;
+  Serial.printf("speed: %.1f ns doubleToString, %.1f ns double, %.1f ns decimal (%u)\r\n",
+                oldTime * 1000.0 / calls, doubleTime * 1000.0 / calls, decimalTime * 1000.0 / calls, length);
+
+  Serial.printf("%s\r\n", (failed == 0) ? "formatter check passed" : "formatter check failed");
+  return ((failed == 0) ? 0 : 1);
+}
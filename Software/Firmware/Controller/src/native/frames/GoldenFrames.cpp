@@ -0,0 +1,324 @@
+// GoldenFrames.cpp
+
+// the shift register frames of the display driver against the frames
+// recorded in GoldenFrames.h, for the display type of the build,
+// every pattern is encoded three ways: by buildFrame(), by refresh()
+// shifting it out on the pins, and directly from the translation
+// table of the HAL, all three must give the recorded bytes,
+// --record prints the frames of this build for GoldenFrames.h
+// run with: pio run -e native_frames_in16 -t exec, one env per type
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <Arduino.h>
+#include <HostRuntime.h>
+#include <DisplayHandler.h>
+#include <string>
+#include "GoldenFrames.h"
+
+#define FRAMES_PIN_SHIFT 17
+#define FRAMES_PIN_STORE 16
+#define FRAMES_PIN_DATA 18
+#define FRAMES_PIN_BLANK 19
+#define FRAMES_PIN_LEDCTL 14
+
+#define STRINGIFY(x) #x
+#define TO_STRING(x) STRINGIFY(x)
+
+typedef DisplayHandler::HAL HAL;
+
+// what a pattern lights, the same for all display types,
+// the signs a HAL doesn't have stay dark
+typedef struct
+{
+  uint8_t digits[HAL::digitCount];
+  bool decimalPoints[HAL::decimalPointCount];
+  bool minusSign;
+  bool plusSign;
+  bool menuSign;
+} FRAME_PATTERN;
+
+// patterns 0 to 9 light every number of every digit once,
+// 10 has unlit digits in between, 11 is dark
+static void getPattern(uint8_t index, FRAME_PATTERN *pattern)
+{
+  memset(pattern, 0, sizeof(FRAME_PATTERN));
+  for (uint8_t i = 0; i < HAL::digitCount; i++)
+  {
+    if (index < 10)
+    {
+      pattern->digits[i] = (i + index) % 10;
+    }
+    else if (index == 10)
+    {
+      pattern->digits[i] = ((i % 4) == 3) ? DIGIT_OFF : i % 10;
+    }
+    else
+    {
+      pattern->digits[i] = DIGIT_OFF;
+    }
+  }
+  if (index < 10)
+  {
+    for (uint8_t i = 0; i < HAL::decimalPointCount; i++)
+    {
+      pattern->decimalPoints[i] = ((i + index) % 3) == 0;
+    }
+    pattern->minusSign = (index % 2) == 1;
+    pattern->plusSign = HAL::hasPlusSign && ((index % 3) == 1);
+    pattern->menuSign = HAL::hasMenuSign && ((index % 4) == 2);
+  }
+}
+
+static void setPattern(DisplayHandler *display, const FRAME_PATTERN &pattern)
+{
+  display->clear();
+  for (uint8_t i = 0; i < HAL::digitCount; i++)
+  {
+    display->setDigit(i, pattern.digits[i]);
+  }
+  for (uint8_t i = 0; i < HAL::decimalPointCount; i++)
+  {
+    display->setDecimalPoint(i, pattern.decimalPoints[i] ? decimal_point_state::on : decimal_point_state::off);
+  }
+  display->setMinusSign(pattern.minusSign ? minus_sign_state::on : minus_sign_state::off);
+  display->setPlusSign(pattern.plusSign ? plus_sign_state::on : plus_sign_state::off);
+  display->setMenuSign(pattern.menuSign ? menu_sign_state::on : menu_sign_state::off);
+}
+
+// every register the translation table says is lit by the pattern,
+// independent of the register lookup of the driver
+static void encodePattern(const FRAME_PATTERN &pattern, DisplayFrame *frame)
+{
+  frame->clear();
+  for (uint8_t i = 0; i < REGISTER_COUNT; i++)
+  {
+    const TRANSLATION_TABLE_ENTRY &entry = HAL::translationTable.entries[i];
+    bool lit = false;
+    switch (entry.rt)
+    {
+    case register_type::number:
+      lit = (pattern.digits[entry.digit] == entry.number);
+      break;
+
+    case register_type::decimal_point:
+      lit = pattern.decimalPoints[entry.digit];
+      break;
+
+    case register_type::minus_sign:
+      lit = pattern.minusSign;
+      break;
+
+    case register_type::plus_sign:
+      lit = pattern.plusSign;
+      break;
+
+    case register_type::menu_sign:
+      lit = pattern.menuSign;
+      break;
+
+    default:
+      break;
+    }
+    if (lit)
+    {
+      frame->setRegister(i + 1);
+    }
+  }
+}
+
+// the bits on the data pin at the shift edges, packed like DisplayFrame
+// when the store edge latches them
+class ShiftCapture
+{
+public:
+  ShiftCapture()
+  {
+    _data = LOW;
+    _shiftLevel = SHIFT_COMMIT;
+    _storeLevel = STORE_COMMIT;
+    _bits = 0;
+    _frames = 0;
+    _valid = false;
+    memset(_shifted, 0, sizeof(_shifted));
+    memset(_latched, 0, sizeof(_latched));
+  }
+
+  void begin()
+  {
+    HostRuntime::attachPins(this, onPinCallback);
+  }
+
+  // the latched bytes, valid if exactly one frame of bits was shifted
+  const uint8_t *getLatched()
+  {
+    return (_latched);
+  }
+
+  bool isValid()
+  {
+    return (_valid);
+  }
+
+  uint32_t getFrames()
+  {
+    return (_frames);
+  }
+
+  static void onPinCallback(void *obj, uint8_t pin, uint8_t value)
+  {
+    ((ShiftCapture *)obj)->onPin(pin, value);
+  }
+
+private:
+  uint8_t _data;
+  uint8_t _shiftLevel;
+  uint8_t _storeLevel;
+  uint16_t _bits;
+  uint32_t _frames;
+  bool _valid;
+  uint8_t _shifted[FRAME_SIZE];
+  uint8_t _latched[FRAME_SIZE];
+
+  void onPin(uint8_t pin, uint8_t value)
+  {
+    if (pin == FRAMES_PIN_DATA)
+    {
+      _data = value;
+    }
+    else if (pin == FRAMES_PIN_SHIFT)
+    {
+      if ((_shiftLevel == SHIFT_BEGIN) && (value == SHIFT_COMMIT))
+      {
+        if ((_bits < REGISTER_COUNT) && _data)
+        {
+          _shifted[_bits / 8] |= (0x80 >> (_bits % 8));
+        }
+        _bits++;
+      }
+      _shiftLevel = value;
+    }
+    else if (pin == FRAMES_PIN_STORE)
+    {
+      if ((_storeLevel == STORE_BEGIN) && (value == STORE_COMMIT))
+      {
+        memcpy(_latched, _shifted, FRAME_SIZE);
+        _valid = (_bits == REGISTER_COUNT);
+        _frames++;
+        _bits = 0;
+        memset(_shifted, 0, sizeof(_shifted));
+      }
+      _storeLevel = value;
+    }
+  }
+};
+
+static const GOLDEN_FRAMES *findGoldenFrames()
+{
+  for (uint8_t i = 0; i < GOLDEN_FRAMES_COUNT; i++)
+  {
+    if (goldenFrames[i].type == DISPLAY_TYPE)
+    {
+      return (&goldenFrames[i]);
+    }
+  }
+  return (nullptr);
+}
+
+static void printFrame(const char *name, const uint8_t *data)
+{
+  Serial.printf("  %-10s", name);
+  for (uint8_t i = 0; i < FRAME_SIZE; i++)
+  {
+    Serial.printf(" %02x", data[i]);
+  }
+  Serial.printf("\r\n");
+}
+
+// the frames of this build as an entry of goldenFrames[]
+static void record(DisplayHandler *display)
+{
+  Serial.printf("    {%s,\r\n     {", TO_STRING(DISPLAY_TYPE));
+  for (uint8_t pattern = 0; pattern < GOLDEN_PATTERN_COUNT; pattern++)
+  {
+    FRAME_PATTERN p;
+    DisplayFrame frame;
+    getPattern(pattern, &p);
+    setPattern(display, p);
+    display->buildFrame(&frame);
+    Serial.printf("%s{", (pattern == 0) ? "" : "      ");
+    for (uint8_t i = 0; i < FRAME_SIZE; i++)
+    {
+      Serial.printf("0x%02x%s", frame.getData()[i], (i < FRAME_SIZE - 1) ? ", " : "");
+    }
+    Serial.printf("}%s\r\n", (pattern < GOLDEN_PATTERN_COUNT - 1) ? "," : "}},");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  bool recording = false;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--record")
+    {
+      recording = true;
+    }
+    else
+    {
+      Serial.printf("usage: %s [--record]\r\n", argv[0]);
+      return (2);
+    }
+  }
+
+  // begin() is not called, refresh() shifts the frames out inline
+  DisplayHandler display(FRAMES_PIN_DATA, FRAMES_PIN_STORE, FRAMES_PIN_SHIFT, FRAMES_PIN_BLANK, FRAMES_PIN_LEDCTL);
+  if (recording)
+  {
+    record(&display);
+    return (0);
+  }
+
+  const GOLDEN_FRAMES *golden = findGoldenFrames();
+  if (!golden)
+  {
+    Serial.printf("%s: no golden frames recorded\r\n", TO_STRING(DISPLAY_TYPE));
+    return (1);
+  }
+
+  ShiftCapture capture;
+  capture.begin();
+  uint8_t failed = 0;
+  for (uint8_t pattern = 0; pattern < GOLDEN_PATTERN_COUNT; pattern++)
+  {
+    FRAME_PATTERN p;
+    DisplayFrame built;
+    DisplayFrame expected;
+    getPattern(pattern, &p);
+    setPattern(&display, p);
+    display.buildFrame(&built);
+    encodePattern(p, &expected);
+    uint32_t frames = capture.getFrames();
+    display.refresh();
+
+    const uint8_t *recorded = golden->frames[pattern];
+    bool builtOk = (memcmp(built.getData(), recorded, FRAME_SIZE) == 0);
+    bool tableOk = (memcmp(expected.getData(), recorded, FRAME_SIZE) == 0);
+    bool shiftedOk = (capture.getFrames() == frames + 1) && capture.isValid() &&
+                     (memcmp(capture.getLatched(), recorded, FRAME_SIZE) == 0);
+    if (!builtOk || !tableOk || !shiftedOk)
+    {
+      Serial.printf("pattern %u differs\r\n", pattern);
+      printFrame("recorded", recorded);
+      printFrame("built", built.getData());
+      printFrame("table", expected.getData());
+      printFrame("shifted", capture.getLatched());
+      failed++;
+    }
+  }
+
+  Serial.printf("%s: %u patterns, %u failed\r\n", TO_STRING(DISPLAY_TYPE), GOLDEN_PATTERN_COUNT, failed);
+  return ((failed == 0) ? 0 : 1);
+}
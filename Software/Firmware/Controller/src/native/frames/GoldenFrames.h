@@ -0,0 +1,77 @@
+// GoldenFrames.h
+
+// shift register frames recorded from the display driver,
+// GOLDEN_PATTERN_COUNT patterns per display type, see getPattern()
+// in GoldenFrames.cpp, print new ones with GoldenFrames --record
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <DisplayDriver.h>
+
+#define GOLDEN_PATTERN_COUNT 12
+
+typedef struct
+{
+  display_type type;
+  uint8_t frames[GOLDEN_PATTERN_COUNT][FRAME_SIZE];
+} GOLDEN_FRAMES;
+
+static const GOLDEN_FRAMES goldenFrames[] = {
+    {display_type::in12,
+     {{0x00, 0x00, 0x08, 0x01, 0x11, 0x13, 0x00, 0x04, 0x02, 0x10, 0x08, 0x10, 0x00, 0x08, 0x04, 0x54, 0x00, 0x00, 0x00, 0x81},
+      {0x00, 0x02, 0x04, 0x00, 0x08, 0x88, 0x98, 0x00, 0x81, 0x20, 0x04, 0x00, 0x20, 0x00, 0x40, 0x22, 0x18, 0x00, 0x20, 0x40},
+      {0x00, 0x81, 0x02, 0x20, 0x00, 0x44, 0x44, 0xc0, 0x40, 0x81, 0x00, 0x00, 0x01, 0x00, 0x02, 0x01, 0x20, 0x08, 0x10, 0x20},
+      {0x20, 0x40, 0x81, 0x01, 0x00, 0x02, 0x22, 0x26, 0x20, 0x40, 0x00, 0x00, 0x00, 0x08, 0x00, 0x10, 0x0a, 0x04, 0x08, 0x10},
+      {0x10, 0x20, 0x40, 0x80, 0x08, 0x00, 0x11, 0x11, 0x10, 0x00, 0x00, 0x08, 0x30, 0x00, 0x40, 0x00, 0x11, 0x02, 0x04, 0x08},
+      {0x08, 0x10, 0x20, 0x60, 0x00, 0x40, 0x00, 0x88, 0x00, 0x00, 0x02, 0x04, 0x89, 0x80, 0x02, 0x00, 0x08, 0x81, 0x02, 0x04},
+      {0x04, 0x08, 0x10, 0x11, 0x00, 0x02, 0x00, 0x04, 0x00, 0x00, 0x81, 0x02, 0x44, 0x4c, 0x00, 0x10, 0x20, 0x40, 0x81, 0x00},
+      {0x02, 0x04, 0x00, 0x08, 0x88, 0x00, 0x10, 0x00, 0x00, 0x02, 0x40, 0x81, 0x22, 0x22, 0x60, 0x00, 0x18, 0x20, 0x40, 0x00},
+      {0x81, 0x00, 0x00, 0x24, 0x44, 0x40, 0x00, 0x80, 0x08, 0x04, 0x20, 0x40, 0x01, 0x11, 0x13, 0x00, 0x00, 0x10, 0x00, 0x00},
+      {0x40, 0x00, 0x00, 0x03, 0x22, 0x22, 0x00, 0x04, 0x04, 0x08, 0x10, 0x20, 0x00, 0x08, 0x88, 0x98, 0x08, 0x00, 0x00, 0x02},
+      {0x00, 0x00, 0x08, 0x00, 0x10, 0x11, 0x00, 0x00, 0x02, 0x10, 0x00, 0x10, 0x00, 0x00, 0x04, 0x44, 0x00, 0x00, 0x00, 0x01},
+      {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}}},
+    {display_type::in16,
+     {{0x00, 0x04, 0x40, 0x40, 0x04, 0x00, 0x70, 0x01, 0x00, 0x10, 0x11, 0x00, 0x10, 0x01, 0x08, 0x10, 0x01, 0x00, 0x14, 0x01},
+      {0x04, 0x08, 0x00, 0x88, 0x08, 0x00, 0x80, 0x0e, 0x00, 0x20, 0x02, 0x02, 0x20, 0x02, 0x00, 0x21, 0x02, 0x00, 0x20, 0x02},
+      {0x02, 0x10, 0x01, 0x00, 0x11, 0x01, 0x00, 0x10, 0x01, 0xc0, 0x04, 0x00, 0x40, 0x44, 0x00, 0x40, 0x04, 0x20, 0x40, 0x04},
+      {0x04, 0x20, 0x42, 0x00, 0x20, 0x02, 0x20, 0x20, 0x02, 0x00, 0x38, 0x00, 0x80, 0x08, 0x08, 0x80, 0x08, 0x00, 0x84, 0x08},
+      {0x00, 0x40, 0x04, 0x08, 0x40, 0x04, 0x00, 0x44, 0x04, 0x00, 0x40, 0x07, 0x00, 0x10, 0x01, 0x01, 0x10, 0x01, 0x00, 0x10},
+      {0x06, 0x80, 0x08, 0x00, 0x81, 0x08, 0x00, 0x80, 0x08, 0x80, 0x80, 0x08, 0x00, 0xe0, 0x02, 0x00, 0x20, 0x22, 0x00, 0x20},
+      {0x01, 0x00, 0x50, 0x01, 0x00, 0x10, 0x21, 0x00, 0x10, 0x01, 0x10, 0x10, 0x01, 0x00, 0x1c, 0x00, 0x40, 0x04, 0x04, 0x40},
+      {0x04, 0x00, 0xa0, 0x0a, 0x00, 0x20, 0x02, 0x04, 0x20, 0x02, 0x00, 0x22, 0x02, 0x00, 0x20, 0x03, 0x80, 0x08, 0x00, 0x80},
+      {0x02, 0x01, 0x00, 0x14, 0x01, 0x40, 0x04, 0x00, 0x40, 0x84, 0x00, 0x40, 0x04, 0x40, 0x40, 0x04, 0x00, 0x70, 0x01, 0x00},
+      {0x04, 0x02, 0x40, 0x20, 0x02, 0x80, 0x28, 0x00, 0x80, 0x08, 0x10, 0x80, 0x08, 0x00, 0x88, 0x08, 0x00, 0x80, 0x0e, 0x00},
+      {0x00, 0x04, 0x00, 0x40, 0x00, 0x00, 0x50, 0x01, 0x00, 0x00, 0x01, 0x00, 0x10, 0x01, 0x00, 0x00, 0x01, 0x00, 0x10, 0x01},
+      {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}}},
+    {display_type::in17,
+     {{0x00, 0x12, 0x00, 0x80, 0x80, 0x30, 0x08, 0x02, 0x10, 0x20, 0x01, 0x00, 0x08, 0x12, 0x01, 0x00, 0x02, 0x20, 0x80, 0x20},
+      {0x00, 0x84, 0x02, 0x01, 0x20, 0x40, 0x10, 0x04, 0x40, 0x08, 0x04, 0x01, 0x90, 0x08, 0x00, 0x80, 0x04, 0x01, 0x00, 0x40},
+      {0x00, 0x08, 0x09, 0x00, 0x00, 0x80, 0x22, 0x08, 0x80, 0x10, 0x0a, 0x02, 0x40, 0x04, 0x02, 0x00, 0x08, 0x02, 0x04, 0x80},
+      {0x00, 0x50, 0x04, 0x01, 0x01, 0x10, 0x40, 0x10, 0x00, 0x60, 0x10, 0x04, 0x20, 0x10, 0x04, 0x01, 0x10, 0x24, 0x02, 0x00},
+      {0x00, 0xa0, 0x00, 0x02, 0x22, 0x00, 0x80, 0x40, 0x40, 0x80, 0x20, 0x08, 0x80, 0x20, 0x08, 0x02, 0x20, 0x10, 0x01, 0x00},
+      {0x00, 0x00, 0x11, 0x05, 0x04, 0x02, 0x02, 0x20, 0x01, 0x00, 0x42, 0x10, 0x00, 0x40, 0x12, 0x04, 0x80, 0x08, 0x04, 0x01},
+      {0x01, 0x10, 0x20, 0x08, 0x10, 0x11, 0x00, 0x00, 0x02, 0x20, 0x80, 0x20, 0x00, 0x90, 0x20, 0x08, 0x40, 0x20, 0x08, 0x02},
+      {0x02, 0x80, 0x40, 0x11, 0x28, 0x00, 0x00, 0x80, 0x44, 0x01, 0x00, 0x80, 0x81, 0x00, 0x40, 0x10, 0x00, 0x40, 0x10, 0x04},
+      {0x04, 0x00, 0x81, 0x20, 0x00, 0x04, 0x03, 0x00, 0x08, 0x04, 0x02, 0x40, 0x02, 0x00, 0x82, 0x20, 0x00, 0x80, 0x24, 0x08},
+      {0x00, 0x11, 0x00, 0x41, 0x40, 0x18, 0x04, 0x01, 0x20, 0x22, 0x00, 0x00, 0x04, 0x11, 0x00, 0x40, 0x01, 0x20, 0x40, 0x10},
+      {0x00, 0x02, 0x00, 0x80, 0x80, 0x20, 0x08, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x02, 0x01, 0x00, 0x02, 0x00, 0x80, 0x20},
+      {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}}},
+    {display_type::b5870,
+     {{0x00, 0x04, 0x40, 0x40, 0x04, 0x00, 0x70, 0x01, 0x00, 0x10, 0x11, 0x00, 0x10, 0x01, 0x08, 0x10, 0x01, 0x00, 0x14, 0x01},
+      {0x04, 0x08, 0x00, 0x88, 0x08, 0x00, 0x80, 0x0e, 0x00, 0x20, 0x02, 0x02, 0x20, 0x02, 0x00, 0x21, 0x02, 0x00, 0x20, 0x02},
+      {0x02, 0x10, 0x01, 0x00, 0x11, 0x01, 0x00, 0x10, 0x01, 0xc0, 0x04, 0x00, 0x40, 0x44, 0x00, 0x40, 0x04, 0x20, 0x40, 0x04},
+      {0x04, 0x20, 0x42, 0x00, 0x20, 0x02, 0x20, 0x20, 0x02, 0x00, 0x38, 0x00, 0x80, 0x08, 0x08, 0x80, 0x08, 0x00, 0x84, 0x08},
+      {0x00, 0x40, 0x04, 0x08, 0x40, 0x04, 0x00, 0x44, 0x04, 0x00, 0x40, 0x07, 0x00, 0x10, 0x01, 0x01, 0x10, 0x01, 0x00, 0x10},
+      {0x06, 0x80, 0x08, 0x00, 0x81, 0x08, 0x00, 0x80, 0x08, 0x80, 0x80, 0x08, 0x00, 0xe0, 0x02, 0x00, 0x20, 0x22, 0x00, 0x20},
+      {0x01, 0x00, 0x50, 0x01, 0x00, 0x10, 0x21, 0x00, 0x10, 0x01, 0x10, 0x10, 0x01, 0x00, 0x1c, 0x00, 0x40, 0x04, 0x04, 0x40},
+      {0x04, 0x00, 0xa0, 0x0a, 0x00, 0x20, 0x02, 0x04, 0x20, 0x02, 0x00, 0x22, 0x02, 0x00, 0x20, 0x03, 0x80, 0x08, 0x00, 0x80},
+      {0x02, 0x01, 0x00, 0x14, 0x01, 0x40, 0x04, 0x00, 0x40, 0x84, 0x00, 0x40, 0x04, 0x40, 0x40, 0x04, 0x00, 0x70, 0x01, 0x00},
+      {0x04, 0x02, 0x40, 0x20, 0x02, 0x80, 0x28, 0x00, 0x80, 0x08, 0x10, 0x80, 0x08, 0x00, 0x88, 0x08, 0x00, 0x80, 0x0e, 0x00},
+      {0x00, 0x04, 0x00, 0x40, 0x00, 0x00, 0x50, 0x01, 0x00, 0x00, 0x01, 0x00, 0x10, 0x01, 0x00, 0x00, 0x01, 0x00, 0x10, 0x01},
+      {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}}},
+};
+
+#define GOLDEN_FRAMES_COUNT (sizeof(goldenFrames) / sizeof(goldenFrames[0]))
@@ -0,0 +1,481 @@
+// KeyScript.h
+
+// plays a script of keystrokes into the keyboard UART of the simulator,
+// every step runs from the HostRuntime event queue at its virtual time
+//
+// # comment
+// keys 12+34=       types the keys, digits . + - * / = %
+// key sqrt [fn]     one named key, fn holds the function key
+// mode              taps the function key, calculator <-> clock, leaves the menu
+// menu              holds the function key, enters the menu
+// speed 100         time between two keys in ms
+// wait 1h           waits in ms, s, m, h or d
+// expect -46.5      compares with the display, without the unlit digits
+//                   around the number
+// check offset 0 10 compares a value of the simulation, see the simulator,
+//                   with the expected value and the tolerance
+// show              prints the display
+// console h         sends the text to the serial console of the firmware
+// repeat 1000       runs the steps up to the matching end
+// end
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <HostRuntime.h>
+#include <KeyboardHandler.h>
+#include <vector>
+
+#define KEYSCRIPT_DEFAULT_INTERVAL 100 // ms
+#define KEYSCRIPT_HOLD_TIME 2000       // ms, as set by the controller
+
+enum class script_step : uint8_t
+{
+  key,
+  mode,
+  menu,
+  speed,
+  wait,
+  expect,
+  check,
+  show,
+  console,
+  repeat,
+  end
+};
+
+typedef struct
+{
+  script_step step;
+  uint8_t keyCode;
+  bool functionKeyPressed;
+  uint64_t value; // speed and wait in us, repeat count, jump target of repeat/end
+  String text;
+  double expected;  // check
+  double tolerance; // check
+  uint16_t line;
+} SCRIPT_STEP;
+
+typedef struct
+{
+  const char *name;
+  uint8_t keyCode;
+} SCRIPT_KEY;
+
+static const SCRIPT_KEY scriptKeys[] = {
+    {"0", KEY_0}, {"1", KEY_1}, {"2", KEY_2}, {"3", KEY_3}, {"4", KEY_4}, {"5", KEY_5}, {"6", KEY_6}, {"7", KEY_7}, {"8", KEY_8}, {"9", KEY_9}, {".", KEY_DOT}, {"00", KEY_00}, {"+", KEY_PLUS}, {"-", KEY_MINUS}, {"*", KEY_MUL}, {"/", KEY_DIV}, {"=", KEY_EQUALS}, {"%", KEY_PERCENT}, {"sqrt", KEY_SQUAREROOT}, {"pm", KEY_PLUSMINUS}, {"c", KEY_C}, {"ac", KEY_AC}, {"mc", KEY_MC}, {"mr", KEY_MR}, {"ms", KEY_MS}, {"m+", KEY_MPLUS}, {"m-", KEY_MMINUS}, {"sin", KEY_SIN}, {"cos", KEY_COS}, {"tan", KEY_TAN}, {"log", KEY_LOG}, {"ln", KEY_LN}, {"inv", KEY_INV}, {"pow", KEY_POW}, {"f", KEY_FUNCTION}};
+
+class KeyScript
+{
+protected:
+  using displayCallBack = const char *(*)(void *obj);
+  // false if the simulation has no such value now
+  using probeCallBack = bool (*)(void *obj, const String &name, double *value);
+
+public:
+  KeyScript(int uart) : _uart(uart)
+  {
+    _port = nullptr;
+    _obj = nullptr;
+    _display = nullptr;
+    _probeObj = nullptr;
+    _probe = nullptr;
+    _position = 0;
+    _interval = KEYSCRIPT_DEFAULT_INTERVAL * 1000;
+    _done = true;
+    _keystrokes = 0;
+    _checks = 0;
+    _failures = 0;
+  }
+
+  // reads the whole script, false with a message on the first bad line
+  bool load(FILE *file, String *error)
+  {
+    char line[256];
+    uint16_t lineNumber = 0;
+    std::vector<size_t> repeats;
+
+    _steps.clear();
+    while (fgets(line, sizeof(line), file))
+    {
+      lineNumber++;
+      String s(line);
+      int comment = s.indexOf('#');
+      if (comment >= 0)
+      {
+        s = s.substring(0, comment);
+      }
+      s.trim();
+      if (s.length() == 0)
+      {
+        continue;
+      }
+      int space = s.indexOf(' ');
+      String command = (space < 0) ? s : s.substring(0, space);
+      String argument = (space < 0) ? String("") : s.substring(space + 1);
+      argument.trim();
+
+      SCRIPT_STEP step = {};
+      step.line = lineNumber;
+      bool valid = true;
+      if (command == "keys")
+      {
+        for (uint16_t i = 0; (i < argument.length()) && valid; i++)
+        {
+          if (argument[i] != ' ')
+          {
+            step.step = script_step::key;
+            valid = findKey(String(argument[i]), &step.keyCode);
+            _steps.push_back(step);
+          }
+        }
+        valid = valid && (argument.length() > 0);
+        if (!valid)
+        {
+          *error = String("line ") + String(lineNumber) + ": unknown key in \"" + argument + "\"";
+          return (false);
+        }
+        continue;
+      }
+      else if (command == "key")
+      {
+        step.step = script_step::key;
+        if (argument.endsWith(" fn"))
+        {
+          step.functionKeyPressed = true;
+          argument = argument.substring(0, argument.length() - 3);
+          argument.trim();
+        }
+        valid = findKey(argument, &step.keyCode);
+      }
+      else if (command == "mode")
+      {
+        step.step = script_step::mode;
+      }
+      else if (command == "menu")
+      {
+        step.step = script_step::menu;
+      }
+      else if (command == "speed")
+      {
+        step.step = script_step::speed;
+        step.value = (uint64_t)argument.toInt() * 1000;
+        valid = step.value > 0;
+      }
+      else if (command == "wait")
+      {
+        step.step = script_step::wait;
+        valid = parseDuration(argument, &step.value);
+      }
+      else if (command == "expect")
+      {
+        step.step = script_step::expect;
+        step.text = argument;
+      }
+      else if (command == "check")
+      {
+        char name[32];
+        step.step = script_step::check;
+        valid = (sscanf(argument.c_str(), "%31s %lf %lf", name, &step.expected, &step.tolerance) == 3);
+        step.text = name;
+      }
+      else if (command == "show")
+      {
+        step.step = script_step::show;
+      }
+      else if (command == "console")
+      {
+        step.step = script_step::console;
+        step.text = argument;
+        valid = argument.length() > 0;
+      }
+      else if (command == "repeat")
+      {
+        step.step = script_step::repeat;
+        step.value = (uint64_t)argument.toInt();
+        repeats.push_back(_steps.size());
+      }
+      else if ((command == "end") && !repeats.empty())
+      {
+        // end jumps back to its repeat, repeat jumps past its end
+        step.step = script_step::end;
+        step.value = repeats.back();
+        repeats.pop_back();
+      }
+      else
+      {
+        valid = false;
+      }
+      if (!valid)
+      {
+        *error = String("line ") + String(lineNumber) + ": can't read \"" + s + "\"";
+        return (false);
+      }
+      _steps.push_back(step);
+    }
+    if (!repeats.empty())
+    {
+      *error = String("line ") + String(_steps[repeats.back()].line) + ": repeat without end";
+      return (false);
+    }
+    return (true);
+  }
+
+  // the display is read for expect and show
+  void attachDisplay(void *obj, displayCallBack callBack)
+  {
+    _obj = obj;
+    _display = callBack;
+  }
+
+  // the values of the simulation are read for check
+  void attachProbe(void *obj, probeCallBack callBack)
+  {
+    _probeObj = obj;
+    _probe = callBack;
+  }
+
+  // the firmware must have opened the port
+  bool begin()
+  {
+    _port = HardwareSerial::getPort(_uart);
+    _position = 0;
+    _counters.assign(_steps.size(), 0);
+    _done = (_port == nullptr);
+    if (!_done)
+    {
+      scheduleNext(HostRuntime::getTime());
+    }
+    return (!_done);
+  }
+
+  bool isDone()
+  {
+    return (_done);
+  }
+
+  // key presses sent, function key included
+  uint32_t getKeystrokes()
+  {
+    return (_keystrokes);
+  }
+
+  uint32_t getChecks()
+  {
+    return (_checks);
+  }
+
+  uint32_t getFailures()
+  {
+    return (_failures);
+  }
+
+private:
+  int _uart;
+  HardwareSerial *_port;
+  void *_obj;
+  displayCallBack _display;
+  void *_probeObj;
+  probeCallBack _probe;
+  std::vector<SCRIPT_STEP> _steps;
+  std::vector<uint64_t> _counters; // remaining runs of each repeat
+  size_t _position;
+  uint64_t _interval;
+  bool _done;
+  uint32_t _keystrokes;
+  uint32_t _checks;
+  uint32_t _failures;
+
+  static bool findKey(const String &name, uint8_t *keyCode)
+  {
+    for (const auto &key : scriptKeys)
+    {
+      if (name.equalsIgnoreCase(key.name))
+      {
+        *keyCode = key.keyCode;
+        return (true);
+      }
+    }
+    return (false);
+  }
+
+  static bool parseDuration(const String &s, uint64_t *duration)
+  {
+    double value = atof(s.c_str());
+    uint64_t unit = 1000;
+    if (s.endsWith("ms"))
+    {
+      unit = 1000;
+    }
+    else if (s.endsWith("s"))
+    {
+      unit = 1000000;
+    }
+    else if (s.endsWith("m"))
+    {
+      unit = 60 * 1000000ULL;
+    }
+    else if (s.endsWith("h"))
+    {
+      unit = 3600 * 1000000ULL;
+    }
+    else if (s.endsWith("d"))
+    {
+      unit = 24 * 3600 * 1000000ULL;
+    }
+    *duration = (uint64_t)(value * unit);
+    return (value > 0);
+  }
+
+  void scheduleNext(uint64_t time)
+  {
+    HostRuntime::schedule(time, [this]()
+                          { run(); });
+  }
+
+  void sendKey(uint64_t time, uint8_t keyCode, key_state keyState)
+  {
+    HostRuntime::schedule(time, [this, keyCode, keyState]()
+                          {
+                            uint8_t message[2] = {keyCode, (uint8_t)keyState};
+                            _port->receive(message, sizeof(message)); });
+    if (keyState == key_state::pressed)
+    {
+      _keystrokes++;
+    }
+  }
+
+  // runs the steps up to the next one that takes time
+  void run()
+  {
+    uint64_t time = HostRuntime::getTime();
+
+    while (_position < _steps.size())
+    {
+      SCRIPT_STEP &step = _steps[_position++];
+      switch (step.step)
+      {
+      case script_step::key:
+        if (step.functionKeyPressed)
+        {
+          sendKey(time, KEY_FUNCTION, key_state::pressed);
+          sendKey(time + _interval / 4, step.keyCode, key_state::pressed);
+          sendKey(time + _interval / 2, step.keyCode, key_state::released);
+          sendKey(time + _interval * 3 / 4, KEY_FUNCTION, key_state::released);
+        }
+        else
+        {
+          sendKey(time, step.keyCode, key_state::pressed);
+          sendKey(time + _interval / 2, step.keyCode, key_state::released);
+        }
+        scheduleNext(time + _interval);
+        return;
+
+      case script_step::mode:
+        sendKey(time, KEY_FUNCTION, key_state::pressed);
+        sendKey(time + _interval / 2, KEY_FUNCTION, key_state::released);
+        scheduleNext(time + _interval);
+        return;
+
+      case script_step::menu:
+        sendKey(time, KEY_FUNCTION, key_state::pressed);
+        sendKey(time + KEYSCRIPT_HOLD_TIME * 1000, KEY_FUNCTION, key_state::hold);
+        sendKey(time + KEYSCRIPT_HOLD_TIME * 1000 + _interval / 2, KEY_FUNCTION, key_state::released);
+        scheduleNext(time + KEYSCRIPT_HOLD_TIME * 1000 + _interval);
+        return;
+
+      case script_step::speed:
+        _interval = step.value;
+        break;
+
+      case script_step::wait:
+        scheduleNext(time + step.value);
+        return;
+
+      case script_step::expect:
+      {
+        _checks++;
+        String text = getDisplayText();
+        if (text != step.text)
+        {
+          _failures++;
+          Serial.printf("line %u: expected \"%s\", display shows \"%s\"\r\n", step.line, step.text.c_str(), text.c_str());
+        }
+        break;
+      }
+
+      case script_step::check:
+      {
+        double value;
+        _checks++;
+        if (!_probe || !_probe(_probeObj, step.text, &value))
+        {
+          _failures++;
+          Serial.printf("line %u: no value for %s\r\n", step.line, step.text.c_str());
+        }
+        else if (!(fabs(value - step.expected) <= step.tolerance))
+        {
+          _failures++;
+          Serial.printf("line %u: %s is %g, expected %g +-%g\r\n", step.line, step.text.c_str(), value,
+                        step.expected, step.tolerance);
+        }
+        break;
+      }
+
+      case script_step::show:
+        Serial.printf("line %u: \"%s\"\r\n", step.line, _display ? _display(_obj) : "");
+        break;
+
+      case script_step::console:
+        Serial.feed(step.text.c_str());
+        scheduleNext(time + _interval);
+        return;
+
+      case script_step::repeat:
+        _counters[_position - 1] = step.value;
+        if (step.value == 0)
+        {
+          skipLoop(_position - 1);
+        }
+        break;
+
+      case script_step::end:
+        if (--_counters[step.value] > 0)
+        {
+          _position = step.value + 1;
+        }
+        break;
+      }
+    }
+    _done = true;
+  }
+
+  // trimmed, the sign tube is moved next to the number
+  String getDisplayText()
+  {
+    String text(_display ? _display(_obj) : "");
+    text.trim();
+    if ((text.length() > 0) && ((text[0] == '-') || (text[0] == '+')))
+    {
+      String number = text.substring(1);
+      number.trim();
+      text = String(text[0]) + number;
+    }
+    return (text);
+  }
+
+  // jumps past the end of the repeat at the given step
+  void skipLoop(size_t repeat)
+  {
+    while ((_position < _steps.size()) &&
+           !((_steps[_position].step == script_step::end) && (_steps[_position].value == repeat)))
+    {
+      _position++;
+    }
+    _position++;
+  }
+};
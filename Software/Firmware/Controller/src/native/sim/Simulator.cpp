@@ -0,0 +1,311 @@
+// Simulator.cpp
+
+// runs the complete controller on the host in virtual time,
+// keys come from a script through the keyboard UART, the display
+// is decoded from the shift register pins, GPS is a virtual u-blox module
+// build with: pio run -e native_sim
+//
+// .pio/build/native_sim/program [options] script
+//   --start "2023-06-01 12:00:00"  UTC at power on
+//   --gps                          GPS mode on, the module is connected
+//   --clock                        start in clock mode
+//   --set <id>=<value>             presets a setting by its setting_id
+//   --rtc-drift <ppm>              the RTC runs fast (or slow if negative)
+//   --rtc-offset <ms>              the RTC is ahead (or behind if negative)
+//   --gps-record <file>            writes the NAV-TIMEUTC messages of the module
+//   --gps-replay <file>            the module sends a recording instead
+//   --no-sqw                       the square wave of the RTC is not wired
+//   --trace                        prints every change of the display
+//
+// values for check in the script:
+//   offset         ms, the RTC ahead of GPS time
+//   drift-error    ppm, the RTC drift estimated by the firmware
+//                  minus the simulated one
+//   aging-error    the aging offset of the RTC minus the one that
+//                  trims the simulated drift, in 0.1 ppm
+//   alarms         alarms and snoozes that went off
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <Arduino.h>
+#include <HostRuntime.h>
+#include <Preferences.h>
+#include <DS3232RTC.h>
+#include <Controller.h>
+#include <chrono>
+#include "VirtualDisplay.h"
+#include "VirtualGPS.h"
+#include "KeyScript.h"
+
+#define SIM_DEFAULT_START "2023-06-01 12:00:00"
+
+typedef DisplayHALSelector<DISPLAY_TYPE>::HAL SimulatorHAL;
+
+static const char *getDisplayText(void *obj)
+{
+  return (((VirtualDisplay<SimulatorHAL> *)obj)->getText());
+}
+
+typedef struct
+{
+  Controller *controller;
+  VirtualGPS *gps;
+} SIM_PROBE;
+
+static bool getProbeValue(void *obj, const String &name, double *value)
+{
+  SIM_PROBE *probe = (SIM_PROBE *)obj;
+  TimeDiscipline *discipline = probe->controller->getTimeDiscipline();
+
+  if (name == "offset")
+  {
+    *value = (DS3232RTC::getExactTime() - probe->gps->getExactUTC()) * 1000;
+    return (probe->gps->getMessagesSent() > 0);
+  }
+  if (name == "drift-error")
+  {
+    *value = discipline->getRTCDrift() - DS3232RTC::getDrift();
+    return (discipline->isDriftValid());
+  }
+  if (name == "alarms")
+  {
+    *value = probe->controller->getAlarmScheduler()->getFired();
+    return (true);
+  }
+  if (name == "aging-error")
+  {
+    *value = DS3232RTC::getAging() - DS3232RTC::getDrift() / DS3232_AGING_PPM;
+    return (true);
+  }
+  return (false);
+}
+
+static bool parseTime(const char *s, time_t *utc)
+{
+  int yr, mo, dy, hr, mi, se;
+  if (sscanf(s, "%d-%d-%d %d:%d:%d", &yr, &mo, &dy, &hr, &mi, &se) != 6)
+  {
+    return (false);
+  }
+  tmElements_t tm;
+  tm.Year = CalendarYrToTm(yr);
+  tm.Month = mo;
+  tm.Day = dy;
+  tm.Hour = hr;
+  tm.Minute = mi;
+  tm.Second = se;
+  *utc = makeTime(tm);
+  return (true);
+}
+
+// settings are read from NVS by Controller::begin
+static void presetSetting(int id, int value)
+{
+  Preferences preferences;
+  preferences.begin(SETTINGS_NAMESPACE, false);
+  preferences.putInt(String(id).c_str(), value);
+  preferences.end();
+}
+
+static void usage()
+{
+  Serial.printf("usage: simulator [--start \"YYYY-MM-DD hh:mm:ss\"] [--gps] [--clock] "
+                "[--set id=value] [--rtc-drift ppm] [--rtc-offset ms] [--gps-record file] "
+                "[--gps-replay file] [--no-sqw] [--trace] script\r\n");
+}
+
+int main(int argc, char *argv[])
+{
+  const char *scriptName = nullptr;
+  time_t utc = 0;
+  bool trace = false;
+  bool gps = false;
+  bool squareWave = true;
+  double drift = 0;
+  double rtcOffset = 0;
+  const char *recordName = nullptr;
+  const char *replayName = nullptr;
+
+  parseTime(SIM_DEFAULT_START, &utc);
+  for (int i = 1; i < argc; i++)
+  {
+    String arg(argv[i]);
+    bool hasValue = (i + 1 < argc);
+    if ((arg == "--start") && hasValue)
+    {
+      if (!parseTime(argv[++i], &utc))
+      {
+        usage();
+        return (2);
+      }
+    }
+    else if (arg == "--gps")
+    {
+      gps = true;
+      presetSetting(setting_id::gpsmode, gps_mode::on);
+    }
+    else if (arg == "--clock")
+    {
+      presetSetting(setting_id::startupmode, startup_mode::clock);
+    }
+    else if ((arg == "--set") && hasValue)
+    {
+      int id, value;
+      if (sscanf(argv[++i], "%d=%d", &id, &value) != 2)
+      {
+        usage();
+        return (2);
+      }
+      presetSetting(id, value);
+    }
+    else if ((arg == "--rtc-offset") && hasValue)
+    {
+      rtcOffset = atof(argv[++i]);
+    }
+    else if ((arg == "--gps-record") && hasValue)
+    {
+      recordName = argv[++i];
+    }
+    else if ((arg == "--gps-replay") && hasValue)
+    {
+      replayName = argv[++i];
+    }
+    else if ((arg == "--rtc-drift") && hasValue)
+    {
+      drift = atof(argv[++i]);
+    }
+    else if (arg == "--no-sqw")
+    {
+      squareWave = false;
+    }
+    else if (arg == "--trace")
+    {
+      trace = true;
+    }
+    else if (!arg.startsWith("--") && !scriptName)
+    {
+      scriptName = argv[i];
+    }
+    else
+    {
+      usage();
+      return (2);
+    }
+  }
+  if (!scriptName)
+  {
+    usage();
+    return (2);
+  }
+
+  FILE *file = fopen(scriptName, "r");
+  if (!file)
+  {
+    Serial.printf("can't open %s\r\n", scriptName);
+    return (2);
+  }
+  KeyScript script(KEYBOARD_UART);
+  String error;
+  bool loaded = script.load(file, &error);
+  fclose(file);
+  if (!loaded)
+  {
+    Serial.printf("%s: %s\r\n", scriptName, error.c_str());
+    return (2);
+  }
+
+  // everything below runs in virtual time
+  HostRuntime::setVirtualTime(true);
+  DS3232RTC::set(utc);
+  DS3232RTC::setDrift(drift);
+  DS3232RTC::shift((int64_t)(rtcOffset * 1000));
+  if (squareWave)
+  {
+    DS3232RTC::setSquareWavePin(PIN_RTCSQW);
+  }
+
+  VirtualDisplay<SimulatorHAL> display(PIN_DATA, PIN_SHIFT, PIN_STORE, PIN_BLANK);
+  display.begin();
+
+  Controller *controller = new Controller();
+  VirtualGPS virtualGPS(GPS_UART);
+  FILE *recordFile = nullptr;
+  if (recordName)
+  {
+    recordFile = fopen(recordName, "w");
+    if (!recordFile)
+    {
+      Serial.printf("can't create %s\r\n", recordName);
+      return (2);
+    }
+    fprintf(recordFile, "# host time in us, NAV-TIMEUTC message\n");
+    virtualGPS.record(recordFile);
+  }
+  if (replayName)
+  {
+    FILE *replayFile = fopen(replayName, "r");
+    bool loaded = replayFile && virtualGPS.replay(replayFile);
+    if (replayFile)
+    {
+      fclose(replayFile);
+    }
+    if (!loaded)
+    {
+      Serial.printf("can't replay %s\r\n", replayName);
+      return (2);
+    }
+  }
+  virtualGPS.begin(utc);
+
+  auto wallStart = std::chrono::steady_clock::now();
+  if (controller->begin() != ERR_SUCCESS)
+  {
+    Serial.printf("controller didn't start\r\n");
+    return (1);
+  }
+  script.attachDisplay(&display, getDisplayText);
+  SIM_PROBE probe = {controller, &virtualGPS};
+  script.attachProbe(&probe, getProbeValue);
+  script.begin();
+
+  uint64_t loops = 0;
+  uint32_t changes = display.getChanges();
+  while (!script.isDone())
+  {
+    controller->process();
+    // stamped before the wait, with the time the frame was rendered
+    if (trace && (display.getChanges() != changes))
+    {
+      changes = display.getChanges();
+      uint64_t time = HostRuntime::getTime();
+      Serial.printf("%6llu.%06llu \"%s\"\r\n", (unsigned long long)(time / 1000000),
+                    (unsigned long long)(time % 1000000), display.getText());
+    }
+    controller->waitForEvents();
+    loops++;
+  }
+
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  double simulated = HostRuntime::getTime() / 1e6;
+  Serial.printf("simulated %.1f s in %.3f s wall time (%.0fx)\r\n", simulated, wall, simulated / wall);
+  Serial.printf("keys: %u keystrokes, %.0f keys/s\r\n", script.getKeystrokes(), script.getKeystrokes() / wall);
+  Serial.printf("loop: %llu wakeups, %.0f wakeups/s, %u in the last simulated second\r\n",
+                (unsigned long long)loops, loops / wall, Events::getWakeupsPerSecond());
+  Serial.printf("display: %u frames latched, %u changes, %u invalid\r\n",
+                display.getFrames(), display.getChanges(), display.getErrors());
+  Serial.printf("animation: %lu us max frame latency\r\n", controller->getDisplayHandler()->getMaxAnimationLatency());
+  Serial.printf("rtc: %u i2c transactions\r\n", DS3232RTC::getTransactions());
+  if (gps)
+  {
+    double offset = DS3232RTC::getExactTime() - virtualGPS.getExactUTC();
+    Serial.printf("gps: %u messages sent, rtc %+.6f s from gps time, aging offset %d\r\n",
+                  virtualGPS.getMessagesSent(), offset, DS3232RTC::getAging());
+  }
+  if (recordFile)
+  {
+    fclose(recordFile);
+  }
+  Serial.printf("script: %u checks, %u failed\r\n", script.getChecks(), script.getFailures());
+  return ((script.getFailures() || display.getErrors()) ? 1 : 0);
+}
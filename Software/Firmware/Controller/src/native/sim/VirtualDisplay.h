@@ -0,0 +1,224 @@
+// VirtualDisplay.h
+
+// the shift registers of the display board on the GPIOs of the simulator,
+// latched frames are decoded back to digits, decimal points and signs
+// through the translation table of the HAL
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <HostRuntime.h>
+#include <DisplayDriver.h>
+
+// sign, digits with their decimal points, menu sign
+#define VIRTUAL_DISPLAY_TEXT_SIZE (2 * REGISTER_COUNT + 4)
+
+template <class HAL>
+class VirtualDisplay
+{
+public:
+  VirtualDisplay(uint8_t dataPin, uint8_t shiftPin, uint8_t storePin, uint8_t blankPin)
+      : _dataPin(dataPin),
+        _shiftPin(shiftPin),
+        _storePin(storePin),
+        _blankPin(blankPin)
+  {
+    _data = LOW;
+    _shiftLevel = SHIFT_COMMIT;
+    _storeLevel = STORE_COMMIT;
+    _head = 0;
+    _frames = 0;
+    _changes = 0;
+    _errors = 0;
+    memset(_shiftStage, 0, sizeof(_shiftStage));
+    memset(_storage, 0, sizeof(_storage));
+    _text[0] = '\0';
+  }
+
+  void begin()
+  {
+    HostRuntime::attachPins(this, onPinCallback);
+  }
+
+  // what the tubes show, unlit digits are spaces
+  const char *getText()
+  {
+    return (_text);
+  }
+
+  // the text without the unlit digits around it
+  String getTrimmedText()
+  {
+    String s(_text);
+    s.trim();
+    return (s);
+  }
+
+  // latched frames, frames that changed the text, invalid frames
+  uint32_t getFrames()
+  {
+    return (_frames);
+  }
+
+  uint32_t getChanges()
+  {
+    return (_changes);
+  }
+
+  uint32_t getErrors()
+  {
+    return (_errors);
+  }
+
+  static void onPinCallback(void *obj, uint8_t pin, uint8_t value)
+  {
+    ((VirtualDisplay *)obj)->onPin(pin, value);
+  }
+
+private:
+  uint8_t _dataPin;
+  uint8_t _shiftPin;
+  uint8_t _storePin;
+  uint8_t _blankPin;
+  uint8_t _data;
+  uint8_t _shiftLevel;
+  uint8_t _storeLevel;
+  // the shift stage is a ring, _head is register 1
+  uint8_t _shiftStage[REGISTER_COUNT];
+  uint8_t _head;
+  // the storage stage, index 0 is register 1
+  uint8_t _storage[REGISTER_COUNT];
+  char _text[VIRTUAL_DISPLAY_TEXT_SIZE];
+  uint32_t _frames;
+  uint32_t _changes;
+  uint32_t _errors;
+
+  void onPin(uint8_t pin, uint8_t value)
+  {
+    if (pin == _dataPin)
+    {
+      _data = value;
+    }
+    else if (pin == _shiftPin)
+    {
+      if ((_shiftLevel == SHIFT_BEGIN) && (value == SHIFT_COMMIT))
+      {
+        shift();
+      }
+      _shiftLevel = value;
+    }
+    else if (pin == _storePin)
+    {
+      if ((_storeLevel == STORE_BEGIN) && (value == STORE_COMMIT))
+      {
+        latch();
+      }
+      _storeLevel = value;
+    }
+    else if ((pin == _blankPin) && (value == LOW))
+    {
+      // master reset clears the shift stage only
+      memset(_shiftStage, 0, sizeof(_shiftStage));
+    }
+  }
+
+  // every register takes the bit of its neighbour, register 1 the data pin
+  void shift()
+  {
+    _head = (_head == 0) ? REGISTER_COUNT - 1 : _head - 1;
+    _shiftStage[_head] = _data;
+  }
+
+  void latch()
+  {
+    for (uint8_t i = 0; i < REGISTER_COUNT; i++)
+    {
+      _storage[i] = _shiftStage[(_head + i) % REGISTER_COUNT];
+    }
+    _frames++;
+
+    char text[VIRTUAL_DISPLAY_TEXT_SIZE];
+    decode(text);
+    if (strcmp(text, _text) != 0)
+    {
+      strcpy(_text, text);
+      _changes++;
+    }
+  }
+
+  void decode(char *text)
+  {
+    char digits[HAL::digitCount];
+    bool decimalPoints[HAL::decimalPointCount] = {};
+    bool minusSign = false;
+    bool plusSign = false;
+    bool menuSign = false;
+    bool valid = true;
+
+    memset(digits, ' ', sizeof(digits));
+    for (uint8_t i = 0; i < REGISTER_COUNT; i++)
+    {
+      if (!_storage[i])
+      {
+        continue;
+      }
+      const TRANSLATION_TABLE_ENTRY &entry = HAL::translationTable.entries[i];
+      switch (entry.rt)
+      {
+      case register_type::number:
+        // two lit cathodes in one tube is a bug
+        if (digits[entry.digit] != ' ')
+        {
+          valid = false;
+        }
+        digits[entry.digit] = '0' + entry.number;
+        break;
+
+      case register_type::decimal_point:
+        decimalPoints[entry.digit] = true;
+        break;
+
+      case register_type::minus_sign:
+        minusSign = true;
+        break;
+
+      case register_type::plus_sign:
+        plusSign = true;
+        break;
+
+      case register_type::menu_sign:
+        menuSign = true;
+        break;
+
+      default:
+        // the register drives nothing
+        valid = false;
+        break;
+      }
+    }
+    if (!valid)
+    {
+      _errors++;
+    }
+
+    uint16_t length = 0;
+    text[length++] = minusSign ? '-' : (plusSign ? '+' : ' ');
+    for (uint8_t i = 0; i < HAL::digitCount; i++)
+    {
+      text[length++] = digits[i];
+      if ((i < HAL::decimalPointCount) && decimalPoints[i])
+      {
+        text[length++] = '.';
+      }
+    }
+    if (menuSign)
+    {
+      text[length++] = ' ';
+      text[length++] = 'M';
+    }
+    text[length] = '\0';
+  }
+};
@@ -0,0 +1,326 @@
+// VirtualGPS.h
+
+// a u-blox module on the GPS UART of the simulator, it answers the
+// version poll, acknowledges the message rates and sends
+// NAV-TIMEUTC of the simulated UTC at the subscribed rate,
+// each message describes the epoch at the start of a GPS second and
+// arrives after the output delay with some jitter and the transfer time,
+// the messages can be recorded and a recording replayed instead,
+// one line per message, the host time in us and the bytes in hex
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <HostRuntime.h>
+#include <TimeLib.h>
+#include <ubGPSTime.h>
+#include <vector>
+
+#define VIRTUAL_GPS_SW_VERSION "ROM CORE 3.01 (107888)"
+#define VIRTUAL_GPS_HW_VERSION "00080000"
+#define VIRTUAL_GPS_TIMEUTC_LENGTH 20
+#define VIRTUAL_GPS_MONVER_LENGTH 40
+#define VIRTUAL_GPS_OUTPUT_DELAY 50000 // us after the epoch
+#define VIRTUAL_GPS_JITTER 10000       // us, up to this much earlier or later
+#define VIRTUAL_GPS_ACCURACY 30        // ns
+#define VIRTUAL_GPS_SEED 0x47505321
+
+typedef struct
+{
+  uint64_t time;
+  std::vector<uint8_t> message;
+} VIRTUAL_GPS_MESSAGE;
+
+class VirtualGPS
+{
+public:
+  VirtualGPS(int uart) : _uart(uart)
+  {
+    _port = nullptr;
+    _utc = 0;
+    _utcMicros = 0;
+    _timeUTCRate = 0;
+    _timeUTCEvent = 0;
+    _timeUTCEpoch = 0;
+    _random = VIRTUAL_GPS_SEED;
+    _record = nullptr;
+    _fieldCounter = 0;
+    _payloadLength = 0;
+    _messagesSent = 0;
+  }
+
+  // the firmware must have created the port
+  bool begin(time_t utc)
+  {
+    _utc = utc;
+    _utcMicros = HostRuntime::getTime();
+    _port = HardwareSerial::getPort(_uart);
+    if (_port)
+    {
+      _port->attachTransmit(this, onTransmitCallback);
+    }
+    for (VIRTUAL_GPS_MESSAGE &message : _replay)
+    {
+      HostRuntime::schedule(message.time, [this, &message]()
+                            { receive(message.message.data(), message.message.size()); });
+    }
+    return (_port != nullptr);
+  }
+
+  // NAV-TIMEUTC messages sent from now on go to the file too
+  void record(FILE *file)
+  {
+    _record = file;
+  }
+
+  // the module sends the messages of a recording instead of its own
+  // NAV-TIMEUTC messages, call it before begin()
+  bool replay(FILE *file)
+  {
+    char line[256];
+    while (fgets(line, sizeof(line), file))
+    {
+      unsigned long long time;
+      int length;
+      if ((line[0] == '#') || (sscanf(line, "%llu%n", &time, &length) != 1))
+      {
+        continue;
+      }
+      VIRTUAL_GPS_MESSAGE message;
+      message.time = time;
+      unsigned int value;
+      int used;
+      for (char *p = line + length; sscanf(p, "%2x%n", &value, &used) == 1; p += used)
+      {
+        message.message.push_back((uint8_t)value);
+      }
+      if (message.message.size() < 8)
+      {
+        return (false);
+      }
+      _replay.push_back(message);
+    }
+    return (!_replay.empty());
+  }
+
+  // the time the satellites tell
+  time_t getUTC()
+  {
+    return (_utc + (time_t)((HostRuntime::getTime() - _utcMicros) / 1000000));
+  }
+
+  double getExactUTC()
+  {
+    return ((double)_utc + (double)(HostRuntime::getTime() - _utcMicros) / 1e6);
+  }
+
+  uint32_t getMessagesSent()
+  {
+    return (_messagesSent);
+  }
+
+  static void onTransmitCallback(void *obj, uint8_t c)
+  {
+    ((VirtualGPS *)obj)->onTransmit(c);
+  }
+
+private:
+  int _uart;
+  HardwareSerial *_port;
+  time_t _utc;
+  uint64_t _utcMicros;
+  uint8_t _timeUTCRate;
+  uint64_t _timeUTCEvent;
+  // seconds since begin() of the next message
+  uint64_t _timeUTCEpoch;
+  uint32_t _random;
+  FILE *_record;
+  std::vector<VIRTUAL_GPS_MESSAGE> _replay;
+  // incoming message
+  uint16_t _fieldCounter;
+  uint8_t _msgClass;
+  uint8_t _msgID;
+  uint16_t _payloadLength;
+  uint8_t _payload[MAX_PAYLOAD];
+  uint32_t _messagesSent;
+
+  // the firmware sends UBX messages only
+  void onTransmit(uint8_t c)
+  {
+    switch (_fieldCounter)
+    {
+    case 0:
+      _fieldCounter = (c == UBX_HEADER1) ? 1 : 0;
+      break;
+
+    case 1:
+      _fieldCounter = (c == UBX_HEADER2) ? 2 : 0;
+      break;
+
+    case 2:
+      _msgClass = c;
+      _fieldCounter++;
+      break;
+
+    case 3:
+      _msgID = c;
+      _fieldCounter++;
+      break;
+
+    case 4:
+      _payloadLength = c;
+      _fieldCounter++;
+      break;
+
+    case 5:
+      _payloadLength |= (uint16_t)c << 8;
+      _fieldCounter = (_payloadLength <= MAX_PAYLOAD) ? 6 : 0;
+      break;
+
+    default:
+      if (_fieldCounter < 6 + _payloadLength)
+      {
+        _payload[_fieldCounter - 6] = c;
+        _fieldCounter++;
+      }
+      else if (_fieldCounter == 6 + _payloadLength)
+      {
+        // CK_A, the module would drop broken messages, the firmware's are fine
+        _fieldCounter++;
+      }
+      else
+      {
+        _fieldCounter = 0;
+        onMessage();
+      }
+      break;
+    }
+  }
+
+  void onMessage()
+  {
+    if ((_msgClass == UBX_MON) && (_msgID == UBX_MON_VER) && (_payloadLength == 0))
+    {
+      uint8_t payload[VIRTUAL_GPS_MONVER_LENGTH] = {};
+      strncpy((char *)payload, VIRTUAL_GPS_SW_VERSION, 30);
+      strncpy((char *)payload + 30, VIRTUAL_GPS_HW_VERSION, 10);
+      send(UBX_MON, UBX_MON_VER, payload, sizeof(payload));
+    }
+    else if ((_msgClass == UBX_CFG) && (_msgID == UBX_CFG_MSG) && (_payloadLength >= 3))
+    {
+      if ((_payload[0] == UBX_NAV) && (_payload[1] == UBX_NAV_TIMEUTC))
+      {
+        setTimeUTCRate(_payload[2]);
+      }
+      uint8_t payload[2] = {UBX_CFG, UBX_CFG_MSG};
+      send(UBX_ACK, UBX_ACK_ACK, payload, sizeof(payload));
+    }
+  }
+
+  // rate in seconds, 0 stops the messages
+  void setTimeUTCRate(uint8_t rate)
+  {
+    if (_timeUTCEvent)
+    {
+      HostRuntime::cancel(_timeUTCEvent);
+      _timeUTCEvent = 0;
+    }
+    _timeUTCRate = rate;
+    scheduleTimeUTC();
+  }
+
+  // at the output delay after the epoch the rate seconds ahead
+  void scheduleTimeUTC()
+  {
+    if (_timeUTCRate && _replay.empty())
+    {
+      _timeUTCEpoch = (HostRuntime::getTime() - _utcMicros) / 1000000 + _timeUTCRate;
+      uint64_t transfer = (8 + VIRTUAL_GPS_TIMEUTC_LENGTH) * 10 * 1000000ULL / _port->getBaudRate();
+      int64_t jitter = (int64_t)(nextRandom() % (2 * VIRTUAL_GPS_JITTER + 1)) - VIRTUAL_GPS_JITTER;
+      uint64_t time = _utcMicros + _timeUTCEpoch * 1000000 + VIRTUAL_GPS_OUTPUT_DELAY + jitter + transfer;
+      _timeUTCEvent = HostRuntime::schedule(time, [this]()
+                                            {
+                                              _timeUTCEvent = 0;
+                                              sendTimeUTC();
+                                              scheduleTimeUTC(); });
+    }
+  }
+
+  // xorshift, the same jitter on every host
+  uint32_t nextRandom()
+  {
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return (_random);
+  }
+
+  void sendTimeUTC()
+  {
+    tmElements_t tm;
+    uint8_t payload[VIRTUAL_GPS_TIMEUTC_LENGTH] = {};
+    // the epoch is a few ns off the second
+    int32_t nanoSecond = (int32_t)(nextRandom() % 201) - 100;
+    uint32_t accuracy = VIRTUAL_GPS_ACCURACY;
+    memcpy(payload + 4, &accuracy, sizeof(accuracy));
+    memcpy(payload + 8, &nanoSecond, sizeof(nanoSecond));
+    breakTime(_utc + (time_t)_timeUTCEpoch, tm);
+    uint16_t year = tmYearToCalendar(tm.Year);
+    payload[12] = year & 0xFF;
+    payload[13] = year >> 8;
+    payload[14] = tm.Month;
+    payload[15] = tm.Day;
+    payload[16] = tm.Hour;
+    payload[17] = tm.Minute;
+    payload[18] = tm.Second;
+    // time of week, week number and UTC valid
+    payload[19] = 0x07;
+    send(UBX_NAV, UBX_NAV_TIMEUTC, payload, sizeof(payload));
+  }
+
+  // the whole message arrives at once
+  void send(uint8_t msgClass, uint8_t msgID, const uint8_t *payload, uint16_t length)
+  {
+    uint8_t message[8 + VIRTUAL_GPS_MONVER_LENGTH];
+    uint8_t ckA = 0;
+    uint8_t ckB = 0;
+
+    message[0] = UBX_HEADER1;
+    message[1] = UBX_HEADER2;
+    message[2] = msgClass;
+    message[3] = msgID;
+    message[4] = length & 0xFF;
+    message[5] = length >> 8;
+    memcpy(message + 6, payload, length);
+    for (uint16_t i = 2; i < 6 + length; i++)
+    {
+      ckA += message[i];
+      ckB += ckA;
+    }
+    message[6 + length] = ckA;
+    message[7 + length] = ckB;
+    if (_record && (msgClass == UBX_NAV))
+    {
+      fprintf(_record, "%llu ", (unsigned long long)HostRuntime::getTime());
+      for (uint16_t i = 0; i < 8 + length; i++)
+      {
+        fprintf(_record, "%02x", message[i]);
+      }
+      fprintf(_record, "\n");
+    }
+    receive(message, 8 + length);
+  }
+
+  void receive(const uint8_t *message, size_t length)
+  {
+    if (_port)
+    {
+      _port->receive(message, length);
+      _messagesSent++;
+    }
+  }
+};
@@ -0,0 +1,175 @@
+// TimeZoneCheck.cpp
+
+// compares TimeZoneCache with the uncached Timezone::toLocal(),
+// for a set of rules, every second around the changes and the new years,
+// every 61st second in between, --full compares every second,
+// the rules are switched on the same cache to check the invalidation
+// run with: pio run -e native_timezone -t exec
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <Arduino.h>
+#include <TimeLib.h>
+#include <Timezone.h>
+#include <TimeZoneCache.h>
+#include <chrono>
+#include <string>
+
+#define CHECK_FIRST_YEAR 1971
+#define CHECK_LAST_YEAR 2099
+#define CHECK_STRIDE 61
+// seconds checked one by one before and after every change
+#define CHECK_WINDOW (3 * SECS_PER_HOUR)
+#define BENCHMARK_SECONDS (30 * SECS_PER_DAY)
+
+typedef struct
+{
+  const char *name;
+  TimeChangeRule dstRule;
+  TimeChangeRule stdRule;
+} ZONE_RULES;
+
+static const ZONE_RULES zones[] = {
+    {"central europe", {"DST", Last, Sun, Mar, 2, 120}, {"STD", Last, Sun, Oct, 3, 60}},
+    {"us eastern", {"DST", Second, Sun, Mar, 2, -240}, {"STD", First, Sun, Nov, 2, -300}},
+    {"australia eastern", {"DST", First, Sun, Oct, 2, 660}, {"STD", First, Sun, Apr, 3, 600}},
+    {"new zealand", {"DST", Last, Sun, Sep, 2, 780}, {"STD", First, Sun, Apr, 3, 720}},
+    {"india, no dst", {"DST", Last, Sun, Mar, 2, 330}, {"STD", Last, Sun, Oct, 3, 330}},
+    {"changes at new year", {"DST", Last, Sat, Dec, 23, 60}, {"STD", First, Sun, Jan, 1, 0}},
+};
+
+#define ZONE_COUNT (sizeof(zones) / sizeof(zones[0]))
+
+static time_t getYearStart(int yr)
+{
+  tmElements_t tm;
+  tm.Second = 0;
+  tm.Minute = 0;
+  tm.Hour = 0;
+  tm.Day = 1;
+  tm.Month = 1;
+  tm.Year = CalendarYrToTm(yr);
+  return (makeTime(tm));
+}
+
+// every step-th second of [from, until), returns the number of mismatches
+static uint64_t checkRange(Timezone *timeZone, TimeZoneCache *cache, time_t from, time_t until,
+                           time_t step, uint64_t *checked)
+{
+  uint64_t mismatches = 0;
+  for (time_t utc = from; utc < until; utc += step)
+  {
+    time_t expected = timeZone->toLocal(utc);
+    time_t local = cache->toLocal(utc);
+    if (local != expected)
+    {
+      if (mismatches < 5)
+      {
+        Serial.printf("  mismatch at %lld: %lld instead of %lld\r\n",
+                      (long long)utc, (long long)local, (long long)expected);
+      }
+      mismatches++;
+    }
+    (*checked)++;
+  }
+  return (mismatches);
+}
+
+// the places where the offset can change, found by the uncached path
+static uint64_t checkChanges(Timezone *timeZone, TimeZoneCache *cache, time_t from, time_t until,
+                             uint64_t *checked)
+{
+  uint64_t mismatches = 0;
+  time_t hour = from;
+  time_t offset = timeZone->toLocal(hour) - hour;
+  for (hour = from + SECS_PER_HOUR; hour < until; hour += SECS_PER_HOUR)
+  {
+    time_t next = timeZone->toLocal(hour) - hour;
+    if (next != offset)
+    {
+      mismatches += checkRange(timeZone, cache, hour - CHECK_WINDOW, hour + CHECK_WINDOW, 1, checked);
+      offset = next;
+    }
+  }
+  for (int yr = CHECK_FIRST_YEAR + 1; yr <= CHECK_LAST_YEAR; yr++)
+  {
+    time_t start = getYearStart(yr);
+    mismatches += checkRange(timeZone, cache, start - CHECK_WINDOW, start + CHECK_WINDOW, 1, checked);
+  }
+  return (mismatches);
+}
+
+// ns per conversion of consecutive seconds, like the clock asks
+static double benchmark(Timezone *timeZone, TimeZoneCache *cache, bool cached, time_t from)
+{
+  volatile time_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (time_t utc = from; utc < from + BENCHMARK_SECONDS; utc++)
+  {
+    sink = sink + (cached ? cache->toLocal(utc) : timeZone->toLocal(utc));
+  }
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return (elapsed * 1e9 / BENCHMARK_SECONDS);
+}
+
+int main(int argc, char **argv)
+{
+  bool full = false;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--full")
+    {
+      full = true;
+    }
+    else
+    {
+      Serial.printf("usage: %s [--full]\r\n", argv[0]);
+      return (1);
+    }
+  }
+
+  time_t from = getYearStart(CHECK_FIRST_YEAR);
+  time_t until = getYearStart(CHECK_LAST_YEAR + 1);
+  Timezone timeZone(zones[0].dstRule, zones[0].stdRule);
+  TimeZoneCache cache;
+  uint64_t failed = 0;
+
+  Serial.printf("%d to %d, %s\r\n", CHECK_FIRST_YEAR, CHECK_LAST_YEAR,
+                full ? "every second" : "every second near the changes, every 61st in between");
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    // the same objects for all zones, like Clock::setTimeZone()
+    timeZone.setRules(zones[i].dstRule, zones[i].stdRule);
+    cache.setTimeZone(&timeZone, zones[i].dstRule, zones[i].stdRule);
+    uint64_t checked = 0;
+    uint64_t mismatches = checkRange(&timeZone, &cache, from, until, full ? 1 : CHECK_STRIDE, &checked);
+    if (!full)
+    {
+      mismatches += checkChanges(&timeZone, &cache, from, until, &checked);
+    }
+    // backwards, every conversion leaves the cached interval
+    for (time_t utc = until - 1; utc >= from; utc -= 7 * SECS_PER_DAY + 1)
+    {
+      checked++;
+      if (cache.toLocal(utc) != timeZone.toLocal(utc))
+      {
+        mismatches++;
+      }
+    }
+    Serial.printf("%-20s %12llu checked, %llu mismatches\r\n", zones[i].name,
+                  (unsigned long long)checked, (unsigned long long)mismatches);
+    failed += mismatches;
+  }
+
+  timeZone.setRules(zones[0].dstRule, zones[0].stdRule);
+  cache.setTimeZone(&timeZone, zones[0].dstRule, zones[0].stdRule);
+  time_t benchmarkStart = getYearStart(2023) + 80 * SECS_PER_DAY;
+  Serial.printf("toLocal, %d days of seconds: %.1f ns uncached, %.1f ns cached\r\n",
+                (int)(BENCHMARK_SECONDS / SECS_PER_DAY),
+                benchmark(&timeZone, &cache, false, benchmarkStart),
+                benchmark(&timeZone, &cache, true, benchmarkStart));
+
+  return ((failed == 0) ? 0 : 1);
+}
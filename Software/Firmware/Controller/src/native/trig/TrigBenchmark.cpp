@@ -0,0 +1,257 @@
+// TrigBenchmark.cpp
+
+// accuracy report and benchmark of the degree mode trigonometric
+// functions, CalcTrig against the previous libm path sin(x * PI / 180),
+// both compared with a long double reference after an exact reduction,
+// counted are the angles where the display differs from the reference
+// run with: pio run -e native_trig -t exec
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <Arduino.h>
+#include <NixieCalc.h>
+#include <CalcTrig.h>
+#include <NumberFormatter.h>
+#include <vector>
+#include <string>
+
+#define TRIG_DIGITS 14
+#define TRIG_RANDOM_ANGLES 200000
+#define TRIG_BENCHMARK_ROUNDS 5
+#define TRIG_SEED 0x54524947
+
+static const char *functionNames[] = {"sin", "cos", "tan"};
+
+typedef struct
+{
+  const char *name;
+  uint32_t angles;
+  uint32_t kernelMismatches;
+  uint32_t libmMismatches;
+  long double kernelMaxError;
+  long double libmMaxError;
+} TRIG_REPORT;
+
+// xorshift, the same sequence on every host
+static uint32_t nextRandom(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return (*state);
+}
+
+// the angle as typed, exactly reduced to [0, 360) on 128-bit integers
+static long double referenceReduce(const char *angle, bool *negative)
+{
+  unsigned __int128 value = 0;
+  unsigned __int128 scale = 1;
+  bool fraction = false;
+
+  *negative = (*angle == '-');
+  for (const char *p = angle; *p; p++)
+  {
+    if (*p == '.')
+    {
+      fraction = true;
+    }
+    else if ((*p >= '0') && (*p <= '9'))
+    {
+      value = value * 10 + (*p - '0');
+      if (fraction)
+      {
+        scale *= 10;
+      }
+    }
+  }
+  return ((long double)(value % (360 * scale)) / (long double)scale);
+}
+
+// folded to 0..45 degrees like CalcTrig, the long double pi
+// would otherwise give sin(180) = 5e-20
+static long double reference(trig_function function, const char *angle)
+{
+  bool negative;
+  long double reduced = referenceReduce(angle, &negative);
+  int quadrant = (int)(reduced / 90.0L);
+  long double rest = reduced - 90.0L * quadrant;
+  const long double radians = 3.14159265358979323846264338327950288L / 180.0L;
+  long double s = (rest <= 45.0L) ? sinl(rest * radians) : cosl((90.0L - rest) * radians);
+  long double c = (rest <= 45.0L) ? cosl(rest * radians) : sinl((90.0L - rest) * radians);
+  long double sinValue = (quadrant == 0) ? s : ((quadrant == 1) ? c : ((quadrant == 2) ? -s : -c));
+  long double cosValue = (quadrant == 0) ? c : ((quadrant == 1) ? -s : ((quadrant == 2) ? -c : s));
+  long double result = 0.0L;
+
+  if (negative)
+  {
+    sinValue = -sinValue;
+  }
+  switch (function)
+  {
+  case trig_function::sin:
+    result = sinValue;
+    break;
+
+  case trig_function::cos:
+    result = cosValue;
+    break;
+
+  case trig_function::tan:
+    result = sinValue / cosValue;
+    break;
+  }
+  return (result);
+}
+
+// the previous implementation in NixieCalc::calculateValue
+static double libm(trig_function function, double angle)
+{
+  switch (function)
+  {
+  case trig_function::sin:
+    return (sin(angle * PI / 180.0));
+
+  case trig_function::cos:
+    return (cos(angle * PI / 180.0));
+
+  default:
+    return (tan(angle * PI / 180.0));
+  }
+}
+
+static std::string display(const DecimalNumber &value)
+{
+  char buffer[32];
+  NumberFormatter::format(value, TRIG_DIGITS, buffer, sizeof(buffer));
+  return (buffer);
+}
+
+static std::string display(long double value)
+{
+  char buffer[40];
+  snprintf(buffer, sizeof(buffer), "%.20Le", value);
+  return (display(DecimalNumber::fromString(buffer)));
+}
+
+// angles where tan is undefined are left out, the reference has no pole
+static void check(TRIG_REPORT *report, const std::vector<std::string> &angles, trig_function function)
+{
+  for (const auto &angle : angles)
+  {
+    DecimalNumber value = DecimalNumber::fromString(angle.c_str());
+    DecimalNumber kernel;
+    if (!CalcTrig::degrees(function, value, &kernel))
+    {
+      continue;
+    }
+    long double exact = reference(function, angle.c_str());
+    DecimalNumber previous = DecimalNumber(libm(function, value.toDouble()));
+    std::string expected = display(exact);
+    report->angles++;
+    if (display(kernel) != expected)
+    {
+      report->kernelMismatches++;
+    }
+    if (display(previous) != expected)
+    {
+      report->libmMismatches++;
+    }
+    long double kernelError = fabsl((long double)kernel.toDouble() - exact);
+    long double libmError = fabsl((long double)previous.toDouble() - exact);
+    report->kernelMaxError = (kernelError > report->kernelMaxError) ? kernelError : report->kernelMaxError;
+    report->libmMaxError = (libmError > report->libmMaxError) ? libmError : report->libmMaxError;
+  }
+}
+
+static void print(const TRIG_REPORT *report)
+{
+  Serial.printf("%-18s %7u %10u %10.2Le %10u %10.2Le\r\n", report->name, report->angles,
+                report->kernelMismatches, report->kernelMaxError, report->libmMismatches, report->libmMaxError);
+}
+
+int main()
+{
+  std::vector<std::string> exactAngles;
+  std::vector<std::string> integerAngles;
+  std::vector<std::string> randomAngles;
+  std::vector<std::string> largeAngles;
+  uint32_t state = TRIG_SEED;
+  char buffer[32];
+
+  // multiples of 15 degrees, the table covers 30 and 45
+  for (int i = -1440; i <= 1440; i += 15)
+  {
+    exactAngles.push_back(std::to_string(i));
+  }
+  for (int i = -3600; i <= 3600; i++)
+  {
+    integerAngles.push_back(std::to_string(i));
+  }
+  for (uint32_t i = 0; i < TRIG_RANDOM_ANGLES; i++)
+  {
+    // up to 3 integer digits and 11 decimals, the full display width
+    uint64_t value = ((uint64_t)nextRandom(&state) << 32 | nextRandom(&state)) % 100000000000000ULL;
+    snprintf(buffer, sizeof(buffer), "%s%llu.%011llu", (nextRandom(&state) & 1) ? "-" : "",
+             (unsigned long long)(value / 100000000000ULL), (unsigned long long)(value % 100000000000ULL));
+    randomAngles.push_back(buffer);
+    // 14 digits beyond 1e6 degrees, where x * PI / 180 loses the fraction
+    snprintf(buffer, sizeof(buffer), "%llu.%06llu", (unsigned long long)(value / 1000000ULL),
+             (unsigned long long)(value % 1000000ULL));
+    largeAngles.push_back(buffer);
+  }
+
+  Serial.printf("degree mode, %u display digits, mismatches of the display and max absolute error\r\n", TRIG_DIGITS);
+  Serial.printf("%-18s %7s %10s %10s %10s %10s\r\n", "angles", "count", "kernel", "error", "libm", "error");
+  for (uint8_t f = 0; f < 3; f++)
+  {
+    trig_function function = (trig_function)f;
+    const std::vector<std::string> *sets[] = {&exactAngles, &integerAngles, &randomAngles, &largeAngles};
+    const char *setNames[] = {"exact", "integer", "random", "large"};
+    for (uint8_t s = 0; s < 4; s++)
+    {
+      TRIG_REPORT report = {};
+      snprintf(buffer, sizeof(buffer), "%s %s", functionNames[f], setNames[s]);
+      report.name = buffer;
+      check(&report, *sets[s], function);
+      print(&report);
+    }
+  }
+
+  // speed on the random angles, the engine number type in and out
+  std::vector<DecimalNumber> values;
+  for (const auto &angle : randomAngles)
+  {
+    values.push_back(DecimalNumber::fromString(angle.c_str()));
+  }
+  Serial.printf("%-18s %12s %12s\r\n", "speed", "kernel", "libm");
+  for (uint8_t f = 0; f < 3; f++)
+  {
+    trig_function function = (trig_function)f;
+    DecimalNumber sum = 0;
+    unsigned long start = micros();
+    for (uint8_t round = 0; round < TRIG_BENCHMARK_ROUNDS; round++)
+    {
+      for (const auto &value : values)
+      {
+        DecimalNumber result;
+        CalcTrig::degrees(function, value, &result);
+        sum += result;
+      }
+    }
+    unsigned long kernelTime = micros() - start;
+    start = micros();
+    for (uint8_t round = 0; round < TRIG_BENCHMARK_ROUNDS; round++)
+    {
+      for (const auto &value : values)
+      {
+        sum += DecimalNumber(libm(function, value.toDouble()));
+      }
+    }
+    unsigned long libmTime = micros() - start;
+    uint32_t calls = TRIG_BENCHMARK_ROUNDS * values.size();
+    Serial.printf("%-18s %9.1f ns %9.1f ns (%g)\r\n", functionNames[f], kernelTime * 1000.0 / calls,
+                  libmTime * 1000.0 / calls, sum.toDouble());
+  }
+  return (0);
+}
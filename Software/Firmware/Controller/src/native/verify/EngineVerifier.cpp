@@ -0,0 +1,570 @@
+// EngineVerifier.cpp
+
+// differential verification of the calculator engine, every case is a
+// keystroke sequence fed to NixieCalc and to an exact reference model,
+// after every key the 14-digit display text and the error state
+// must be the same, the cases are edge cases first, then random
+// sequences with many numbers close to the limits, percent chains
+// and repeated equals
+// a case only depends on the seed and its number, so any mismatch
+// can be replayed alone with --case
+// the exit status is 0 without mismatches, 1 with any mismatch,
+// also for a replayed case, and 2 for unknown options, so a script
+// or a build step fails on it
+// run with: pio run -e native_verify -t exec
+// or with options: .pio/build/native_verify/program --cases 1000000000 --threads 16
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#include <Arduino.h>
+#include <NixieCalc.h>
+#include <NumberFormatter.h>
+#include "ReferenceCalc.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#define VERIFY_DIGITS 14
+#define VERIFY_DEFAULT_CASES 1000000ULL
+#define VERIFY_DEFAULT_SEED 0x4E495849ULL
+#define VERIFY_DEFAULT_LENGTH 24 // keys per random case
+#define VERIFY_DEFAULT_REPORT 20 // mismatches printed
+#define VERIFY_CHUNK 4096        // cases a worker takes at once
+#define VERIFY_MAX_NUMBER 24     // characters of a typed number
+
+enum class mismatch_type : uint8_t
+{
+  rounding,
+  overflow,
+  percent,
+  equals,
+  error,
+  count
+};
+
+static const char *mismatchNames[] = {"rounding", "overflow", "percent", "equals", "error"};
+
+typedef struct
+{
+  bool isNumber;
+  operation op;
+  char number[VERIFY_MAX_NUMBER];
+} VERIFY_KEY;
+
+typedef struct
+{
+  uint64_t caseNumber;
+  uint16_t key;
+  mismatch_type type;
+} MISMATCH;
+
+// per worker, no shared cache lines while counting
+typedef struct alignas(64)
+{
+  uint64_t keys;
+  uint64_t wide;
+  uint64_t mismatches[(int)mismatch_type::count];
+} WORKER_STATS;
+
+// operation names, also accepted in the edge case list
+typedef struct
+{
+  operation op;
+  const char *name;
+} OPERATION_NAME;
+
+static const OPERATION_NAME operationNames[] = {
+    {operation::addition, "+"}, {operation::subtraction, "-"}, {operation::multiplication, "*"},
+    {operation::division, "/"}, {operation::percent, "%"}, {operation::equals, "="},
+    {operation::switchsign, "+/-"}, {operation::inv, "1/x"}, {operation::factorial, "n!"},
+    {operation::euler, "e"}, {operation::pi, "pi"}, {operation::memclear, "mc"},
+    {operation::memread, "mr"}, {operation::memstore, "ms"}, {operation::memaddition, "m+"},
+    {operation::memsubtraction, "m-"}, {operation::clear, "c"}, {operation::allclear, "ac"}};
+
+// the known traps, one case each
+static const char *edgeCases[] = {
+    "1 / 3 * 3 =",
+    "2 / 3 =",
+    "1 / 3 = = =",
+    "0.0000000000001 / 2 =",
+    "99999999999995 / 10000000000000 =",
+    "0.99999999999995 =",
+    "99999999999999 + 1 =",
+    "99999999999999 + 0.4 =",
+    "99999999999999 + 0.00000000000001 =",
+    "99999999999999 +/- - 1 =",
+    "99999999999999 * 99999999999999 =",
+    "99999999999999 * 1.0000000000001 =",
+    "99999999999999 ms m+ mr",
+    "50 + 10 %",
+    "50 + 10 % =",
+    "50 - 10 % =",
+    "50 * 10 % =",
+    "50 / 10 % =",
+    "200 % %",
+    "10 + 5 % % % =",
+    "3 = %",
+    "2 * = = = =",
+    "5 + = = =",
+    "3 - 1 = = = =",
+    "2 * 3 = 4 =",
+    "7 = =",
+    "9 + 1 = * =",
+    "1.5 * 1.5 = = = = = = =",
+    "0 1/x",
+    "10 / 0 =",
+    "5 / 0 = ac 2 + 2 =",
+    "16 n!",
+    "17 n!",
+    "3.5 n!",
+    "21 n!",
+    "5 +/- n!",
+    "e * pi =",
+    "pi 1/x 1/x",
+    "12345678901234 ms m+ m+ mr",
+    "0.1 + 0.2 =",
+    "1 - 0.9 - 0.1 =",
+    "1 / 7 * 7 =",
+    "1 / 3000 =",
+    "1 / 300 =",
+    "0.0000001 * 0.0000001 =",
+    "1 / 0.0000000000001 = = = = = = = = =",
+    "99999999999999 * = = = = = = =",
+    "0.0000000000001 * = = = = = = = =",
+    "99999999999999.5 + 0 =",
+    "69 n!",
+    "70 n!",
+    "999999999.995 * 10000000000000 = = = = = = =",
+    "999999999.99499 * 10000000000000 = = = = = = =",
+    "999999999.99499 * 10000000000000 = = = = = = = ms m+",
+    "999999999.99499 * 10000000000000 = = = = = = = + 99999999999999 %",
+    "0.0000000000001 * = = = = = = % % % % %"};
+
+// numbers near the limits, ties and the usual suspects
+static const char *edgeNumbers[] = {
+    "0", "1", "2", "3", "7", "9", "10", "100", "0.5", "0.1", "0.01", "0.3", "1.5",
+    "99999999999999", "99999999999998", "50000000000000", "9999999", "33333333333333",
+    "12345678901234", "0.0000000000001", "0.0000000000005", "0.99999999999995",
+    "9.9999999999995", "1.0000000000001", "0.00000001", "4.5", "2.5", "1000000"};
+
+// random operations, the basic ones much more often
+static const operation randomOperations[] = {
+    operation::addition, operation::addition, operation::addition, operation::addition,
+    operation::subtraction, operation::subtraction, operation::subtraction, operation::subtraction,
+    operation::multiplication, operation::multiplication, operation::multiplication, operation::multiplication,
+    operation::division, operation::division, operation::division, operation::division,
+    operation::equals, operation::equals, operation::equals, operation::equals, operation::equals,
+    operation::percent, operation::percent, operation::percent,
+    operation::switchsign, operation::inv, operation::factorial,
+    operation::euler, operation::pi, operation::memclear, operation::memread, operation::memstore,
+    operation::memaddition, operation::memsubtraction, operation::clear, operation::allclear};
+
+static uint64_t caseCount = VERIFY_DEFAULT_CASES;
+static uint64_t seed = VERIFY_DEFAULT_SEED;
+static uint32_t maxLength = VERIFY_DEFAULT_LENGTH;
+static uint32_t reportLimit = VERIFY_DEFAULT_REPORT;
+
+static std::mutex mismatchLock;
+static std::vector<MISMATCH> mismatches;
+
+// splitmix64, every case gets its own independent stream
+static uint64_t nextRandom(uint64_t *state)
+{
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return (z ^ (z >> 31));
+}
+
+static const char *getOperationName(operation op)
+{
+  for (const OPERATION_NAME &name : operationNames)
+  {
+    if (name.op == op)
+    {
+      return (name.name);
+    }
+  }
+  return ("?");
+}
+
+static void addNumber(std::vector<VERIFY_KEY> *keys, const char *number)
+{
+  VERIFY_KEY key;
+  key.isNumber = true;
+  key.op = operation::none;
+  strncpy(key.number, number, sizeof(key.number) - 1);
+  key.number[sizeof(key.number) - 1] = 0;
+  keys->push_back(key);
+}
+
+static void addOperation(std::vector<VERIFY_KEY> *keys, operation op)
+{
+  VERIFY_KEY key;
+  key.isNumber = false;
+  key.op = op;
+  key.number[0] = 0;
+  keys->push_back(key);
+}
+
+static void parseEdgeCase(const char *text, std::vector<VERIFY_KEY> *keys)
+{
+  char token[VERIFY_MAX_NUMBER];
+  int length;
+
+  while (sscanf(text, " %23s%n", token, &length) == 1)
+  {
+    text += length;
+    bool found = false;
+    for (const OPERATION_NAME &name : operationNames)
+    {
+      if (strcmp(token, name.name) == 0)
+      {
+        addOperation(keys, name.op);
+        found = true;
+        break;
+      }
+    }
+    if (!found)
+    {
+      addNumber(keys, token);
+    }
+  }
+}
+
+// up to 14 digits as typed, sometimes with a decimal point
+static void randomNumber(uint64_t *state, char *number)
+{
+  uint64_t random = nextRandom(state);
+  if (random % 3 == 0)
+  {
+    strcpy(number, edgeNumbers[(random >> 8) % (sizeof(edgeNumbers) / sizeof(edgeNumbers[0]))]);
+    return;
+  }
+  uint8_t digits = 1 + (random >> 8) % VERIFY_DIGITS;
+  uint8_t point = (random >> 16) % (2 * digits);
+  uint8_t length = 0;
+  for (uint8_t i = 0; i < digits; i++)
+  {
+    if ((i == point) && (i > 0))
+    {
+      number[length++] = '.';
+    }
+    number[length++] = '0' + nextRandom(state) % 10;
+  }
+  number[length] = 0;
+}
+
+static void buildCase(uint64_t caseNumber, std::vector<VERIFY_KEY> *keys)
+{
+  keys->clear();
+  if (caseNumber < sizeof(edgeCases) / sizeof(edgeCases[0]))
+  {
+    parseEdgeCase(edgeCases[caseNumber], keys);
+    return;
+  }
+  uint64_t state = seed ^ (caseNumber * 0xD1B54A32D192ED03ULL);
+  uint32_t length = 1 + nextRandom(&state) % maxLength;
+  bool lastNumber = false;
+  char number[VERIFY_MAX_NUMBER];
+
+  for (uint32_t i = 0; i < length; i++)
+  {
+    uint64_t random = nextRandom(&state);
+    if (!lastNumber && (random % 100 < 60))
+    {
+      randomNumber(&state, number);
+      addNumber(keys, number);
+      lastNumber = true;
+    }
+    else
+    {
+      addOperation(keys, randomOperations[(random >> 8) % (sizeof(randomOperations) / sizeof(randomOperations[0]))]);
+      lastNumber = false;
+    }
+  }
+}
+
+// what the display shows, "error" for any error state
+static void getEngineDisplay(NixieCalc *engine, char *buffer, uint8_t size)
+{
+  if (engine->getOperationReturnCode() == operation_return_code::success)
+  {
+    NumberFormatter::format(engine->getDisplayNumber(), VERIFY_DIGITS, buffer, size);
+  }
+  else
+  {
+    snprintf(buffer, size, "error %d", (int)engine->getOperationReturnCode());
+  }
+}
+
+static void getReferenceDisplay(ReferenceCalc *reference, char *buffer, uint8_t size)
+{
+  if (reference->getOperationReturnCode() == operation_return_code::success)
+  {
+    reference->format(VERIFY_DIGITS, buffer, size);
+  }
+  else
+  {
+    snprintf(buffer, size, "error %d", (int)reference->getOperationReturnCode());
+  }
+}
+
+// more digits than the display has, percent and memory recall don't check the range,
+// only the digit count of such a number is compared, both sides are far beyond the precision
+static bool isTooWide(char *text)
+{
+  uint8_t digits = 0;
+  for (const char *c = text; *c; c++)
+  {
+    if ((*c >= '0') && (*c <= '9'))
+    {
+      digits++;
+    }
+  }
+  if (digits > VERIFY_DIGITS)
+  {
+    snprintf(text, VERIFY_MAX_NUMBER, "%d digits", digits);
+    return (true);
+  }
+  return (false);
+}
+
+static mismatch_type classify(const VERIFY_KEY &key, NixieCalc *engine, ReferenceCalc *reference)
+{
+  if ((engine->getOperationReturnCode() == operation_return_code::overflow) ||
+      (reference->getOperationReturnCode() == operation_return_code::overflow))
+  {
+    return (mismatch_type::overflow);
+  }
+  if (engine->getOperationReturnCode() != reference->getOperationReturnCode())
+  {
+    return (mismatch_type::error);
+  }
+  if (!key.isNumber && (key.op == operation::percent))
+  {
+    return (mismatch_type::percent);
+  }
+  if (!key.isNumber && (key.op == operation::equals))
+  {
+    return (mismatch_type::equals);
+  }
+  return (mismatch_type::rounding);
+}
+
+// feeds the keys to both, returns the first key with different displays or -1,
+// wide is set when a display was too wide, with trace every key is printed
+static int runCase(const std::vector<VERIFY_KEY> &keys, mismatch_type *type, bool *wide, bool trace)
+{
+  NixieCalc engine;
+  ReferenceCalc reference;
+  char engineDisplay[32];
+  char referenceDisplay[32];
+
+  for (size_t i = 0; i < keys.size(); i++)
+  {
+    if (keys[i].isNumber)
+    {
+      engine.onNumericInput(keys[i].number);
+      reference.onNumericInput(keys[i].number);
+    }
+    else
+    {
+      engine.onOperation(keys[i].op);
+      reference.onOperation(keys[i].op);
+    }
+    getEngineDisplay(&engine, engineDisplay, sizeof(engineDisplay));
+    getReferenceDisplay(&reference, referenceDisplay, sizeof(referenceDisplay));
+    if (isTooWide(engineDisplay) | isTooWide(referenceDisplay))
+    {
+      *wide = true;
+    }
+    bool same = (strcmp(engineDisplay, referenceDisplay) == 0);
+    if (trace)
+    {
+      Serial.printf("%-16s %-20s %-20s%s\r\n", keys[i].isNumber ? keys[i].number : getOperationName(keys[i].op),
+                    engineDisplay, referenceDisplay, same ? "" : " <<");
+    }
+    if (!same)
+    {
+      *type = classify(keys[i], &engine, &reference);
+      return (i);
+    }
+  }
+  return (-1);
+}
+
+static void printKeys(const std::vector<VERIFY_KEY> &keys, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    Serial.printf("%s ", keys[i].isNumber ? keys[i].number : getOperationName(keys[i].op));
+  }
+}
+
+static void printUsage()
+{
+  Serial.printf("usage: verifier [--cases n] [--seed n] [--threads n] [--length n] [--report n] [--case n]\r\n");
+}
+
+int main(int argc, char *argv[])
+{
+  uint32_t threads = 0;
+  bool single = false;
+  uint64_t singleCase = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if ((i + 1 < argc) && (strcmp(argv[i], "--cases") == 0))
+    {
+      caseCount = strtoull(argv[++i], nullptr, 0);
+    }
+    else if ((i + 1 < argc) && (strcmp(argv[i], "--seed") == 0))
+    {
+      seed = strtoull(argv[++i], nullptr, 0);
+    }
+    else if ((i + 1 < argc) && (strcmp(argv[i], "--threads") == 0))
+    {
+      threads = strtoul(argv[++i], nullptr, 0);
+    }
+    else if ((i + 1 < argc) && (strcmp(argv[i], "--length") == 0))
+    {
+      maxLength = strtoul(argv[++i], nullptr, 0);
+    }
+    else if ((i + 1 < argc) && (strcmp(argv[i], "--report") == 0))
+    {
+      reportLimit = strtoul(argv[++i], nullptr, 0);
+    }
+    else if ((i + 1 < argc) && (strcmp(argv[i], "--case") == 0))
+    {
+      single = true;
+      singleCase = strtoull(argv[++i], nullptr, 0);
+    }
+    else
+    {
+      printUsage();
+      return (2);
+    }
+  }
+  if (maxLength == 0)
+  {
+    maxLength = 1;
+  }
+
+  std::vector<VERIFY_KEY> keys;
+  mismatch_type type;
+
+  if (single)
+  {
+    // replay of one case, every key with both displays
+    buildCase(singleCase, &keys);
+    Serial.printf("%-16s %-20s %-20s\r\n", "key", "engine", "reference");
+    bool wide = false;
+    return ((runCase(keys, &type, &wide, true) < 0) ? 0 : 1);
+  }
+
+  WorkStealingPool pool(threads);
+  std::vector<WORKER_STATS> stats(pool.getWorkers());
+  unsigned long start = micros();
+
+  Serial.printf("verifying %llu cases on %u threads, seed 0x%llx\r\n", (unsigned long long)caseCount,
+                pool.getWorkers(), (unsigned long long)seed);
+  pool.run(
+      0, caseCount, VERIFY_CHUNK,
+      [&stats](uint32_t worker, uint64_t first, uint64_t count)
+      {
+        std::vector<VERIFY_KEY> caseKeys;
+        mismatch_type caseType;
+        WORKER_STATS &workerStats = stats[worker];
+        for (uint64_t caseNumber = first; caseNumber < first + count; caseNumber++)
+        {
+          buildCase(caseNumber, &caseKeys);
+          bool wide = false;
+          int key = runCase(caseKeys, &caseType, &wide, false);
+          workerStats.keys += caseKeys.size();
+          workerStats.wide += wide ? 1 : 0;
+          if (key >= 0)
+          {
+            workerStats.mismatches[(int)caseType]++;
+            std::lock_guard<std::mutex> lock(mismatchLock);
+            if (mismatches.size() < reportLimit)
+            {
+              mismatches.push_back({caseNumber, (uint16_t)key, caseType});
+            }
+          }
+        }
+      },
+      [start](uint64_t done)
+      {
+        double seconds = (micros() - start) / 1000000.0;
+        Serial.printf("%llu cases, %.0f cases/s\r\n", (unsigned long long)done, done / seconds);
+      });
+  double seconds = (micros() - start) / 1000000.0;
+
+  // details of the first mismatches, in case order
+  std::sort(mismatches.begin(), mismatches.end(),
+            [](const MISMATCH &left, const MISMATCH &right) { return (left.caseNumber < right.caseNumber); });
+  for (const MISMATCH &mismatch : mismatches)
+  {
+    char engineDisplay[32];
+    char referenceDisplay[32];
+    NixieCalc engine;
+    ReferenceCalc reference;
+
+    buildCase(mismatch.caseNumber, &keys);
+    for (size_t i = 0; i <= mismatch.key; i++)
+    {
+      if (keys[i].isNumber)
+      {
+        engine.onNumericInput(keys[i].number);
+        reference.onNumericInput(keys[i].number);
+      }
+      else
+      {
+        engine.onOperation(keys[i].op);
+        reference.onOperation(keys[i].op);
+      }
+    }
+    getEngineDisplay(&engine, engineDisplay, sizeof(engineDisplay));
+    getReferenceDisplay(&reference, referenceDisplay, sizeof(referenceDisplay));
+    isTooWide(engineDisplay);
+    isTooWide(referenceDisplay);
+    Serial.printf("case %llu, %s: ", (unsigned long long)mismatch.caseNumber, mismatchNames[(int)mismatch.type]);
+    printKeys(keys, mismatch.key + 1);
+    Serial.printf("-> engine %s, exact %s\r\n", engineDisplay, referenceDisplay);
+  }
+
+  uint64_t totalKeys = 0;
+  uint64_t totalWide = 0;
+  uint64_t totalMismatches = 0;
+  uint64_t counts[(int)mismatch_type::count] = {};
+  for (const WORKER_STATS &workerStats : stats)
+  {
+    totalKeys += workerStats.keys;
+    totalWide += workerStats.wide;
+    for (int i = 0; i < (int)mismatch_type::count; i++)
+    {
+      counts[i] += workerStats.mismatches[i];
+      totalMismatches += workerStats.mismatches[i];
+    }
+  }
+  Serial.printf("%llu cases, %llu keys in %.1f s, %.0f cases/s, %.0f keys/s, %llu steals\r\n",
+                (unsigned long long)caseCount, (unsigned long long)totalKeys, seconds, caseCount / seconds,
+                totalKeys / seconds, (unsigned long long)pool.getSteals());
+  Serial.printf("%llu cases with more than %d digits on the display\r\n", (unsigned long long)totalWide, VERIFY_DIGITS);
+  Serial.printf("%llu mismatches:", (unsigned long long)totalMismatches);
+  for (int i = 0; i < (int)mismatch_type::count; i++)
+  {
+    Serial.printf(" %s %llu", mismatchNames[i], (unsigned long long)counts[i]);
+  }
+  Serial.printf("\r\n");
+  if (totalMismatches != 0)
+  {
+    Serial.printf("verification failed\r\n");
+    return (1);
+  }
+  Serial.printf("verification passed\r\n");
+  return (0);
+}
@@ -0,0 +1,507 @@
+// ExactNumber.h
+
+// exact rational numbers for the reference calculator of the verifier,
+// numerator and denominator are arbitrary precision natural numbers,
+// every sum, difference, product and quotient is exact, nothing rounds
+// until the value is formatted for the display or rounded to the
+// precision of the engine
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// natural number, 32-bit limbs, least significant first, no leading zero limbs
+class BigNatural
+{
+public:
+  BigNatural() {}
+
+  BigNatural(uint64_t value)
+  {
+    while (value != 0)
+    {
+      _limbs.push_back((uint32_t)value);
+      value >>= 32;
+    }
+  }
+
+  bool isZero() const
+  {
+    return (_limbs.empty());
+  }
+
+  // the low 64 bits
+  uint64_t toUInt64() const
+  {
+    uint64_t value = 0;
+    if (_limbs.size() > 0)
+    {
+      value = _limbs[0];
+    }
+    if (_limbs.size() > 1)
+    {
+      value |= (uint64_t)_limbs[1] << 32;
+    }
+    return (value);
+  }
+
+  bool fitsUInt64() const
+  {
+    return (_limbs.size() <= 2);
+  }
+
+  uint32_t getBitLength() const
+  {
+    return (_limbs.empty() ? 0 : (32 * _limbs.size() - __builtin_clz(_limbs.back())));
+  }
+
+  static int compare(const BigNatural &left, const BigNatural &right)
+  {
+    if (left._limbs.size() != right._limbs.size())
+    {
+      return ((left._limbs.size() < right._limbs.size()) ? -1 : 1);
+    }
+    for (size_t i = left._limbs.size(); i > 0; i--)
+    {
+      if (left._limbs[i - 1] != right._limbs[i - 1])
+      {
+        return ((left._limbs[i - 1] < right._limbs[i - 1]) ? -1 : 1);
+      }
+    }
+    return (0);
+  }
+
+  static BigNatural add(const BigNatural &left, const BigNatural &right)
+  {
+    const BigNatural &longer = (left._limbs.size() >= right._limbs.size()) ? left : right;
+    const BigNatural &shorter = (left._limbs.size() >= right._limbs.size()) ? right : left;
+    BigNatural result;
+    uint64_t carry = 0;
+
+    result._limbs.resize(longer._limbs.size());
+    for (size_t i = 0; i < longer._limbs.size(); i++)
+    {
+      uint64_t sum = (uint64_t)longer._limbs[i] + carry;
+      if (i < shorter._limbs.size())
+      {
+        sum += shorter._limbs[i];
+      }
+      result._limbs[i] = (uint32_t)sum;
+      carry = sum >> 32;
+    }
+    if (carry != 0)
+    {
+      result._limbs.push_back((uint32_t)carry);
+    }
+    return (result);
+  }
+
+  // left must not be smaller than right
+  static BigNatural subtract(const BigNatural &left, const BigNatural &right)
+  {
+    BigNatural result;
+    int64_t borrow = 0;
+
+    result._limbs.resize(left._limbs.size());
+    for (size_t i = 0; i < left._limbs.size(); i++)
+    {
+      int64_t difference = (int64_t)left._limbs[i] - borrow;
+      if (i < right._limbs.size())
+      {
+        difference -= right._limbs[i];
+      }
+      result._limbs[i] = (uint32_t)difference;
+      borrow = (difference < 0) ? 1 : 0;
+    }
+    result.trim();
+    return (result);
+  }
+
+  static BigNatural multiply(const BigNatural &left, const BigNatural &right)
+  {
+    BigNatural result;
+    if (left.isZero() || right.isZero())
+    {
+      return (result);
+    }
+    result._limbs.assign(left._limbs.size() + right._limbs.size(), 0);
+    for (size_t i = 0; i < left._limbs.size(); i++)
+    {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < right._limbs.size(); j++)
+      {
+        uint64_t product = (uint64_t)left._limbs[i] * right._limbs[j] + result._limbs[i + j] + carry;
+        result._limbs[i + j] = (uint32_t)product;
+        carry = product >> 32;
+      }
+      result._limbs[i + right._limbs.size()] = (uint32_t)carry;
+    }
+    result.trim();
+    return (result);
+  }
+
+  // quotient and remainder, Knuth's algorithm D, the divisor must not be zero
+  static void divide(const BigNatural &dividend, const BigNatural &divisor, BigNatural *quotient, BigNatural *remainder)
+  {
+    if (compare(dividend, divisor) < 0)
+    {
+      *remainder = dividend;
+      *quotient = BigNatural();
+      return;
+    }
+    if (divisor._limbs.size() == 1)
+    {
+      uint64_t rest = 0;
+      BigNatural result;
+      result._limbs.resize(dividend._limbs.size());
+      for (size_t i = dividend._limbs.size(); i > 0; i--)
+      {
+        uint64_t part = (rest << 32) | dividend._limbs[i - 1];
+        result._limbs[i - 1] = (uint32_t)(part / divisor._limbs[0]);
+        rest = part % divisor._limbs[0];
+      }
+      result.trim();
+      *quotient = result;
+      *remainder = BigNatural(rest);
+      return;
+    }
+
+    // normalize, the top bit of the divisor set
+    size_t n = divisor._limbs.size();
+    size_t m = dividend._limbs.size() - n;
+    int shift = __builtin_clz(divisor._limbs[n - 1]);
+    std::vector<uint32_t> v = shiftLeft(divisor._limbs, shift, n);
+    std::vector<uint32_t> u = shiftLeft(dividend._limbs, shift, dividend._limbs.size() + 1);
+    BigNatural result;
+    result._limbs.assign(m + 1, 0);
+
+    for (size_t j = m + 1; j > 0; j--)
+    {
+      size_t k = j - 1;
+      uint64_t top = ((uint64_t)u[k + n] << 32) | u[k + n - 1];
+      uint64_t estimate = top / v[n - 1];
+      uint64_t rest = top % v[n - 1];
+      while ((estimate >> 32) || (estimate * v[n - 2] > ((rest << 32) | u[k + n - 2])))
+      {
+        estimate--;
+        rest += v[n - 1];
+        if (rest >> 32)
+        {
+          break;
+        }
+      }
+      // u -= estimate * v
+      int64_t borrow = 0;
+      uint64_t carry = 0;
+      for (size_t i = 0; i < n; i++)
+      {
+        uint64_t product = estimate * v[i] + carry;
+        carry = product >> 32;
+        int64_t difference = (int64_t)u[i + k] - (int64_t)(product & 0xFFFFFFFF) - borrow;
+        u[i + k] = (uint32_t)difference;
+        borrow = (difference < 0) ? 1 : 0;
+      }
+      int64_t difference = (int64_t)u[k + n] - (int64_t)carry - borrow;
+      u[k + n] = (uint32_t)difference;
+      if (difference < 0)
+      {
+        // the estimate was one too large, add back
+        estimate--;
+        carry = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+          uint64_t sum = (uint64_t)u[i + k] + v[i] + carry;
+          u[i + k] = (uint32_t)sum;
+          carry = sum >> 32;
+        }
+        u[k + n] += (uint32_t)carry;
+      }
+      result._limbs[k] = (uint32_t)estimate;
+    }
+    result.trim();
+    *quotient = result;
+
+    // the remainder is in the low limbs of u, still shifted
+    remainder->_limbs.assign(n, 0);
+    for (size_t i = 0; i < n; i++)
+    {
+      remainder->_limbs[i] = (shift == 0) ? u[i] : ((u[i] >> shift) | (uint32_t)((uint64_t)u[i + 1] << (32 - shift)));
+    }
+    remainder->trim();
+  }
+
+  static BigNatural gcd(BigNatural left, BigNatural right)
+  {
+    BigNatural quotient;
+    BigNatural remainder;
+    while (!right.isZero())
+    {
+      divide(left, right, &quotient, &remainder);
+      left = right;
+      right = remainder;
+    }
+    return (left);
+  }
+
+  static BigNatural powerOfTen(unsigned int exponent)
+  {
+    BigNatural result(1);
+    for (; exponent >= 19; exponent -= 19)
+    {
+      result = multiply(result, BigNatural(10000000000000000000ULL));
+    }
+    uint64_t rest = 1;
+    while (exponent-- > 0)
+    {
+      rest *= 10;
+    }
+    return (multiply(result, BigNatural(rest)));
+  }
+
+private:
+  std::vector<uint32_t> _limbs;
+
+  void trim()
+  {
+    while (!_limbs.empty() && (_limbs.back() == 0))
+    {
+      _limbs.pop_back();
+    }
+  }
+
+  static std::vector<uint32_t> shiftLeft(const std::vector<uint32_t> &limbs, int shift, size_t size)
+  {
+    std::vector<uint32_t> result(size, 0);
+    uint32_t carry = 0;
+    for (size_t i = 0; i < limbs.size(); i++)
+    {
+      result[i] = (shift == 0) ? limbs[i] : ((limbs[i] << shift) | carry);
+      carry = (shift == 0) ? 0 : (limbs[i] >> (32 - shift));
+    }
+    if (limbs.size() < size)
+    {
+      result[limbs.size()] = carry;
+    }
+    return (result);
+  }
+};
+
+// value = (-1)^negative * numerator / denominator, always reduced,
+// the denominator is positive, zero has no sign
+class ExactNumber
+{
+public:
+  ExactNumber() : _negative(false), _numerator(0), _denominator(1) {}
+
+  ExactNumber(long long value) : _negative(value < 0), _numerator((value < 0) ? -(uint64_t)value : (uint64_t)value), _denominator(1) {}
+
+  // parses a number as typed, like "-123.456"
+  static ExactNumber fromString(const char *s)
+  {
+    bool negative = false;
+    bool decimalPoint = false;
+    uint8_t decimals = 0;
+    BigNatural numerator;
+
+    if ((*s == '-') || (*s == '+'))
+    {
+      negative = (*s == '-');
+      s++;
+    }
+    for (; *s; s++)
+    {
+      if ((*s >= '0') && (*s <= '9'))
+      {
+        numerator = BigNatural::add(BigNatural::multiply(numerator, BigNatural(10)), BigNatural(*s - '0'));
+        if (decimalPoint)
+        {
+          decimals++;
+        }
+      }
+      else if (*s == '.')
+      {
+        decimalPoint = true;
+      }
+    }
+    return (ExactNumber(negative, numerator, BigNatural::powerOfTen(decimals)));
+  }
+
+  bool isZero() const
+  {
+    return (_numerator.isZero());
+  }
+
+  bool isNegative() const
+  {
+    return (_negative);
+  }
+
+  bool isInteger() const
+  {
+    return (BigNatural::compare(_denominator, BigNatural(1)) == 0);
+  }
+
+  // only for integers that fit
+  uint64_t toUInt64() const
+  {
+    return (_numerator.toUInt64());
+  }
+
+  ExactNumber operator-() const
+  {
+    return (ExactNumber(!_negative, _numerator, _denominator, false));
+  }
+
+  ExactNumber operator+(const ExactNumber &other) const
+  {
+    return (addition(*this, other, false));
+  }
+
+  ExactNumber operator-(const ExactNumber &other) const
+  {
+    return (addition(*this, other, true));
+  }
+
+  ExactNumber operator*(const ExactNumber &other) const
+  {
+    return (ExactNumber(_negative != other._negative, BigNatural::multiply(_numerator, other._numerator),
+                        BigNatural::multiply(_denominator, other._denominator)));
+  }
+
+  // the divisor must not be zero
+  ExactNumber operator/(const ExactNumber &other) const
+  {
+    return (ExactNumber(_negative != other._negative, BigNatural::multiply(_numerator, other._denominator),
+                        BigNatural::multiply(_denominator, other._numerator)));
+  }
+
+  static int compare(const ExactNumber &left, const ExactNumber &right)
+  {
+    if (left._negative != right._negative)
+    {
+      return (left._negative ? -1 : 1);
+    }
+    int magnitude = BigNatural::compare(BigNatural::multiply(left._numerator, right._denominator),
+                                        BigNatural::multiply(right._numerator, left._denominator));
+    return (left._negative ? -magnitude : magnitude);
+  }
+
+  // |value| as integer part and fraction numerator, fraction = rest / denominator
+  void split(BigNatural *integer, BigNatural *rest) const
+  {
+    BigNatural::divide(_numerator, _denominator, integer, rest);
+  }
+
+  // round(|value| * 10^decimals), half up, decimals can be negative
+  BigNatural scaleAndRound(int decimals) const
+  {
+    BigNatural quotient;
+    BigNatural remainder;
+    BigNatural numerator = _numerator;
+    BigNatural denominator = _denominator;
+    if (decimals >= 0)
+    {
+      numerator = BigNatural::multiply(numerator, BigNatural::powerOfTen(decimals));
+    }
+    else
+    {
+      denominator = BigNatural::multiply(denominator, BigNatural::powerOfTen(-decimals));
+    }
+    BigNatural::divide(numerator, denominator, &quotient, &remainder);
+    if (BigNatural::compare(BigNatural::add(remainder, remainder), denominator) >= 0)
+    {
+      quotient = BigNatural::add(quotient, BigNatural(1));
+    }
+    return (quotient);
+  }
+
+  // rounded half up to digits significant digits
+  ExactNumber roundSignificant(uint8_t digits) const
+  {
+    if (isZero())
+    {
+      return (*this);
+    }
+    int decimals = digits - 1 - getDecimalExponent();
+    BigNatural value = scaleAndRound(decimals);
+    if (decimals >= 0)
+    {
+      return (ExactNumber(_negative, value, BigNatural::powerOfTen(decimals)));
+    }
+    return (ExactNumber(_negative, BigNatural::multiply(value, BigNatural::powerOfTen(-decimals)), BigNatural(1)));
+  }
+
+  // floor(log10(|value|)), the value must not be zero
+  int getDecimalExponent() const
+  {
+    // log10(2) estimate from the bit lengths, then exact steps
+    int exponent = ((int)_numerator.getBitLength() - (int)_denominator.getBitLength()) * 30103 / 100000;
+    while (compareMagnitude(exponent) < 0)
+    {
+      exponent--;
+    }
+    while (compareMagnitude(exponent + 1) >= 0)
+    {
+      exponent++;
+    }
+    return (exponent);
+  }
+
+  // |value| compared with 10^exponent
+  int compareMagnitude(int exponent) const
+  {
+    if (exponent >= 0)
+    {
+      return (BigNatural::compare(_numerator, BigNatural::multiply(_denominator, BigNatural::powerOfTen(exponent))));
+    }
+    return (BigNatural::compare(BigNatural::multiply(_numerator, BigNatural::powerOfTen(-exponent)), _denominator));
+  }
+
+private:
+  bool _negative;
+  BigNatural _numerator;
+  BigNatural _denominator;
+
+  ExactNumber(bool negative, const BigNatural &numerator, const BigNatural &denominator, bool reduce = true)
+      : _negative(negative), _numerator(numerator), _denominator(denominator)
+  {
+    if (reduce && !_numerator.isZero())
+    {
+      BigNatural divisor = BigNatural::gcd(_numerator, _denominator);
+      if (BigNatural::compare(divisor, BigNatural(1)) != 0)
+      {
+        BigNatural rest;
+        BigNatural::divide(_numerator, divisor, &_numerator, &rest);
+        BigNatural::divide(_denominator, divisor, &_denominator, &rest);
+      }
+    }
+    if (_numerator.isZero())
+    {
+      _negative = false;
+      _denominator = BigNatural(1);
+    }
+  }
+
+  static ExactNumber addition(const ExactNumber &left, const ExactNumber &right, bool subtract)
+  {
+    bool rightNegative = (right._negative != subtract);
+    BigNatural leftPart = BigNatural::multiply(left._numerator, right._denominator);
+    BigNatural rightPart = BigNatural::multiply(right._numerator, left._denominator);
+    BigNatural denominator = BigNatural::multiply(left._denominator, right._denominator);
+
+    if (left._negative == rightNegative)
+    {
+      return (ExactNumber(left._negative, BigNatural::add(leftPart, rightPart), denominator));
+    }
+    if (BigNatural::compare(leftPart, rightPart) >= 0)
+    {
+      return (ExactNumber(left._negative, BigNatural::subtract(leftPart, rightPart), denominator));
+    }
+    return (ExactNumber(rightNegative, BigNatural::subtract(rightPart, leftPart), denominator));
+  }
+};
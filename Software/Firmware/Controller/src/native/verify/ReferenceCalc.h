@@ -0,0 +1,467 @@
+// ReferenceCalc.h
+
+// reference model of the NixieCalc state machine with exact numbers,
+// the same rules for chained operations, percent, repeated equals,
+// memory and errors, every result is kept with the 18 digits of the
+// decimal engine, but the display rounds the exact result of the
+// last operation once, never the 18 digits,
+// only the operations with an exact result are modeled:
+// + - * / % = +/- 1/x n! e pi, memory and clear
+// the display format follows NumberFormatter, fixed notation as long
+// as no significant digit is lost, scientific notation otherwise
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <NixieCalc.h>
+#include <NumberFormatter.h>
+#include "ExactNumber.h"
+
+class ReferenceCalc
+{
+public:
+  ReferenceCalc()
+  {
+    setMemory(0);
+    onAllClear();
+  }
+
+  void onNumericInput(const char *value)
+  {
+    ExactNumber exact = ExactNumber::fromString(value);
+    onNumberInput(exact.roundSignificant(DECIMAL_PRECISION), exact);
+  }
+
+  void onOperation(operation op)
+  {
+    if (_operationReturnCode == operation_return_code::success)
+    {
+      switch (op)
+      {
+      case operation::addition:
+      case operation::subtraction:
+      case operation::multiplication:
+      case operation::division:
+        onDualValueOperation(op);
+        break;
+      case operation::inv:
+      case operation::switchsign:
+      case operation::factorial:
+        onSingleValueOperation(op);
+        break;
+      case operation::memclear:
+        setMemory(0);
+        break;
+      case operation::memread:
+        onNumberInput(_memoryValue, _memoryExact);
+        break;
+      case operation::memstore:
+        _memoryValue = _displayValue;
+        _memoryExact = _displayExact;
+        break;
+      case operation::memaddition:
+      case operation::memsubtraction:
+      {
+        ExactNumber value = (op == operation::memaddition) ? _memoryValue + _displayValue : _memoryValue - _displayValue;
+        if (limitRange(&value))
+        {
+          setMemory(value);
+        }
+        else
+        {
+          _operationReturnCode = operation_return_code::overflow;
+          setDisplay(0);
+        }
+        break;
+      }
+      case operation::euler:
+        onNumericInput(EULER_DIGITS);
+        break;
+      case operation::pi:
+        onNumericInput(PI_DIGITS);
+        break;
+      case operation::allclear:
+        onAllClear();
+        break;
+      case operation::clear:
+        setDisplay(0);
+        break;
+      case operation::percent:
+        onPercentOperation();
+        break;
+      case operation::equals:
+        onEqualsOperation();
+        break;
+      default:
+        break;
+      }
+    }
+    else if (op == operation::allclear)
+    {
+      onAllClear();
+    }
+  }
+
+  operation_return_code getOperationReturnCode()
+  {
+    return (_operationReturnCode);
+  }
+
+  // the exact value rounded half up to the display,
+  // the integer part always shown, trailing zeros removed, no "-0",
+  // scientific notation when fixed notation would lose digits
+  void format(uint8_t digitCount, char *buffer, uint8_t size)
+  {
+    uint8_t mantissaDigits = digitCount - FORMAT_EXPONENT_DIGITS - 1;
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int scientificExponent = 0;
+    bool negative = _displayExact.isNegative();
+
+    if (!_displayExact.isZero())
+    {
+      exponent = _displayExact.getDecimalExponent();
+      scientificExponent = exponent;
+      mantissa = _displayExact.scaleAndRound(mantissaDigits - 1 - exponent).toUInt64();
+      if (mantissa == powerOfTen(mantissaDigits))
+      {
+        mantissa /= 10;
+        scientificExponent++;
+      }
+      // on the exponent after the rounding, like 0.0000000000001
+      // for 9.99999999999999999e-14
+      bool fixed = (scientificExponent < digitCount);
+      if (scientificExponent < 0)
+      {
+        uint64_t rest = mantissa;
+        int significantDigits = mantissaDigits;
+        while ((significantDigits > 1) && (rest % 10 == 0))
+        {
+          rest /= 10;
+          significantDigits--;
+        }
+        fixed = (significantDigits <= digitCount + scientificExponent);
+      }
+      if (!fixed)
+      {
+        composeScientific(negative, mantissa, mantissaDigits, scientificExponent, buffer, size);
+        return;
+      }
+    }
+
+    uint8_t integerDigits = (exponent > 0) ? (exponent + 1) : 1;
+    uint8_t decimals = (integerDigits < digitCount) ? (digitCount - integerDigits) : 0;
+    uint64_t value = _displayExact.scaleAndRound(decimals).toUInt64();
+    if ((decimals == 0) && (value >= powerOfTen(digitCount)))
+    {
+      composeScientific(negative, mantissa, mantissaDigits, scientificExponent, buffer, size);
+      return;
+    }
+    compose(negative, value, decimals, buffer, size);
+  }
+
+private:
+  // the values as the engine keeps them, the display and the memory
+  // also with the exact result they were rounded from
+  ExactNumber _displayValue;
+  ExactNumber _displayExact;
+  ExactNumber _leftValue;
+  ExactNumber _rightValue;
+  ExactNumber _memoryValue;
+  ExactNumber _memoryExact;
+  operation_return_code _operationReturnCode;
+  bool _numberEntered;
+  bool _equalsEntered;
+  operation _operation;
+
+  static uint64_t powerOfTen(uint8_t exponent)
+  {
+    uint64_t value = 1;
+    while (exponent-- > 0)
+    {
+      value *= 10;
+    }
+    return (value);
+  }
+
+  // value / 10^decimals without trailing zeros
+  static uint8_t compose(bool negative, uint64_t value, uint8_t decimals, char *buffer, uint8_t size)
+  {
+    char digits[24];
+    uint8_t count = 0;
+    uint8_t length = 0;
+
+    while ((decimals > 0) && (value % 10 == 0))
+    {
+      value /= 10;
+      decimals--;
+    }
+    do
+    {
+      digits[count++] = '0' + (value % 10);
+      value /= 10;
+    } while ((value != 0) || (count <= decimals));
+
+    if (negative && ((count > 1) || (digits[0] != '0')) && (length < size - 1))
+    {
+      buffer[length++] = '-';
+    }
+    while ((count > 0) && (length < size - 1))
+    {
+      buffer[length++] = digits[--count];
+      if ((count == decimals) && (decimals > 0) && (length < size - 1))
+      {
+        buffer[length++] = '.';
+      }
+    }
+    buffer[length] = 0;
+    return (length);
+  }
+
+  static void composeScientific(bool negative, uint64_t mantissa, uint8_t mantissaDigits, int exponent, char *buffer, uint8_t size)
+  {
+    if (exponent > FORMAT_MAX_EXPONENT)
+    {
+      buffer[0] = 0;
+      return;
+    }
+    uint8_t length = compose(negative, mantissa, mantissaDigits - 1, buffer, size);
+    snprintf(buffer + length, size - length, "%c%s%02d", FORMAT_EXPONENT_MARK, (exponent < 0) ? "-" : "", abs(exponent));
+  }
+
+  void setDisplay(const ExactNumber &exact)
+  {
+    _displayValue = exact.roundSignificant(DECIMAL_PRECISION);
+    _displayExact = exact;
+  }
+
+  void setMemory(const ExactNumber &exact)
+  {
+    _memoryValue = exact.roundSignificant(DECIMAL_PRECISION);
+    _memoryExact = exact;
+  }
+
+  void onAllClear()
+  {
+    _leftValue = 0;
+    _rightValue = 0;
+    setDisplay(0);
+    _operationReturnCode = operation_return_code::success;
+    _operation = operation::none;
+    _numberEntered = false;
+    _equalsEntered = false;
+  }
+
+  void onNumberInput(const ExactNumber &value, const ExactNumber &exact)
+  {
+    if (_operationReturnCode == operation_return_code::success)
+    {
+      if (_equalsEntered)
+      {
+        _equalsEntered = false;
+        _operation = operation::none;
+        _leftValue = 0;
+        _rightValue = 0;
+      }
+      _displayValue = value;
+      _displayExact = exact;
+      _numberEntered = true;
+    }
+  }
+
+  void onDualValueOperation(operation op)
+  {
+    if (_operation == operation::none)
+    {
+      _leftValue = _displayValue;
+    }
+    else if (!_numberEntered)
+    {
+      if (_equalsEntered)
+      {
+        _leftValue = _displayValue;
+      }
+    }
+    else
+    {
+      ExactNumber result;
+      _operationReturnCode = calculateValue(&result, _operation, _leftValue, _displayValue);
+      setDisplay(result);
+      _leftValue = _displayValue;
+    }
+    _operation = op;
+    _numberEntered = false;
+    _equalsEntered = false;
+  }
+
+  void onSingleValueOperation(operation op)
+  {
+    ExactNumber result;
+    _operationReturnCode = calculateValue(&result, op, _displayValue, 0);
+    if (op == operation::switchsign)
+    {
+      // the engine keeps what the rounding was, the sign doesn't change it
+      _displayValue = -_displayValue;
+      _displayExact = -_displayExact;
+    }
+    else
+    {
+      setDisplay(result);
+    }
+    if (_operation == operation::none)
+    {
+      _leftValue = _displayValue;
+    }
+  }
+
+  void onEqualsOperation()
+  {
+    if (_operation != operation::none)
+    {
+      ExactNumber result;
+      if (!_equalsEntered)
+      {
+        _operationReturnCode = calculateValue(&result, _operation, _leftValue, _displayValue);
+        _equalsEntered = true;
+        _rightValue = _displayValue;
+        setDisplay(result);
+      }
+      else
+      {
+        _operationReturnCode = calculateValue(&result, _operation, _displayValue, _rightValue);
+        _leftValue = _displayValue;
+        setDisplay(result);
+      }
+      _numberEntered = false;
+    }
+  }
+
+  void onPercentOperation()
+  {
+    if ((_operation == operation::none) || _equalsEntered)
+    {
+      ExactNumber value = _displayValue / 100;
+      limitRange(&value);
+      setDisplay(value);
+      _leftValue = _displayValue;
+      _numberEntered = false;
+      return;
+    }
+    ExactNumber value = _displayValue;
+    if ((_operation == operation::addition) || (_operation == operation::subtraction))
+    {
+      value = _leftValue * _displayValue / 100;
+    }
+    else if ((_operation == operation::multiplication) || (_operation == operation::division))
+    {
+      value = _displayValue / 100;
+    }
+    if (!limitRange(&value))
+    {
+      _operationReturnCode = operation_return_code::overflow;
+      value = 0;
+    }
+    setDisplay(value);
+  }
+
+  // from MAX_CALC_VALUE on overflow, below 1e-99 zero
+  static bool limitRange(ExactNumber *value)
+  {
+    static const ExactNumber maxValue = getMaxValue();
+
+    if (ExactNumber::compare(value->isNegative() ? -*value : *value, maxValue) >= 0)
+    {
+      return (false);
+    }
+    if (!value->isZero() && (value->compareMagnitude(-MAX_CALC_EXPONENT) < 0))
+    {
+      *value = 0;
+    }
+    return (true);
+  }
+
+  // 9.99999999995e99
+  static ExactNumber getMaxValue()
+  {
+    ExactNumber value = ExactNumber::fromString("9.99999999995");
+    for (int i = 0; i < MAX_CALC_EXPONENT; i++)
+    {
+      value = value * 10;
+    }
+    return (value);
+  }
+
+  operation_return_code calculateValue(ExactNumber *result, operation op, const ExactNumber &leftValue, const ExactNumber &rightValue)
+  {
+    operation_return_code retVal = operation_return_code::success;
+    *result = 0;
+
+    switch (op)
+    {
+    case operation::addition:
+      *result = leftValue + rightValue;
+      break;
+    case operation::subtraction:
+      *result = leftValue - rightValue;
+      break;
+    case operation::multiplication:
+      *result = leftValue * rightValue;
+      break;
+    case operation::division:
+      if (!rightValue.isZero())
+      {
+        *result = leftValue / rightValue;
+      }
+      else
+      {
+        retVal = operation_return_code::divideByZero;
+      }
+      break;
+    case operation::inv:
+      if (!leftValue.isZero())
+      {
+        *result = ExactNumber(1) / leftValue;
+      }
+      else
+      {
+        retVal = operation_return_code::divideByZero;
+      }
+      break;
+    case operation::switchsign:
+      *result = -leftValue;
+      break;
+    case operation::factorial:
+      if (ExactNumber::compare(leftValue, MAX_FACT) > 0)
+      {
+        retVal = operation_return_code::overflow;
+      }
+      else if (leftValue.isInteger() && !leftValue.isNegative())
+      {
+        *result = 1;
+        for (long long i = 2; i <= (long long)leftValue.toUInt64(); i++)
+        {
+          *result = *result * i;
+        }
+      }
+      else
+      {
+        retVal = operation_return_code::domain;
+      }
+      break;
+    default:
+      retVal = operation_return_code::unknownoperation;
+      break;
+    }
+    if ((retVal == operation_return_code::success) && !limitRange(result))
+    {
+      retVal = operation_return_code::overflow;
+    }
+    if (retVal != operation_return_code::success)
+    {
+      *result = 0;
+    }
+    return (retVal);
+  }
+};
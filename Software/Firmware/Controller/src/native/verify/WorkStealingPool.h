@@ -0,0 +1,168 @@
+// WorkStealingPool.h
+
+// runs a range of independent jobs on all CPU cores,
+// every worker starts with an equal share of the range and takes
+// chunks from its front, a worker without work steals the back half
+// of the largest range left, a few slow cases don't idle the others
+
+// Copyright (C) 2023 highvoltglow
+// Licensed under the MIT License
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool
+{
+public:
+  // runs jobs first to first + count - 1 of one chunk, on one worker
+  using Task = std::function<void(uint32_t worker, uint64_t first, uint64_t count)>;
+  using Progress = std::function<void(uint64_t done)>;
+
+  WorkStealingPool(uint32_t workers) : _steals(0)
+  {
+    if (workers == 0)
+    {
+      workers = std::thread::hardware_concurrency();
+    }
+    _ranges = std::vector<RANGE>((workers > 0) ? workers : 1);
+  }
+
+  uint32_t getWorkers()
+  {
+    return (_ranges.size());
+  }
+
+  uint64_t getSteals()
+  {
+    return (_steals);
+  }
+
+  // blocks until all jobs are done, progress is called on
+  // the calling thread every interval with the count of finished jobs
+  void run(uint64_t first, uint64_t count, uint64_t chunk, Task task,
+           Progress progress = nullptr, std::chrono::milliseconds interval = std::chrono::seconds(10))
+  {
+    std::vector<std::thread> threads;
+    uint32_t workers = _ranges.size();
+
+    _done = 0;
+    _running = workers;
+    for (uint32_t i = 0; i < workers; i++)
+    {
+      _ranges[i].begin = first + count * i / workers;
+      _ranges[i].end = first + count * (i + 1) / workers;
+    }
+    for (uint32_t i = 0; i < workers; i++)
+    {
+      threads.emplace_back([this, i, chunk, &task]() { work(i, chunk, task); });
+    }
+    {
+      std::unique_lock<std::mutex> lock(_finishedLock);
+      while (!_finished.wait_for(lock, interval, [this]() { return (_running == 0); }))
+      {
+        if (progress)
+        {
+          progress(_done);
+        }
+      }
+    }
+    for (auto &thread : threads)
+    {
+      thread.join();
+    }
+  }
+
+private:
+  // the jobs left to a worker, [begin, end)
+  typedef struct alignas(64)
+  {
+    std::mutex lock;
+    uint64_t begin;
+    uint64_t end;
+  } RANGE;
+
+  std::vector<RANGE> _ranges;
+  std::atomic<uint64_t> _done;
+  std::atomic<uint64_t> _steals;
+  std::atomic<uint32_t> _running;
+  std::mutex _finishedLock;
+  std::condition_variable _finished;
+
+  void work(uint32_t worker, uint64_t chunk, Task &task)
+  {
+    uint64_t first;
+    uint64_t count;
+    while (take(worker, chunk, &first, &count) || (steal(worker) && take(worker, chunk, &first, &count)))
+    {
+      task(worker, first, count);
+      _done += count;
+    }
+    std::lock_guard<std::mutex> lock(_finishedLock);
+    _running--;
+    _finished.notify_all();
+  }
+
+  bool take(uint32_t worker, uint64_t chunk, uint64_t *first, uint64_t *count)
+  {
+    RANGE &range = _ranges[worker];
+    std::lock_guard<std::mutex> lock(range.lock);
+    if (range.begin >= range.end)
+    {
+      return (false);
+    }
+    *first = range.begin;
+    *count = (range.end - range.begin < chunk) ? (range.end - range.begin) : chunk;
+    range.begin += *count;
+    return (true);
+  }
+
+  // moves the back half of the largest range to the worker, false when all is taken
+  bool steal(uint32_t worker)
+  {
+    while (true)
+    {
+      uint32_t victim = worker;
+      uint64_t largest = 0;
+      for (uint32_t i = 0; i < _ranges.size(); i++)
+      {
+        std::lock_guard<std::mutex> lock(_ranges[i].lock);
+        uint64_t left = _ranges[i].end - _ranges[i].begin;
+        if ((i != worker) && (_ranges[i].begin < _ranges[i].end) && (left > largest))
+        {
+          largest = left;
+          victim = i;
+        }
+      }
+      if (victim == worker)
+      {
+        return (false);
+      }
+      uint64_t begin;
+      uint64_t end;
+      {
+        std::lock_guard<std::mutex> lock(_ranges[victim].lock);
+        if (_ranges[victim].begin >= _ranges[victim].end)
+        {
+          // taken meanwhile, look again
+          continue;
+        }
+        end = _ranges[victim].end;
+        begin = end - (end - _ranges[victim].begin + 1) / 2;
+        _ranges[victim].end = begin;
+      }
+      std::lock_guard<std::mutex> lock(_ranges[worker].lock);
+      _ranges[worker].begin = begin;
+      _ranges[worker].end = end;
+      _steals++;
+      return (true);
+    }
+  }
+};